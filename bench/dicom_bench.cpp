@@ -0,0 +1,313 @@
+// Headless benchmark of the load and display pipeline on synthetic DICOM.
+// For every image profile and encoding it times the stages DicomViewer runs
+// on a slice: header read, decode (load_dicom on a slice cache miss),
+// banded windowing into the L8 staging image (apply_window_level), the
+// progressive preview, the box filter behind thumbnails and, for images
+// larger than a tile, the tile pyramid.
+// Texture upload needs a GPU and is not covered.
+
+#include "dicom_decoder.h"
+#include "downsample.h"
+#include "synthetic_dicom.h"
+#include "thread_pool.h"
+#include "tile_pyramid.h"
+#include "window_level.h"
+#include "window_simd.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+struct Options {
+    int iterations = 20;
+    std::string directory;
+    std::string profile;
+    bool scalar = false;
+    bool csv = false;
+    bool keep_files = false;
+};
+
+// Nearest-rank percentile of sorted samples
+double percentile(const std::vector<double> &sorted, double fraction) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    const size_t rank = size_t(fraction * double(sorted.size()) + 0.5);
+    return sorted[std::min(sorted.size() - 1, rank > 0 ? rank - 1 : 0)];
+}
+
+// Peak resident set size in MiB, or 0 where it cannot be read
+double get_peak_rss_mb() {
+#ifdef __linux__
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        return double(usage.ru_maxrss) / 1024.0;
+    }
+#endif
+    return 0.0;
+}
+
+class Report {
+public:
+    explicit Report(bool p_csv) :
+            csv(p_csv) {
+        if (csv) {
+            std::printf("profile,encoding,stage,samples,p50_ms,p90_ms,p99_ms,max_ms,mp_per_s,peak_rss_mb\n");
+        } else {
+            std::printf("%-4s %-9s %-10s %7s %9s %9s %9s %9s %10s %9s\n", "", "encoding", "stage", "samples", "p50 ms", "p90 ms",
+                    "p99 ms", "max ms", "MP/s", "peak MiB");
+        }
+    }
+
+    // Throughput is taken at the median, for `pixels` per sample; stages
+    // that do not touch the pixels pass 0 and get none
+    void add(const char *profile, const char *encoding, const char *stage, std::vector<double> samples_usec, size_t pixels) {
+        if (samples_usec.empty()) {
+            return;
+        }
+        std::sort(samples_usec.begin(), samples_usec.end());
+        const double p50 = percentile(samples_usec, 0.50) / 1000.0;
+        const double p90 = percentile(samples_usec, 0.90) / 1000.0;
+        const double p99 = percentile(samples_usec, 0.99) / 1000.0;
+        const double max = samples_usec.back() / 1000.0;
+        char throughput[32] = "";
+        if (pixels > 0 && p50 > 0.0) {
+            std::snprintf(throughput, sizeof(throughput), "%.1f", double(pixels) / 1e6 / (p50 / 1000.0));
+        } else if (!csv) {
+            std::snprintf(throughput, sizeof(throughput), "-");
+        }
+        const char *format = csv ? "%s,%s,%s,%zu,%.3f,%.3f,%.3f,%.3f,%s,%.1f\n"
+                                 : "%-4s %-9s %-10s %7zu %9.3f %9.3f %9.3f %9.3f %10s %9.1f\n";
+        std::printf(format, profile, encoding, stage, samples_usec.size(), p50, p90, p99, max, throughput, get_peak_rss_mb());
+    }
+
+private:
+    bool csv;
+};
+
+// Window the whole slice as apply_window_level() does above its parallel
+// threshold: bands of whole rows, one per worker plus the calling thread
+void window_banded(const dicom::WindowEngine &engine, const dicom::PixelBuffer &pixels, uint8_t *dst) {
+    const size_t width = size_t(pixels.get_width());
+    const size_t height = size_t(pixels.get_height());
+    const size_t bands = size_t(dicom::ThreadPool::get_singleton()->get_thread_count() + 1);
+    const size_t rows_per_band = (height + bands - 1) / bands;
+    dicom::ThreadPool::get_singleton()->parallel_for(height, rows_per_band, [&](size_t row_begin, size_t row_end) {
+        engine.apply(pixels, row_begin * width, (row_end - row_begin) * width, dst + row_begin * width);
+    });
+}
+
+bool run_case(const Options &options, const bench::ImageProfile &profile, bench::Encoding encoding, Report &report) {
+    const char *encoding_name = bench::get_encoding_name(encoding);
+    const std::string path = options.directory + "/" + profile.name + "_" + encoding_name + ".dcm";
+    std::string error;
+    if (!bench::write_synthetic_dicom(path, profile, encoding, 1, error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return false;
+    }
+
+    const size_t pixel_count = size_t(profile.rows) * size_t(profile.columns);
+    const int iterations = options.iterations;
+    std::vector<double> header_usec, load_usec, parse_usec, decode_usec, convert_usec;
+    std::shared_ptr<dicom::DecodedSlice> slice;
+
+    // One untimed pass so the file is in the page cache for every sample
+    for (int i = -1; i < iterations; ++i) {
+        dicom::SliceInfo info;
+        uint64_t start = dicom::get_ticks_usec();
+        if (!dicom::read_dicom_header(path, info, error)) {
+            std::fprintf(stderr, "%s: %s\n", path.c_str(), error.c_str());
+            return false;
+        }
+        const double header_time = double(dicom::get_ticks_usec() - start);
+
+        std::shared_ptr<dicom::DecodedSlice> fresh = std::make_shared<dicom::DecodedSlice>();
+        start = dicom::get_ticks_usec();
+        if (!dicom::decode_dicom_file(path, *fresh, error)) {
+            std::fprintf(stderr, "%s: %s\n", path.c_str(), error.c_str());
+            return false;
+        }
+        const double load_time = double(dicom::get_ticks_usec() - start);
+        if (i >= 0) {
+            header_usec.push_back(header_time);
+            load_usec.push_back(load_time);
+            parse_usec.push_back(double(fresh->timings.parse_usec));
+            decode_usec.push_back(double(fresh->timings.decode_usec));
+            convert_usec.push_back(double(fresh->timings.convert_usec));
+        }
+        slice = fresh;
+    }
+    if (slice->pixels.get_pixel_count() != pixel_count) {
+        std::fprintf(stderr, "%s: decoded %dx%d, expected %dx%d\n", path.c_str(), slice->pixels.get_width(),
+                slice->pixels.get_height(), profile.columns, profile.rows);
+        return false;
+    }
+    report.add(profile.name, encoding_name, "header", header_usec, 0);
+    report.add(profile.name, encoding_name, "load", load_usec, pixel_count);
+    report.add(profile.name, encoding_name, "parse", parse_usec, 0);
+    report.add(profile.name, encoding_name, "decode", decode_usec, pixel_count);
+    report.add(profile.name, encoding_name, "convert", convert_usec, pixel_count);
+
+    // Window/level drag: every sample moves the window, so the lookup
+    // table is rebuilt each time as it is while dragging
+    const dicom::PixelBuffer &pixels = slice->pixels;
+    std::vector<uint8_t> staging(pixel_count);
+    dicom::WindowEngine engine;
+    std::vector<double> window_usec, window_single_usec;
+    for (int i = -1; i < iterations; ++i) {
+        const double center = profile.window_center + (i % 16) * profile.window_width / 64.0;
+        uint64_t start = dicom::get_ticks_usec();
+        engine.configure(pixels, center, profile.window_width);
+        window_banded(engine, pixels, staging.data());
+        const double banded_time = double(dicom::get_ticks_usec() - start);
+
+        start = dicom::get_ticks_usec();
+        engine.configure(pixels, center + 1.0, profile.window_width);
+        engine.apply(pixels, 0, pixel_count, staging.data());
+        const double single_time = double(dicom::get_ticks_usec() - start);
+        if (i >= 0) {
+            window_usec.push_back(banded_time);
+            window_single_usec.push_back(single_time);
+        }
+    }
+    report.add(profile.name, encoding_name, "window", window_usec, pixel_count);
+    report.add(profile.name, encoding_name, "window_1t", window_single_usec, pixel_count);
+
+    // Progressive preview at DicomViewer's default factor, and the box
+    // filter thumbnails use at the same factor
+    std::vector<double> preview_usec;
+    std::vector<double> box_usec;
+    for (int i = -1; i < iterations; ++i) {
+        dicom::PixelBuffer preview;
+        uint64_t start = dicom::get_ticks_usec();
+        dicom::downsample_sample(pixels, 4, preview);
+        const double preview_time = double(dicom::get_ticks_usec() - start);
+        start = dicom::get_ticks_usec();
+        dicom::downsample_box(pixels, 4, preview);
+        if (i >= 0) {
+            preview_usec.push_back(preview_time);
+            box_usec.push_back(double(dicom::get_ticks_usec() - start));
+        }
+    }
+    report.add(profile.name, encoding_name, "preview", preview_usec, pixel_count);
+    report.add(profile.name, encoding_name, "box", box_usec, pixel_count);
+
+    if (profile.columns > dicom::TilePyramid::TILE_SIZE || profile.rows > dicom::TilePyramid::TILE_SIZE) {
+        std::vector<double> pyramid_usec;
+        for (int i = -1; i < iterations; ++i) {
+            dicom::TilePyramid pyramid;
+            const uint64_t start = dicom::get_ticks_usec();
+            pyramid.build(slice);
+            if (i >= 0) {
+                pyramid_usec.push_back(double(dicom::get_ticks_usec() - start));
+            }
+        }
+        report.add(profile.name, encoding_name, "pyramid", pyramid_usec, pixel_count);
+    }
+
+    if (!options.keep_files) {
+        std::remove(path.c_str());
+    }
+    return true;
+}
+
+void print_usage(const char *program) {
+    std::printf("Usage: %s [--iterations N] [--profile CT|MR|DX|MG] [--dir PATH] [--scalar] [--csv] [--keep]\n"
+                "  --iterations N  timed samples per stage (default 20)\n"
+                "  --profile NAME  run one image profile only\n"
+                "  --dir PATH      where the synthetic files are written (default: system temp)\n"
+                "  --scalar        force the scalar windowing kernels\n"
+                "  --csv           machine-readable output\n"
+                "  --keep          keep the synthetic files\n",
+            program);
+}
+
+bool parse_options(int argc, char **argv, Options &options) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (arg == "--iterations" && has_value) {
+            options.iterations = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--profile" && has_value) {
+            options.profile = argv[++i];
+        } else if (arg == "--dir" && has_value) {
+            options.directory = argv[++i];
+        } else if (arg == "--scalar") {
+            options.scalar = true;
+        } else if (arg == "--csv") {
+            options.csv = true;
+        } else if (arg == "--keep") {
+            options.keep_files = true;
+        } else {
+            print_usage(argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        return 2;
+    }
+    bool known_profile = options.profile.empty();
+    for (const bench::ImageProfile &profile : bench::get_image_profiles()) {
+        known_profile = known_profile || options.profile == profile.name;
+    }
+    if (!known_profile) {
+        std::fprintf(stderr, "Unknown profile: %s\n", options.profile.c_str());
+        return 2;
+    }
+    std::error_code error;
+    if (options.directory.empty()) {
+        options.directory = (std::filesystem::temp_directory_path(error) / "dicomviewer_bench").string();
+    }
+    std::filesystem::create_directories(options.directory, error);
+
+    if (options.scalar) {
+        dicom::set_simd_level(dicom::SIMD_NONE);
+    }
+    // A kernel that disagrees with the scalar reference fails the run
+    if (!dicom::verify_window_kernels()) {
+        std::fprintf(stderr, "%s windowing kernel disagrees with the scalar reference\n",
+                dicom::get_simd_level_name(dicom::get_simd_level()));
+        return 1;
+    }
+    if (!options.csv) {
+#ifdef USE_DCMTK
+        const char *decoder = "DCMTK";
+#else
+        const char *decoder = "built-in";
+#endif
+        std::printf("decoder: %s, windowing: %s, workers: %d, samples: %d\n", decoder,
+                dicom::get_simd_level_name(dicom::get_simd_level()),
+                dicom::ThreadPool::get_singleton()->get_thread_count(), options.iterations);
+    }
+
+    Report report(options.csv);
+    bool ok = true;
+    for (const bench::ImageProfile &profile : bench::get_image_profiles()) {
+        if (!options.profile.empty() && options.profile != profile.name) {
+            continue;
+        }
+        for (bench::Encoding encoding : { bench::ENCODING_EXPLICIT_LE, bench::ENCODING_RLE }) {
+            ok = run_case(options, profile, encoding, report) && ok;
+        }
+    }
+    dicom::ThreadPool::release_singleton();
+    return ok ? 0 : 1;
+}
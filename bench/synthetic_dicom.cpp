@@ -0,0 +1,280 @@
+#include "synthetic_dicom.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace bench {
+
+namespace {
+
+const char *TS_EXPLICIT_LE = "1.2.840.10008.1.2.1";
+const char *TS_RLE_LOSSLESS = "1.2.840.10008.1.2.5";
+// Secondary Capture Image Storage
+const char *SOP_CLASS_UID = "1.2.840.10008.5.1.4.1.1.7";
+const char *UID_ROOT = "1.2.826.0.1.3680043.10.1137";
+
+class Writer {
+public:
+    std::vector<uint8_t> bytes;
+
+    void u16(uint16_t value) {
+        bytes.push_back(uint8_t(value & 0xFF));
+        bytes.push_back(uint8_t(value >> 8));
+    }
+    void u32(uint32_t value) {
+        u16(uint16_t(value & 0xFFFF));
+        u16(uint16_t(value >> 16));
+    }
+    void append(const std::vector<uint8_t> &data) { bytes.insert(bytes.end(), data.begin(), data.end()); }
+
+    // Explicit VR little endian element; values are padded to even length
+    void element(uint16_t group, uint16_t element, const char *vr, const std::vector<uint8_t> &value) {
+        std::vector<uint8_t> padded = value;
+        if (padded.size() % 2 != 0) {
+            padded.push_back(std::strcmp(vr, "UI") == 0 || std::strcmp(vr, "OB") == 0 ? 0 : ' ');
+        }
+        u16(group);
+        u16(element);
+        bytes.push_back(uint8_t(vr[0]));
+        bytes.push_back(uint8_t(vr[1]));
+        if (is_long_vr(vr)) {
+            u16(0);
+            u32(uint32_t(padded.size()));
+        } else {
+            u16(uint16_t(padded.size()));
+        }
+        append(padded);
+    }
+    void text(uint16_t group, uint16_t element_number, const char *vr, const std::string &value) {
+        element(group, element_number, vr, std::vector<uint8_t>(value.begin(), value.end()));
+    }
+    void us(uint16_t group, uint16_t element_number, uint16_t value) {
+        element(group, element_number, "US", { uint8_t(value & 0xFF), uint8_t(value >> 8) });
+    }
+    void item_tag(uint16_t element_number, uint32_t length) {
+        u16(0xFFFE);
+        u16(element_number);
+        u32(length);
+    }
+
+private:
+    static bool is_long_vr(const char *vr) {
+        static const char *LONG_VRS[] = { "OB", "OW", "OF", "SQ", "UT", "UN" };
+        for (const char *candidate : LONG_VRS) {
+            if (std::strcmp(vr, candidate) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+std::string format_number(double value) {
+    char text[32];
+    std::snprintf(text, sizeof(text), "%g", value);
+    return text;
+}
+
+// UIDs are digits and dots only: spell the profile name as character codes
+std::string uid_component(const char *name) {
+    std::string digits;
+    for (const char *c = name; *c; ++c) {
+        digits += std::to_string(int(uint8_t(*c)));
+    }
+    return digits;
+}
+
+// Phantom in 16-bit stored values, row by row
+std::vector<uint16_t> make_pixels(const ImageProfile &profile, uint32_t seed) {
+    const int rows = profile.rows;
+    const int columns = profile.columns;
+    const int max_value = profile.is_signed ? (1 << (profile.bits_stored - 1)) - 1 : (1 << profile.bits_stored) - 1;
+    const int min_value = profile.is_signed ? -(1 << (profile.bits_stored - 1)) : 0;
+    const double center_x = columns * 0.5;
+    const double center_y = rows * 0.5;
+    const double radius_x = columns * 0.42;
+    const double radius_y = rows * 0.45;
+    const double insert_x = center_x + columns * 0.12;
+    const double insert_y = center_y - rows * 0.08;
+    const double insert_radius = std::min(rows, columns) * 0.07;
+
+    std::vector<uint16_t> pixels(size_t(rows) * size_t(columns));
+    uint32_t state = seed * 2654435761u + 1;
+    for (int y = 0; y < rows; ++y) {
+        for (int x = 0; x < columns; ++x) {
+            const double dx = (x - center_x) / radius_x;
+            const double dy = (y - center_y) / radius_y;
+            const double r2 = dx * dx + dy * dy;
+            const double ix = x - insert_x;
+            const double iy = y - insert_y;
+            int value = profile.background;
+            if (r2 <= 1.0) {
+                const bool rim = r2 >= 0.88;
+                const bool insert = ix * ix + iy * iy <= insert_radius * insert_radius;
+                value = rim || insert ? profile.dense : profile.body + int(profile.noise * 2.0 * x / columns);
+            }
+            state = state * 1664525u + 1013904223u;
+            if (profile.noise > 0) {
+                value += int((state >> 8) % uint32_t(2 * profile.noise + 1)) - profile.noise;
+            }
+            value = std::max(min_value, std::min(max_value, value));
+            pixels[size_t(y) * size_t(columns) + size_t(x)] = uint16_t(int16_t(value));
+        }
+    }
+    return pixels;
+}
+
+// PackBits as DICOM RLE uses it: literal runs of 1-128 bytes (header n - 1)
+// and replicate runs of 2-128 bytes (header 1 - n)
+void pack_bits(const uint8_t *src, size_t count, std::vector<uint8_t> &out) {
+    size_t i = 0;
+    while (i < count) {
+        size_t run = 1;
+        while (i + run < count && run < 128 && src[i + run] == src[i]) {
+            ++run;
+        }
+        if (run >= 2) {
+            out.push_back(uint8_t(int8_t(1 - int(run))));
+            out.push_back(src[i]);
+            i += run;
+            continue;
+        }
+        // Literal run up to the next pair of equal bytes
+        size_t literal = 1;
+        while (i + literal < count && literal < 128 &&
+                !(i + literal + 1 < count && src[i + literal] == src[i + literal + 1])) {
+            ++literal;
+        }
+        out.push_back(uint8_t(literal - 1));
+        out.insert(out.end(), src + i, src + i + literal);
+        i += literal;
+    }
+}
+
+// One RLE fragment: a segment per byte plane, most significant first, each
+// row encoded separately
+std::vector<uint8_t> encode_rle(const std::vector<uint16_t> &pixels, int rows, int columns) {
+    std::vector<uint8_t> segments[2];
+    std::vector<uint8_t> plane((size_t)columns);
+    for (int byte = 0; byte < 2; ++byte) {
+        const int shift = byte == 0 ? 8 : 0;
+        for (int y = 0; y < rows; ++y) {
+            const uint16_t *row = pixels.data() + size_t(y) * size_t(columns);
+            for (int x = 0; x < columns; ++x) {
+                plane[size_t(x)] = uint8_t(row[x] >> shift);
+            }
+            pack_bits(plane.data(), plane.size(), segments[byte]);
+        }
+        if (segments[byte].size() % 2 != 0) {
+            segments[byte].push_back(0x80);
+        }
+    }
+
+    Writer fragment;
+    fragment.u32(2);
+    fragment.u32(64);
+    fragment.u32(uint32_t(64 + segments[0].size()));
+    for (int i = 0; i < 13; ++i) {
+        fragment.u32(0);
+    }
+    fragment.append(segments[0]);
+    fragment.append(segments[1]);
+    return fragment.bytes;
+}
+
+} // namespace
+
+const std::vector<ImageProfile> &get_image_profiles() {
+    static const std::vector<ImageProfile> profiles = {
+        { "CT", "CT", 512, 512, 12, true, 1.0, 0.0, 40.0, 400.0, -1000, 40, 900, 15 },
+        { "MR", "MR", 256, 256, 12, false, 1.0, 0.0, 450.0, 900.0, 0, 400, 900, 30 },
+        { "DX", "DX", 3000, 3000, 14, false, 1.0, 0.0, 6000.0, 12000.0, 600, 6000, 11000, 120 },
+        { "MG", "MG", 4096, 3072, 12, false, 1.0, 0.0, 1800.0, 2400.0, 200, 1800, 3000, 40 },
+    };
+    return profiles;
+}
+
+const char *get_encoding_name(Encoding encoding) {
+    return encoding == ENCODING_RLE ? "rle" : "explicit";
+}
+
+bool write_synthetic_dicom(const std::string &path, const ImageProfile &profile, Encoding encoding, uint32_t seed,
+        std::string &error) {
+    const std::string profile_id = uid_component(profile.name);
+    const std::string sop_instance_uid = std::string(UID_ROOT) + ".1." + profile_id + "." + std::to_string(int(encoding)) + "." +
+            std::to_string(seed);
+    const char *transfer_syntax = encoding == ENCODING_RLE ? TS_RLE_LOSSLESS : TS_EXPLICIT_LE;
+
+    // File meta information; its group length covers the elements after it
+    Writer meta;
+    meta.element(0x0002, 0x0001, "OB", { 0x00, 0x01 });
+    meta.text(0x0002, 0x0002, "UI", SOP_CLASS_UID);
+    meta.text(0x0002, 0x0003, "UI", sop_instance_uid);
+    meta.text(0x0002, 0x0010, "UI", transfer_syntax);
+    meta.text(0x0002, 0x0012, "UI", std::string(UID_ROOT) + ".0");
+
+    Writer file;
+    file.bytes.assign(128, 0);
+    file.append({ 'D', 'I', 'C', 'M' });
+    Writer group_length;
+    group_length.u32(uint32_t(meta.bytes.size()));
+    file.element(0x0002, 0x0000, "UL", group_length.bytes);
+    file.append(meta.bytes);
+
+    const int bits_stored = profile.bits_stored;
+    file.text(0x0008, 0x0016, "UI", SOP_CLASS_UID);
+    file.text(0x0008, 0x0018, "UI", sop_instance_uid);
+    file.text(0x0008, 0x0060, "CS", profile.modality);
+    file.text(0x0020, 0x000D, "UI", std::string(UID_ROOT) + ".2");
+    file.text(0x0020, 0x000E, "UI", std::string(UID_ROOT) + ".3." + profile_id);
+    file.text(0x0020, 0x0013, "IS", std::to_string(seed));
+    file.us(0x0028, 0x0002, 1);
+    file.text(0x0028, 0x0004, "CS", "MONOCHROME2");
+    file.us(0x0028, 0x0010, uint16_t(profile.rows));
+    file.us(0x0028, 0x0011, uint16_t(profile.columns));
+    file.text(0x0028, 0x0030, "DS", "0.5\\0.5");
+    file.us(0x0028, 0x0100, 16);
+    file.us(0x0028, 0x0101, uint16_t(bits_stored));
+    file.us(0x0028, 0x0102, uint16_t(bits_stored - 1));
+    file.us(0x0028, 0x0103, profile.is_signed ? 1 : 0);
+    file.text(0x0028, 0x1050, "DS", format_number(profile.window_center));
+    file.text(0x0028, 0x1051, "DS", format_number(profile.window_width));
+    file.text(0x0028, 0x1052, "DS", format_number(profile.rescale_intercept));
+    file.text(0x0028, 0x1053, "DS", format_number(profile.rescale_slope));
+
+    const std::vector<uint16_t> pixels = make_pixels(profile, seed);
+    if (encoding == ENCODING_RLE) {
+        const std::vector<uint8_t> fragment = encode_rle(pixels, profile.rows, profile.columns);
+        // Encapsulated: undefined length, empty offset table, one fragment
+        file.u16(0x7FE0);
+        file.u16(0x0010);
+        file.append({ 'O', 'B', 0, 0 });
+        file.u32(0xFFFFFFFF);
+        file.item_tag(0xE000, 0);
+        file.item_tag(0xE000, uint32_t(fragment.size()));
+        file.append(fragment);
+        file.item_tag(0xE0DD, 0);
+    } else {
+        std::vector<uint8_t> raw(pixels.size() * 2);
+        for (size_t i = 0; i < pixels.size(); ++i) {
+            raw[2 * i] = uint8_t(pixels[i] & 0xFF);
+            raw[2 * i + 1] = uint8_t(pixels[i] >> 8);
+        }
+        file.element(0x7FE0, 0x0010, "OW", raw);
+    }
+
+    FILE *handle = std::fopen(path.c_str(), "wb");
+    if (!handle) {
+        error = "Cannot write " + path;
+        return false;
+    }
+    const bool written = std::fwrite(file.bytes.data(), 1, file.bytes.size(), handle) == file.bytes.size();
+    if (std::fclose(handle) != 0 || !written) {
+        error = "Cannot write " + path;
+        return false;
+    }
+    return true;
+}
+
+} // namespace bench
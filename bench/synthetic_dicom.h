@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+// Acquisition type the generator imitates. Pixel values are stored values
+// (before rescale) for the phantom's background, body and dense structures.
+struct ImageProfile {
+    const char *name;
+    const char *modality;
+    int rows;
+    int columns;
+    int bits_stored;
+    bool is_signed;
+    double rescale_slope;
+    double rescale_intercept;
+    double window_center;
+    double window_width;
+    int background;
+    int body;
+    int dense;
+    int noise;
+};
+
+// CT 512², MR 256², DX 3k x 3k and MG 4k x 3k
+const std::vector<ImageProfile> &get_image_profiles();
+
+enum Encoding {
+    ENCODING_EXPLICIT_LE,
+    ENCODING_RLE,
+};
+
+const char *get_encoding_name(Encoding encoding);
+
+// Write a single-frame Part 10 file for `profile`: a phantom (body outline,
+// dense rim and insert, deterministic noise) in 16-bit samples, with the
+// tags the viewer reads. The same `seed` gives the same pixels.
+bool write_synthetic_dicom(const std::string &path, const ImageProfile &profile, Encoding encoding, uint32_t seed,
+        std::string &error);
+
+} // namespace bench
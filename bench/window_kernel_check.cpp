@@ -0,0 +1,28 @@
+// Cross-checks every vector windowing kernel this CPU can run against the
+// scalar reference. Exits non-zero on the first level whose output differs;
+// run through ctest (see CMakeLists.txt).
+
+#include "window_simd.h"
+
+#include <cstdio>
+
+int main() {
+    const dicom::SimdLevel detected = dicom::detect_simd_level();
+    dicom::SimdLevel levels[2] = { detected, dicom::SIMD_NONE };
+    int level_count = 1;
+    // On AVX2 CPUs also check the SSE2 kernels older CPUs fall back to
+    if (detected == dicom::SIMD_AVX2) {
+        levels[level_count++] = dicom::SIMD_SSE2;
+    }
+
+    int failures = 0;
+    for (int i = 0; i < level_count; ++i) {
+        dicom::set_simd_level(levels[i]);
+        const bool matches = dicom::verify_window_kernels();
+        std::printf("%-6s %s\n", dicom::get_simd_level_name(levels[i]), matches ? "ok" : "MISMATCH");
+        if (!matches) {
+            failures++;
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -7,9 +7,20 @@ extends Control
 @onready var export_button: Button = $MarginContainer/VBoxContainer/ButtonsContainer2/ExportButton
 @onready var import_button: Button = $MarginContainer/VBoxContainer/ButtonsContainer2/ImportButton
 
+const THUMBNAIL_SIZE := 64
+# Decode compressed DICOM once on import so later loads map the pixels
+const TRANSCODE_ON_IMPORT := true
+
 var cases: Array = []
+# Case names and file lists come from the persistent index; a case resource
+# is only loaded when it is opened, edited or exported
+var library_index := CaseLibraryIndex.new()
 var export_dialog: FileDialog
 var import_dialog: FileDialog
+# Threads running slow native calls off the main thread; joined on exit
+var jobs: Array[Thread] = []
+# Bumped per thumbnail pass, so a pass for an older list is dropped
+var thumbnail_request := 0
 
 func _ready() -> void:
 	setup_dialogs()
@@ -21,6 +32,24 @@ func _ready() -> void:
 	
 	cases_list.item_selected.connect(_on_case_selected)
 
+func _exit_tree() -> void:
+	for thread in jobs:
+		thread.wait_to_finish()
+	jobs.clear()
+
+# Run `work` on a thread, then call `done` with its result on the main thread
+func run_job(work: Callable, done: Callable) -> void:
+	var thread := Thread.new()
+	jobs.append(thread)
+	thread.start(func(): _finish_job.call_deferred(thread, work.call(), done))
+
+func _finish_job(thread: Thread, result: Variant, done: Callable) -> void:
+	if not jobs.has(thread):
+		return
+	thread.wait_to_finish()
+	jobs.erase(thread)
+	done.call(result)
+
 func setup_dialogs() -> void:
 	# Export dialog
 	export_dialog = FileDialog.new()
@@ -44,29 +73,51 @@ func load_available_cases() -> void:
 	cases.clear()
 	cases_list.clear()
 	
-	var cases_dir = "user://cases"
-	var dir = DirAccess.open(cases_dir)
-	
-	if dir == null:
-		return
+	library_index.update("user://cases")
+	for i in range(library_index.get_case_count()):
+		var info = library_index.get_case(i)
+		cases.append({
+			"path": info["path"],
+			"name": info["name"],
+			"index": i
+		})
+		cases_list.add_item(info["name"])
 	
-	dir.list_dir_begin()
-	var file_name = dir.get_next()
+	load_case_thumbnails()
+
+func get_case_resource(case_data: Dictionary) -> RadiologyCase:
+	if not case_data.has("resource"):
+		case_data["resource"] = ResourceLoader.load(case_data["path"]) as RadiologyCase
+	return case_data["resource"]
+
+func load_case_thumbnails() -> void:
+	# One preview per case from its first image. Thumbnails are cached on
+	# disk, so only new or changed files are decoded.
+	var items: Array = []
+	var paths: Array = []
+	for i in range(cases.size()):
+		var dicom_paths = library_index.get_case_file_paths(cases[i]["index"])
+		if dicom_paths.size() > 0:
+			items.append(i)
+			paths.append(dicom_paths[0])
 	
-	while file_name != "":
-		if file_name.ends_with(".tres"):
-			var full_path = cases_dir.path_join(file_name)
-			var case_resource = ResourceLoader.load(full_path) as RadiologyCase
-			if case_resource:
-				cases.append({
-					"path": full_path,
-					"resource": case_resource
-				})
-				cases_list.add_item(case_resource.get_case_name())
-		
-		file_name = dir.get_next()
+	if paths.is_empty():
+		return
 	
-	dir.list_dir_end()
+	cases_list.fixed_icon_size = Vector2i(THUMBNAIL_SIZE, THUMBNAIL_SIZE)
+	# Decoded on a thread so the list is usable while thumbnails come in
+	thumbnail_request += 1
+	var request := thumbnail_request
+	run_job(func(): return DicomViewer.create_thumbnails(paths, THUMBNAIL_SIZE),
+		func(thumbnails): _apply_thumbnails(request, items, thumbnails))
+
+func _apply_thumbnails(request: int, items: Array, thumbnails: Array) -> void:
+	if request != thumbnail_request:
+		return
+	for j in range(items.size()):
+		var thumbnail = thumbnails[j] as Image
+		if thumbnail:
+			cases_list.set_item_icon(items[j], ImageTexture.create_from_image(thumbnail))
 
 func _on_case_selected(_index: int) -> void:
 	edit_button.disabled = false
@@ -93,7 +144,7 @@ func _on_delete_button_pressed() -> void:
 	var case_data = cases[selected[0]]
 	
 	var dialog = ConfirmationDialog.new()
-	dialog.dialog_text = "Delete case '%s'? This cannot be undone." % case_data["resource"].get_case_name()
+	dialog.dialog_text = "Delete case '%s'? This cannot be undone." % case_data["name"]
 	dialog.confirmed.connect(func():
 		DirAccess.remove_absolute(case_data["path"])
 		load_available_cases()
@@ -128,7 +179,7 @@ func _on_export_button_pressed() -> void:
 		return
 	
 	var case_data = cases[selected[0]]
-	export_dialog.current_file = case_data["resource"].get_case_name() + ".radcase"
+	export_dialog.current_file = case_data["name"] + ".radcase"
 	export_dialog.popup_centered(Vector2i(800, 600))
 
 func _on_export_dialog_file_selected(path: String) -> void:
@@ -137,38 +188,17 @@ func _on_export_dialog_file_selected(path: String) -> void:
 		return
 	
 	var case_data = cases[selected[0]]
-	var case_dict = case_data["resource"].to_dict()
-	
-	var export_package = {
-		"version": 1,
-		"case_data": case_dict,
-		"dicom_files": {},
-		"explanation_images": {}
-	}
-	
-	# Embed DICOM files
-	for dicom_path in case_dict["dicom_file_paths"]:
-		var file = FileAccess.open(dicom_path, FileAccess.READ)
-		if file:
-			var bytes = file.get_buffer(file.get_length())
-			export_package["dicom_files"][dicom_path.get_file()] = Marshalls.raw_to_base64(bytes)
-			file.close()
-	
-	# Embed explanation images
-	for question in case_dict["questions"]:
-		if question.has("explanation") and question["explanation"].has("images"):
-			for img_path in question["explanation"]["images"]:
-				var img_file = FileAccess.open(img_path, FileAccess.READ)
-				if img_file:
-					var img_bytes = img_file.get_buffer(img_file.get_length())
-					export_package["explanation_images"][img_path.get_file()] = Marshalls.raw_to_base64(img_bytes)
-					img_file.close()
-	
-	var json_string = JSON.stringify(export_package, "\t")
-	var export_file = FileAccess.open(path, FileAccess.WRITE)
-	if export_file:
-		export_file.store_string(json_string)
-		export_file.close()
+	var case_resource = get_case_resource(case_data)
+	if case_resource == null:
+		show_notification("Export failed!", true)
+		return
+	# Files are streamed into the package on a thread; nothing is held in
+	# memory whole and the UI stays responsive
+	run_job(func(): return CasePackage.export_case(case_resource, path, true),
+		_on_export_finished)
+
+func _on_export_finished(exported: bool) -> void:
+	if exported:
 		show_notification("Case exported successfully!")
 	else:
 		show_notification("Export failed!", true)
@@ -177,6 +207,23 @@ func _on_import_button_pressed() -> void:
 	import_dialog.popup_centered(Vector2i(800, 600))
 
 func _on_import_dialog_file_selected(path: String) -> void:
+	# Seconds alone repeat when two imports start in the same second
+	var import_id = "%d_%d" % [Time.get_unix_time_from_system(), Time.get_ticks_usec()]
+	if not CasePackage.is_package(path):
+		import_legacy_package(path, import_id)
+		return
+	
+	run_job(func(): return CasePackage.import_case(path, "user://imported_dicom", "user://imported_images", import_id),
+		_on_import_finished)
+
+func _on_import_finished(new_case: RadiologyCase) -> void:
+	if new_case == null:
+		show_notification("Invalid case file format!", true)
+		return
+	save_imported_case(new_case)
+
+# Cases exported before the binary package format: JSON with base64 files
+func import_legacy_package(path: String, import_id: String) -> void:
 	var import_file = FileAccess.open(path, FileAccess.READ)
 	if not import_file:
 		show_notification("Failed to open import file!", true)
@@ -198,8 +245,6 @@ func _on_import_dialog_file_selected(path: String) -> void:
 	var new_case = RadiologyCase.new()
 	new_case.from_dict(import_package["case_data"])
 	
-	var import_id = "%d" % Time.get_unix_time_from_system()
-	
 	# Create necessary directories
 	DirAccess.make_dir_recursive_absolute("user://cases")
 	DirAccess.make_dir_recursive_absolute("user://imported_dicom")
@@ -251,7 +296,14 @@ func _on_import_dialog_file_selected(path: String) -> void:
 		
 		new_case.set_questions(questions)
 	
-	# Save the imported case
+	save_imported_case(new_case)
+
+func save_imported_case(new_case: RadiologyCase) -> void:
+	if TRANSCODE_ON_IMPORT:
+		# Decoded in the background; loads before it finishes just decode
+		var paths = new_case.get_dicom_file_paths()
+		run_job(func(): return DicomViewer.transcode_files(paths), func(_count): pass)
+	DirAccess.make_dir_recursive_absolute("user://cases")
 	var case_name = new_case.get_case_name()
 	var case_save_path = "user://cases/%s.tres" % case_name
 	
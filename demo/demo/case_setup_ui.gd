@@ -237,11 +237,12 @@ func _on_folder_dialog_dir_selected(dir_path: String) -> void:
 	var files = scan_directory_for_dicom(dir_path)
 	print("Found ", files.size(), " files")
 	if files.size() > 0:
-		load_files_from_paths(files)
+		# Already in series and slice order
+		load_files_from_paths(files, false)
 	else:
-		dicom_status.text = "No files found in folder"
+		dicom_status.text = "No DICOM files found in folder"
 
-func load_files_from_paths(paths: PackedStringArray) -> void:
+func load_files_from_paths(paths: PackedStringArray, sort_by_name: bool = true) -> void:
 	dicom_files.clear()
 	
 	dicom_status.text = "Loading files..."
@@ -249,7 +250,8 @@ func load_files_from_paths(paths: PackedStringArray) -> void:
 	for path in paths:
 		dicom_files.append(path)
 	
-	dicom_files.sort()
+	if sort_by_name:
+		dicom_files.sort()
 	
 	print("Total files to load: ", dicom_files.size())
 	
@@ -264,35 +266,15 @@ func load_files_from_paths(paths: PackedStringArray) -> void:
 		dicom_status.text = "No files found"
 
 func scan_directory_for_dicom(dir_path: String, recursive: bool = true) -> PackedStringArray:
+	# Headers only: non-DICOM files are dropped and the rest come back
+	# grouped by series in slice order
 	var found_files = PackedStringArray()
+	var indexer = DicomIndexer.new()
+	for entry in indexer.scan_directory(dir_path, recursive):
+		found_files.append(entry["path"])
 	
-	var dir = DirAccess.open(dir_path)
-	if dir == null:
-		push_error("Failed to open directory: " + dir_path)
-		dicom_status.text = "Failed to open directory"
-		return found_files
-	
-	dir.list_dir_begin()
-	var file_name = dir.get_next()
-	
-	while file_name != "":
-		if file_name == "." or file_name == "..":
-			file_name = dir.get_next()
-			continue
-		
-		var full_path = dir_path.path_join(file_name)
-		
-		if dir.current_is_dir():
-			if recursive:
-				var sub_files = scan_directory_for_dicom(full_path, recursive)
-				for sub_file in sub_files:
-					found_files.append(sub_file)
-		else:
-			found_files.append(full_path)
-		
-		file_name = dir.get_next()
-	
-	dir.list_dir_end()
+	print("Indexed %d DICOM files (%d skipped) in %.1f ms" % [
+		indexer.get_file_count(), indexer.get_skipped_count(), indexer.get_scan_time_usec() / 1000.0])
 	return found_files
 
 func _on_add_question_button_pressed() -> void:
@@ -67,10 +67,6 @@ var annotations_per_image: Dictionary = {}  # key: image_index, value: Array of
 var selected_annotation_index: int = -1
 var annotation_overlay: Control
 
-# Performance optimization
-var is_loading: bool = false
-var pending_image_index: int = -1
-
 func _ready() -> void:
     set_anchors_preset(Control.PRESET_FULL_RECT)
     set_process_unhandled_input(true)
@@ -115,6 +111,8 @@ func setup_dicom_controls() -> void:
         reset_view_button.pressed.connect(_on_reset_button_pressed)
     if not dicom_viewer.gui_input.is_connected(_on_dicom_viewer_gui_input):
         dicom_viewer.gui_input.connect(_on_dicom_viewer_gui_input)
+    if not dicom_viewer.load_completed.is_connected(_on_dicom_load_completed):
+        dicom_viewer.load_completed.connect(_on_dicom_load_completed)
     
     update_windowing_labels()
 
@@ -142,67 +140,57 @@ func load_case(path: String) -> void:
     display_current_question()
 
 func load_current_image() -> void:
-    # Prevent loading if already loading
-    if is_loading:
-        pending_image_index = current_image_index
+    if current_image_index >= 0 and current_image_index < dicom_files.size():
+        # Decoding runs in the background; a newer request cancels this one
+        dicom_viewer.load_dicom_async(dicom_files[current_image_index])
+        # Warm the neighbouring slices so scrolling hits the cache
+        dicom_viewer.prefetch_slices(dicom_files, current_image_index, 4, 2)
+
+func _on_dicom_load_completed(path: String, ok: bool) -> void:
+    if not ok:
+        push_error("Failed to load DICOM: " + path)
         return
     
-    if current_image_index >= 0 and current_image_index < dicom_files.size():
-        is_loading = true
-        
-        var success = dicom_viewer.load_dicom(dicom_files[current_image_index])
-        
-        if success:
-            image_index_label.text = "Image %d / %d" % [current_image_index + 1, dicom_files.size()]
-            
-            # Update aspect ratio display
-            var aspect_ratio = dicom_viewer.get_pixel_aspect_ratio()
-            if aspect_ratio == 1.0:
-                aspect_ratio_label.text = "Aspect Ratio: 1:1"
-            else:
-                aspect_ratio_label.text = "Aspect Ratio: %.2f:1" % aspect_ratio
-            
-            # Update modality display
-            var modality = dicom_viewer.get_modality()
-            if modality != "":
-                modality_label.text = "Modality: " + modality
-            else:
-                modality_label.text = "Modality: Unknown"
-            
-            if is_zoomed_in:
-                dicom_viewer.reset_view()
-                is_zoomed_in = false
-            
-            # Redraw annotations for new image
-            selected_annotation_index = -1
-            if annotation_overlay:
-                annotation_overlay.queue_redraw()
-            
-            if not user_adjusted_windowing:
-                # Use modality-specific preset
-                dicom_viewer.apply_modality_preset()
-                # Block signals to prevent redundant updates
-                window_slider.set_block_signals(true)
-                level_slider.set_block_signals(true)
-                window_slider.value = dicom_viewer.get_window()
-                level_slider.value = dicom_viewer.get_level()
-                window_slider.set_block_signals(false)
-                level_slider.set_block_signals(false)
-                # Update labels without triggering value_changed
-                window_label.text = "Window: %.0f" % window_slider.value
-                level_label.text = "Level: %.0f" % level_slider.value
-            else:
-                dicom_viewer.set_window_level(window_slider.value, level_slider.value)
-        else:
-            push_error("Failed to load DICOM: " + dicom_files[current_image_index])
-        
-        is_loading = false
-        
-        # Handle pending load if any
-        if pending_image_index != -1 and pending_image_index != current_image_index:
-            current_image_index = pending_image_index
-            pending_image_index = -1
-            call_deferred("load_current_image")
+    image_index_label.text = "Image %d / %d" % [current_image_index + 1, dicom_files.size()]
+    
+    # Update aspect ratio display
+    var aspect_ratio = dicom_viewer.get_pixel_aspect_ratio()
+    if aspect_ratio == 1.0:
+        aspect_ratio_label.text = "Aspect Ratio: 1:1"
+    else:
+        aspect_ratio_label.text = "Aspect Ratio: %.2f:1" % aspect_ratio
+    
+    # Update modality display
+    var modality = dicom_viewer.get_modality()
+    if modality != "":
+        modality_label.text = "Modality: " + modality
+    else:
+        modality_label.text = "Modality: Unknown"
+    
+    if is_zoomed_in:
+        dicom_viewer.reset_view()
+        is_zoomed_in = false
+    
+    # Redraw annotations for new image
+    selected_annotation_index = -1
+    if annotation_overlay:
+        annotation_overlay.queue_redraw()
+    
+    if not user_adjusted_windowing:
+        # Use modality-specific preset
+        dicom_viewer.apply_modality_preset()
+        # Block signals to prevent redundant updates
+        window_slider.set_block_signals(true)
+        level_slider.set_block_signals(true)
+        window_slider.value = dicom_viewer.get_window()
+        level_slider.value = dicom_viewer.get_level()
+        window_slider.set_block_signals(false)
+        level_slider.set_block_signals(false)
+        # Update labels without triggering value_changed
+        window_label.text = "Window: %.0f" % window_slider.value
+        level_label.text = "Level: %.0f" % level_slider.value
+    else:
+        dicom_viewer.set_window_level(window_slider.value, level_slider.value)
 
 func display_current_question() -> void:
     var questions = current_case.get_questions()
@@ -624,15 +612,11 @@ func _on_next_question_button_pressed() -> void:
     display_current_question()
 
 func _on_prev_image_button_pressed() -> void:
-    if is_loading:
-        return
     if current_image_index > 0:
         current_image_index -= 1
         load_current_image()
 
 func _on_next_image_button_pressed() -> void:
-    if is_loading:
-        return
     if current_image_index < dicom_files.size() - 1:
         current_image_index += 1
         load_current_image()
@@ -744,17 +728,13 @@ func _on_auto_button_pressed() -> void:
     update_windowing_labels()
 
 func zoom_into_position(click_pos: Vector2, zoom_factor: float) -> void:
-    if dicom_viewer.get_child_count() == 0:
-        return
-    
-    var texture_rect = dicom_viewer.get_child(0) as TextureRect
-    if not texture_rect or not texture_rect.texture:
+    if not dicom_viewer.get_image_screen_rect().has_area():
         return
     
-    var texture_point = (click_pos - texture_rect.position) / texture_rect.scale.x
-    texture_rect.scale = Vector2(zoom_factor, zoom_factor)
-    var new_position = click_pos - (texture_point * zoom_factor)
-    texture_rect.position = new_position
+    # Through the viewer, so it windows and draws what comes into view
+    var texture_point = (click_pos - dicom_viewer.get_pan()) / dicom_viewer.get_zoom()
+    dicom_viewer.set_zoom(zoom_factor)
+    dicom_viewer.set_pan(click_pos - (texture_point * zoom_factor))
 
 func _on_annotation_overlay_draw() -> void:
     if not annotation_overlay:
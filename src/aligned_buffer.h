@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <utility>
+
+namespace dicom {
+
+// Heap block whose start is aligned to a cache line, so vector loads over
+// it never straddle lines at the start of a row or slice. Move-only.
+class AlignedBuffer {
+public:
+    static const size_t ALIGNMENT = 64;
+
+    AlignedBuffer() {}
+    ~AlignedBuffer() { release(); }
+
+    AlignedBuffer(const AlignedBuffer &) = delete;
+    AlignedBuffer &operator=(const AlignedBuffer &) = delete;
+
+    AlignedBuffer(AlignedBuffer &&other) noexcept { swap(other); }
+    AlignedBuffer &operator=(AlignedBuffer &&other) noexcept {
+        if (this != &other) {
+            release();
+            swap(other);
+        }
+        return *this;
+    }
+
+    // Drops the old contents. Returns false if the allocation failed.
+    bool allocate(size_t bytes) {
+        release();
+        if (bytes == 0) {
+            return true;
+        }
+        // Over-allocate and round up by hand; aligned operator new and
+        // aligned_alloc are not available on every platform Godot targets
+        block = std::malloc(bytes + ALIGNMENT - 1);
+        if (!block) {
+            return false;
+        }
+        const uintptr_t address = reinterpret_cast<uintptr_t>(block);
+        aligned = reinterpret_cast<uint8_t *>((address + ALIGNMENT - 1) & ~uintptr_t(ALIGNMENT - 1));
+        size = bytes;
+        return true;
+    }
+
+    void release() {
+        std::free(block);
+        block = nullptr;
+        aligned = nullptr;
+        size = 0;
+    }
+
+    uint8_t *data() { return aligned; }
+    const uint8_t *data() const { return aligned; }
+    size_t get_size() const { return size; }
+
+private:
+    void swap(AlignedBuffer &other) {
+        std::swap(block, other.block);
+        std::swap(aligned, other.aligned);
+        std::swap(size, other.size);
+    }
+
+    void *block = nullptr;
+    uint8_t *aligned = nullptr;
+    size_t size = 0;
+};
+
+} // namespace dicom
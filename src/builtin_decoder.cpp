@@ -0,0 +1,741 @@
+#include "builtin_decoder.h"
+#include "dicom_part10.h"
+#include "mapped_pixels.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#ifdef USE_DCMTK
+#include <dcmtk/dcmdata/dctag.h>
+#endif
+
+namespace dicom {
+
+namespace {
+
+const char *const TS_RLE_LOSSLESS = "1.2.840.10008.1.2.5";
+// First read for a header when the file is copied rather than mapped
+const size_t HEADER_PREFIX_BYTES = 64 * 1024;
+
+// Implicit VR files carry no VRs, so only elements listed here are read
+// from them: everything read_slice_info() and the viewer's metadata use.
+// Sorted by tag.
+struct KnownTag {
+    uint32_t tag;
+    char vr[3];
+};
+
+const KnownTag IMPLICIT_VRS[] = {
+    { 0x00080016, "UI" }, // SOP Class UID
+    { 0x00080018, "UI" }, // SOP Instance UID
+    { 0x00080020, "DA" }, // Study Date
+    { 0x00080030, "TM" }, // Study Time
+    { 0x00080050, "SH" }, // Accession Number
+    { 0x00080060, "CS" }, // Modality
+    { 0x00080070, "LO" }, // Manufacturer
+    { 0x00080080, "LO" }, // Institution Name
+    { 0x00081030, "LO" }, // Study Description
+    { 0x0008103E, "LO" }, // Series Description
+    { 0x00082144, "IS" }, // Recommended Display Frame Rate
+    { 0x00100010, "PN" }, // Patient's Name
+    { 0x00100020, "LO" }, // Patient ID
+    { 0x00100030, "DA" }, // Patient's Birth Date
+    { 0x00100040, "CS" }, // Patient's Sex
+    { 0x00101010, "AS" }, // Patient's Age
+    { 0x00180015, "CS" }, // Body Part Examined
+    { 0x00180040, "IS" }, // Cine Rate
+    { 0x00180050, "DS" }, // Slice Thickness
+    { 0x00180088, "DS" }, // Spacing Between Slices
+    { 0x00181063, "DS" }, // Frame Time
+    { 0x00181164, "DS" }, // Imager Pixel Spacing
+    { 0x0020000D, "UI" }, // Study Instance UID
+    { 0x0020000E, "UI" }, // Series Instance UID
+    { 0x00200011, "IS" }, // Series Number
+    { 0x00200013, "IS" }, // Instance Number
+    { 0x00200032, "DS" }, // Image Position (Patient)
+    { 0x00200037, "DS" }, // Image Orientation (Patient)
+    { 0x00280002, "US" }, // Samples per Pixel
+    { 0x00280004, "CS" }, // Photometric Interpretation
+    { 0x00280008, "IS" }, // Number of Frames
+    { 0x00280010, "US" }, // Rows
+    { 0x00280011, "US" }, // Columns
+    { 0x00280030, "DS" }, // Pixel Spacing
+    { 0x00280100, "US" }, // Bits Allocated
+    { 0x00280101, "US" }, // Bits Stored
+    { 0x00280102, "US" }, // High Bit
+    { 0x00280103, "US" }, // Pixel Representation
+    { 0x00281050, "DS" }, // Window Center
+    { 0x00281051, "DS" }, // Window Width
+    { 0x00281052, "DS" }, // Rescale Intercept
+    { 0x00281053, "DS" }, // Rescale Slope
+    { 0x00281054, "LO" }, // Rescale Type
+};
+
+const char *find_implicit_vr(uint32_t tag) {
+    const KnownTag *end = IMPLICIT_VRS + sizeof(IMPLICIT_VRS) / sizeof(IMPLICIT_VRS[0]);
+    const KnownTag *found = std::lower_bound(IMPLICIT_VRS, end, tag, [](const KnownTag &known, uint32_t key) { return known.tag < key; });
+    if (found != end && found->tag == tag) {
+        return found->vr;
+    }
+#ifdef USE_DCMTK
+    // DCMTK builds read these files too (the mapped fast path): take the
+    // rest from its data dictionary. Ambiguous VRs such as "xs" are skipped.
+    const DcmVR vr = DcmTag(uint16_t(tag >> 16), uint16_t(tag & 0xFFFF)).getVR();
+    if (vr.isStandard()) {
+        return vr.getVRName();
+    }
+#endif
+    return nullptr;
+}
+
+bool is_vr(const char *vr, const char *name) {
+    return vr[0] == name[0] && vr[1] == name[1];
+}
+
+uint64_t read_le(const uint8_t *p, int bytes) {
+    uint64_t value = 0;
+    for (int i = bytes - 1; i >= 0; --i) {
+        value = (value << 8) | p[i];
+    }
+    return value;
+}
+
+// Text form of a binary numeric value, matching what DCMTK gives for the
+// same element: values joined by backslashes. False for VRs that are not
+// kept (OB/OW/..., sequences, unknown).
+bool format_binary_value(const char *vr, const uint8_t *value, uint32_t length, std::string &text) {
+    int size;
+    if (is_vr(vr, "US") || is_vr(vr, "SS")) {
+        size = 2;
+    } else if (is_vr(vr, "UL") || is_vr(vr, "SL") || is_vr(vr, "FL")) {
+        size = 4;
+    } else if (is_vr(vr, "FD") || is_vr(vr, "SV") || is_vr(vr, "UV")) {
+        size = 8;
+    } else if (is_vr(vr, "AT")) {
+        size = 4;
+    } else {
+        return false;
+    }
+    text.clear();
+    char buffer[32];
+    for (uint32_t pos = 0; pos + uint32_t(size) <= length; pos += uint32_t(size)) {
+        const uint64_t raw = read_le(value + pos, size);
+        if (is_vr(vr, "US") || is_vr(vr, "UL") || is_vr(vr, "UV")) {
+            snprintf(buffer, sizeof(buffer), "%llu", (unsigned long long)raw);
+        } else if (is_vr(vr, "SS")) {
+            snprintf(buffer, sizeof(buffer), "%d", int(int16_t(uint16_t(raw))));
+        } else if (is_vr(vr, "SL")) {
+            snprintf(buffer, sizeof(buffer), "%d", int(int32_t(uint32_t(raw))));
+        } else if (is_vr(vr, "SV")) {
+            snprintf(buffer, sizeof(buffer), "%lld", (long long)int64_t(raw));
+        } else if (is_vr(vr, "FL")) {
+            const uint32_t bits = uint32_t(raw);
+            float number;
+            std::memcpy(&number, &bits, sizeof(number));
+            snprintf(buffer, sizeof(buffer), "%.9g", double(number));
+        } else if (is_vr(vr, "FD")) {
+            double number;
+            std::memcpy(&number, &raw, sizeof(number));
+            snprintf(buffer, sizeof(buffer), "%.17g", number);
+        } else {
+            // AT: group then element
+            snprintf(buffer, sizeof(buffer), "(%04X,%04X)", unsigned(raw & 0xFFFF), unsigned(raw >> 16));
+        }
+        if (!text.empty()) {
+            text += '\\';
+        }
+        text += buffer;
+    }
+    return true;
+}
+
+bool is_text_vr(const char *vr) {
+    static const char *const text_vrs[] = { "AE", "AS", "CS", "DA", "DS", "DT", "IS", "LO", "LT", "PN", "SH", "ST", "TM", "UC", "UI", "UR", "UT" };
+    for (const char *candidate : text_vrs) {
+        if (is_vr(vr, candidate)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// A file mapped and walked up to Pixel Data
+struct ParsedFile {
+    std::shared_ptr<MappedFile> file;
+    Part10Reader reader;
+    std::shared_ptr<TagStore> tags;
+    Part10Reader::Element pixel_data;
+    bool has_pixel_data = false;
+    bool has_modality_lut = false;
+    // Shared and Per-Frame Functional Groups Sequences
+    Part10Reader::Element shared_groups;
+    Part10Reader::Element per_frame_groups;
+    bool has_shared_groups = false;
+    bool has_per_frame_groups = false;
+};
+
+// `max_bytes` bounds what builds without mmap read (see MappedFile)
+bool parse_file(const std::string &path, size_t max_bytes, ParsedFile &parsed, std::string &error) {
+    parsed.file = std::make_shared<MappedFile>();
+    if (!parsed.file->open_prefix(path, max_bytes, error)) {
+        return false;
+    }
+    if (!parsed.reader.open(parsed.file->data(), parsed.file->get_size(), error)) {
+        return false;
+    }
+    parsed.reader.set_header_only(parsed.file->is_partial());
+
+    TagStore &tags = *(parsed.tags = std::make_shared<TagStore>());
+    tags.add(0x0002, 0x0010, "UI", parsed.reader.get_transfer_syntax());
+    const bool explicit_vr = parsed.reader.is_explicit_vr();
+    std::string text;
+    const bool walked = parsed.reader.for_each_element([&](const Part10Reader::Element &element) {
+        if (element.group == 0x7FE0 && element.element == 0x0010) {
+            parsed.pixel_data = element;
+            parsed.has_pixel_data = true;
+            return false;
+        }
+        const uint32_t tag = TagStore::make_tag(element.group, element.element);
+        if (tag == 0x00283000) {
+            parsed.has_modality_lut = true;
+        } else if (tag == 0x52009229) {
+            parsed.shared_groups = element;
+            parsed.has_shared_groups = true;
+        } else if (tag == 0x52009230) {
+            parsed.per_frame_groups = element;
+            parsed.has_per_frame_groups = true;
+        }
+        if (!element.value) {
+            return true;
+        }
+        const char *vr = explicit_vr ? element.vr : find_implicit_vr(tag);
+        if (!vr) {
+            return true;
+        }
+        if (is_text_vr(vr)) {
+            tags.add(element.group, element.element, vr, std::string(reinterpret_cast<const char *>(element.value), element.length));
+        } else if (format_binary_value(vr, element.value, element.length, text)) {
+            tags.add(element.group, element.element, vr, text);
+        }
+        return true;
+    }, error);
+    if (!walked) {
+        return false;
+    }
+    tags.finish();
+    return true;
+}
+
+// Value `index` of a backslash-separated numeric element
+bool get_number(const TagStore &tags, uint32_t tag, int index, double &value) {
+    const TagStore::Entry *entry = tags.find(tag);
+    if (!entry) {
+        return false;
+    }
+    const std::string text = tags.get_value(*entry);
+    size_t begin = 0;
+    for (int i = 0; i < index; ++i) {
+        begin = text.find('\\', begin);
+        if (begin == std::string::npos) {
+            return false;
+        }
+        ++begin;
+    }
+    const size_t end = std::min(text.find('\\', begin), text.size());
+    const std::string part = text.substr(begin, end - begin);
+    char *parsed_end = nullptr;
+    const double number = strtod(part.c_str(), &parsed_end);
+    if (parsed_end == part.c_str()) {
+        return false;
+    }
+    value = number;
+    return true;
+}
+
+bool get_int(const TagStore &tags, uint32_t tag, int &value) {
+    double number;
+    if (!get_number(tags, tag, 0, number)) {
+        return false;
+    }
+    value = int(number);
+    return true;
+}
+
+// The first `count` backslash-separated numbers of a text element
+bool parse_numbers(const Part10Reader::Element &element, double *numbers, int count) {
+    if (!element.value) {
+        return false;
+    }
+    const std::string text(reinterpret_cast<const char *>(element.value), element.length);
+    const char *p = text.c_str();
+    for (int i = 0; i < count; ++i) {
+        char *end = nullptr;
+        numbers[i] = strtod(p, &end);
+        if (end == p) {
+            return false;
+        }
+        p = end;
+        while (*p == ' ') {
+            ++p;
+        }
+        if (i + 1 < count) {
+            if (*p != '\\') {
+                return false;
+            }
+            ++p;
+        }
+    }
+    return true;
+}
+
+// One item of a Functional Groups Sequence holds a sequence per functional
+// group, each with a single item of attributes
+bool read_functional_groups(const Part10Reader &reader, const Part10Reader::Element &group, FrameValues &values,
+        std::string &error) {
+    const uint32_t group_tag = TagStore::make_tag(group.group, group.element);
+    return reader.for_each_item_element(group, [&](int, const Part10Reader::Element &element) {
+        const uint32_t tag = TagStore::make_tag(element.group, element.element);
+        double numbers[6];
+        switch (group_tag) {
+            case 0x00289145: // Pixel Value Transformation
+                if (tag == 0x00281053 && parse_numbers(element, numbers, 1)) {
+                    values.rescale_slope = numbers[0];
+                    values.has_rescale = true;
+                } else if (tag == 0x00281052 && parse_numbers(element, numbers, 1)) {
+                    values.rescale_intercept = numbers[0];
+                    values.has_rescale = true;
+                }
+                break;
+            case 0x00289132: // Frame VOI LUT
+                if (tag == 0x00281050 && parse_numbers(element, numbers, 1)) {
+                    values.voi_center = numbers[0];
+                    values.has_voi = true;
+                } else if (tag == 0x00281051 && parse_numbers(element, numbers, 1)) {
+                    values.voi_width = numbers[0];
+                }
+                break;
+            case 0x00209113: // Plane Position (Patient)
+                if (tag == 0x00200032 && parse_numbers(element, numbers, 3)) {
+                    for (int i = 0; i < 3; ++i) values.image_position[i] = numbers[i];
+                    values.has_image_position = true;
+                }
+                break;
+            case 0x00209116: // Plane Orientation (Patient)
+                if (tag == 0x00200037 && parse_numbers(element, numbers, 6)) {
+                    for (int i = 0; i < 6; ++i) values.image_orientation[i] = numbers[i];
+                    values.has_image_orientation = true;
+                }
+                break;
+            case 0x00289110: // Pixel Measures
+                if (tag == 0x00280030 && parse_numbers(element, numbers, 2)) {
+                    values.pixel_spacing_row = numbers[0];
+                    values.pixel_spacing_col = numbers[1];
+                    values.has_pixel_spacing = true;
+                } else if (tag == 0x00180050 && parse_numbers(element, numbers, 1)) {
+                    values.slice_thickness = numbers[0];
+                    values.has_slice_thickness = true;
+                }
+                break;
+            default:
+                return false;
+        }
+        return true;
+    }, error);
+}
+
+// Shared values first, then each frame's own on top. Empty for files
+// without Functional Groups.
+bool read_frame_values(const ParsedFile &parsed, int frame_count, std::vector<FrameValues> &frames, std::string &error) {
+    frames.clear();
+    if (!parsed.has_shared_groups && !parsed.has_per_frame_groups) {
+        return true;
+    }
+    const Part10Reader &reader = parsed.reader;
+    FrameValues shared;
+    bool failed = false;
+    if (parsed.has_shared_groups) {
+        const bool read = reader.for_each_item_element(parsed.shared_groups, [&](int item, const Part10Reader::Element &group) {
+            if (item > 0) {
+                return false;
+            }
+            failed = !read_functional_groups(reader, group, shared, error);
+            return !failed;
+        }, error);
+        if (!read || failed) {
+            return false;
+        }
+    }
+    frames.assign(size_t(std::max(frame_count, 1)), shared);
+    if (parsed.has_per_frame_groups) {
+        const bool read = reader.for_each_item_element(parsed.per_frame_groups, [&](int item, const Part10Reader::Element &group) {
+            if (item >= int(frames.size())) {
+                return false;
+            }
+            failed = !read_functional_groups(reader, group, frames[size_t(item)], error);
+            return !failed;
+        }, error);
+        if (!read || failed) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Same fields, defaults and fallbacks as the DCMTK read_slice_info()
+void fill_slice_info(const TagStore &tags, const std::string &transfer_syntax, SliceInfo &info) {
+    info.modality = tags.get_string(0x00080060);
+    info.photometric_interpretation = tags.get_string(0x00280004);
+    info.transfer_syntax = transfer_syntax;
+    info.study_instance_uid = tags.get_string(0x0020000D);
+    info.series_instance_uid = tags.get_string(0x0020000E);
+    info.sop_instance_uid = tags.get_string(0x00080018);
+
+    info.has_instance_number = get_int(tags, 0x00200013, info.instance_number);
+    double position[3];
+    if (get_number(tags, 0x00200032, 0, position[0]) && get_number(tags, 0x00200032, 1, position[1]) &&
+            get_number(tags, 0x00200032, 2, position[2])) {
+        for (int i = 0; i < 3; ++i) info.image_position[i] = position[i];
+        info.has_image_position = true;
+    }
+    double orientation[6];
+    bool have_orientation = true;
+    for (int i = 0; i < 6 && have_orientation; ++i) {
+        have_orientation = get_number(tags, 0x00200037, i, orientation[i]);
+    }
+    if (have_orientation) {
+        for (int i = 0; i < 6; ++i) info.image_orientation[i] = orientation[i];
+        info.has_image_orientation = true;
+    }
+    get_number(tags, 0x00180050, 0, info.slice_thickness);
+    get_number(tags, 0x00180088, 0, info.spacing_between_slices);
+
+    get_int(tags, 0x00280010, info.rows);
+    get_int(tags, 0x00280011, info.columns);
+    get_int(tags, 0x00280100, info.bits_allocated);
+    get_int(tags, 0x00280101, info.bits_stored);
+    get_int(tags, 0x00280102, info.high_bit);
+    get_int(tags, 0x00280103, info.pixel_representation);
+    if (get_int(tags, 0x00280008, info.frame_count) && info.frame_count < 1) {
+        info.frame_count = 1;
+    }
+
+    double row = 1.0, col = 1.0;
+    if (get_number(tags, 0x00280030, 0, row) && get_number(tags, 0x00280030, 1, col)) {
+        info.has_pixel_spacing = true;
+    } else if (get_number(tags, 0x00181164, 0, row) && get_number(tags, 0x00181164, 1, col)) {
+        info.has_pixel_spacing = true;
+    }
+    if (info.has_pixel_spacing) {
+        info.pixel_spacing_row = row;
+        info.pixel_spacing_col = col;
+    }
+    if (info.has_pixel_spacing && col > 0.0) {
+        info.pixel_aspect_ratio = static_cast<float>(row / col);
+    }
+
+    get_number(tags, 0x00281053, 0, info.rescale_slope);
+    get_number(tags, 0x00281052, 0, info.rescale_intercept);
+    if (get_number(tags, 0x00281050, 0, info.voi_center)) {
+        info.has_voi = true;
+    }
+    get_number(tags, 0x00281051, 0, info.voi_width);
+}
+
+// Copy little endian samples into `pixels`, keeping only the Bits Stored
+// bits (overlays in unused high bits are dropped, signed values extended)
+template <typename T>
+void copy_stored_bits(const uint8_t *src, const SliceInfo &info, PixelBuffer &pixels) {
+    const int bytes = int(sizeof(T));
+    const int bits_stored = info.bits_stored > 0 && info.bits_stored <= bytes * 8 ? info.bits_stored : bytes * 8;
+    int shift = info.high_bit + 1 - bits_stored;
+    if (shift < 0 || shift + bits_stored > bytes * 8) {
+        shift = 0;
+    }
+    const uint64_t mask = bits_stored >= 64 ? ~uint64_t(0) : (uint64_t(1) << bits_stored) - 1;
+    const uint64_t sign_bit = uint64_t(1) << (bits_stored - 1);
+    const bool is_signed = info.pixel_representation == 1;
+
+    T *dst = pixels.allocate<T>(info.columns, info.rows);
+    const size_t width = size_t(info.columns);
+    ThreadPool::get_singleton()->parallel_for(size_t(info.rows), 64, [&](size_t begin, size_t end) {
+        for (size_t i = begin * width; i < end * width; ++i) {
+            uint64_t value = (read_le(src + i * size_t(bytes), bytes) >> shift) & mask;
+            if (is_signed && (value & sign_bit)) {
+                value |= ~mask;
+            }
+            dst[i] = static_cast<T>(value);
+        }
+    });
+    pixels.set_rescale(info.rescale_slope, info.rescale_intercept);
+    pixels.update_range();
+}
+
+void copy_pixels(const uint8_t *src, const SliceInfo &info, PixelBuffer &pixels) {
+    const bool is_signed = info.pixel_representation == 1;
+    switch (info.bits_allocated) {
+        case 8:
+            if (is_signed) {
+                copy_stored_bits<int8_t>(src, info, pixels);
+            } else {
+                copy_stored_bits<uint8_t>(src, info, pixels);
+            }
+            break;
+        case 16:
+            if (is_signed) {
+                copy_stored_bits<int16_t>(src, info, pixels);
+            } else {
+                copy_stored_bits<uint16_t>(src, info, pixels);
+            }
+            break;
+        default:
+            if (is_signed) {
+                copy_stored_bits<int32_t>(src, info, pixels);
+            } else {
+                copy_stored_bits<uint32_t>(src, info, pixels);
+            }
+            break;
+    }
+}
+
+// PackBits as used by DICOM RLE: a control byte n in 0..127 copies the next
+// n + 1 bytes, -127..-1 repeats the next byte 1 - n times, -128 is a no-op.
+// Returns false if the segment ends before `count` bytes were produced.
+bool unpack_rle_segment(const uint8_t *src, size_t length, uint8_t *dst, size_t count) {
+    size_t in = 0;
+    size_t out = 0;
+    while (out < count && in < length) {
+        const int control = int8_t(src[in++]);
+        if (control >= 0) {
+            const size_t run = std::min(size_t(control) + 1, count - out);
+            if (in + run > length) {
+                return false;
+            }
+            std::memcpy(dst + out, src + in, run);
+            in += size_t(control) + 1;
+            out += run;
+        } else if (control != -128) {
+            if (in >= length) {
+                return false;
+            }
+            const size_t run = std::min(size_t(1 - control), count - out);
+            std::memset(dst + out, src[in++], run);
+            out += run;
+        }
+    }
+    return out == count;
+}
+
+// Offsets and lengths of the fragments of encapsulated Pixel Data starting
+// at `offset`, after the Basic Offset Table
+bool read_fragments(const uint8_t *data, size_t size, size_t offset, std::vector<BuiltinFile::Fragment> &fragments,
+        std::string &error) {
+    fragments.clear();
+    size_t pos = offset;
+    bool offset_table = true;
+    for (;;) {
+        if (pos + 8 > size || read_le(data + pos, 2) != 0xFFFE) {
+            error = "Malformed encapsulated Pixel Data";
+            return false;
+        }
+        const uint16_t tag = uint16_t(read_le(data + pos + 2, 2));
+        const uint32_t length = uint32_t(read_le(data + pos + 4, 4));
+        pos += 8;
+        if (tag == 0xE0DD) {
+            return true;
+        }
+        if (tag != 0xE000 || length > size - pos) {
+            error = "Malformed Pixel Data fragment";
+            return false;
+        }
+        if (!offset_table) {
+            fragments.push_back({ pos, length });
+        }
+        offset_table = false;
+        pos += length;
+    }
+}
+
+// Decode one RLE Lossless frame (a single fragment) into little endian
+// samples of Bits Allocated width
+bool decode_rle_frame(const uint8_t *fragment, uint32_t fragment_length, const SliceInfo &info, std::vector<uint8_t> &raw,
+        std::string &error) {
+    if (fragment_length < 64) {
+        error = "RLE fragment too short for its header";
+        return false;
+    }
+
+    const int bytes = info.bits_allocated / 8;
+    const uint32_t segments = uint32_t(read_le(fragment, 4));
+    if (segments != uint32_t(bytes)) {
+        error = "RLE segment count does not match Bits Allocated";
+        return false;
+    }
+    const size_t pixel_count = size_t(info.rows) * size_t(info.columns);
+    raw.assign(pixel_count * size_t(bytes), 0);
+    std::vector<uint8_t> plane(pixel_count);
+    for (int segment = 0; segment < bytes; ++segment) {
+        const uint32_t begin = uint32_t(read_le(fragment + 4 + 4 * segment, 4));
+        const uint32_t end = segment + 1 < bytes ? uint32_t(read_le(fragment + 8 + 4 * segment, 4)) : fragment_length;
+        if (begin < 64 || begin > end || end > fragment_length) {
+            error = "Invalid RLE segment offsets";
+            return false;
+        }
+        if (!unpack_rle_segment(fragment + begin, end - begin, plane.data(), pixel_count)) {
+            error = "RLE segment shorter than the image";
+            return false;
+        }
+        // Segments run from the most significant byte down
+        const int byte_index = bytes - 1 - segment;
+        for (size_t i = 0; i < pixel_count; ++i) {
+            raw[i * size_t(bytes) + size_t(byte_index)] = plane[i];
+        }
+    }
+    return true;
+}
+
+bool check_image(const ParsedFile &parsed, const SliceInfo &info, std::string &error) {
+    if (info.rows <= 0 || info.columns <= 0) {
+        error = "Missing image dimensions (Rows/Columns)";
+        return false;
+    }
+    int samples = 1;
+    get_int(*parsed.tags, 0x00280002, samples);
+    if (samples != 1 || (info.photometric_interpretation != "MONOCHROME1" && info.photometric_interpretation != "MONOCHROME2")) {
+        error = "Colour images need the DCMTK build";
+        return false;
+    }
+    if (info.bits_allocated != 8 && info.bits_allocated != 16 && info.bits_allocated != 32) {
+        error = "Unsupported Bits Allocated: " + std::to_string(info.bits_allocated);
+        return false;
+    }
+    if (!parsed.has_pixel_data) {
+        error = "No Pixel Data";
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+bool builtin_open(const std::string &path, BuiltinFile &file, std::string &error) {
+    ParsedFile parsed;
+    if (!parse_file(path, SIZE_MAX, parsed, error)) {
+        return false;
+    }
+    file.file = parsed.file;
+    file.tags = parsed.tags;
+    file.has_modality_lut = parsed.has_modality_lut;
+    SliceInfo &info = file.info;
+    fill_slice_info(*parsed.tags, parsed.reader.get_transfer_syntax(), info);
+    if (!check_image(parsed, info, error)) {
+        return false;
+    }
+    // A Modality LUT Sequence is not applied; the pixels keep their stored
+    // values with Rescale Slope/Intercept, as for every other file
+
+    const std::string &transfer_syntax = parsed.reader.get_transfer_syntax();
+    const size_t frame_bytes = size_t(info.rows) * size_t(info.columns) * size_t(info.bits_allocated / 8);
+    file.rle = transfer_syntax == TS_RLE_LOSSLESS;
+    if (file.rle) {
+        if (!read_fragments(file.file->data(), file.file->get_size(), parsed.pixel_data.offset, file.fragments, error)) {
+            return false;
+        }
+        // RLE puts each frame in exactly one fragment
+        file.frame_count = int(std::min(file.fragments.size(), size_t(info.frame_count)));
+    } else if (parsed.reader.is_encapsulated()) {
+        error = "Transfer syntax " + transfer_syntax + " needs the DCMTK build";
+        return false;
+    } else {
+        file.pixel_data = parsed.pixel_data.value;
+        file.pixel_data_length = parsed.pixel_data.length;
+        file.frame_count = file.pixel_data ? int(std::min(file.pixel_data_length / frame_bytes, size_t(info.frame_count))) : 0;
+    }
+    if (file.frame_count < 1) {
+        error = "Pixel Data shorter than one frame";
+        return false;
+    }
+    return read_frame_values(parsed, info.frame_count, file.frame_values, error);
+}
+
+void builtin_get_frame_info(const BuiltinFile &file, int index, SliceInfo &info) {
+    info = file.info;
+    if (index >= 0 && size_t(index) < file.frame_values.size()) {
+        file.frame_values[size_t(index)].apply(info);
+    }
+}
+
+bool builtin_decode_frame(const BuiltinFile &file, int index, const SliceInfo &info, PixelBuffer &pixels, DecodeTimings &timings,
+        std::string &error) {
+    if (index < 0 || index >= file.frame_count) {
+        error = "Frame index out of range";
+        return false;
+    }
+    uint64_t stage_start = get_ticks_usec();
+    if (file.rle) {
+        const BuiltinFile::Fragment &fragment = file.fragments[size_t(index)];
+        std::vector<uint8_t> raw;
+        if (!decode_rle_frame(file.file->data() + fragment.offset, fragment.length, info, raw, error)) {
+            return false;
+        }
+        timings.decode_usec = get_ticks_usec() - stage_start;
+        stage_start = get_ticks_usec();
+        copy_pixels(raw.data(), info, pixels);
+        timings.convert_usec = get_ticks_usec() - stage_start;
+        return true;
+    }
+
+    // Use the pixels in place when they are aligned and need no masking
+    const size_t frame_bytes = size_t(info.rows) * size_t(info.columns) * size_t(info.bits_allocated / 8);
+    const uint8_t *frame = file.pixel_data + size_t(index) * frame_bytes;
+    std::string reason;
+    if (map_pixel_data(file.file, frame, frame_bytes, info, pixels, reason)) {
+        timings.decode_usec = get_ticks_usec() - stage_start;
+        timings.convert_usec = 0;
+        return true;
+    }
+    timings.decode_usec = 0;
+    copy_pixels(frame, info, pixels);
+    timings.convert_usec = get_ticks_usec() - stage_start;
+    return true;
+}
+
+bool builtin_read_header(const std::string &path, SliceInfo &info, std::string &error) {
+    // Without mmap the file is copied: read a prefix, growing it until it
+    // holds every element before Pixel Data. Only a prefix that ended too
+    // early is grown; files that are not DICOM, use an unsupported transfer
+    // syntax or are malformed fail the same way at any length.
+    for (size_t limit = HEADER_PREFIX_BYTES;; limit *= 4) {
+        ParsedFile parsed;
+        const bool parsed_ok = parse_file(path, limit, parsed, error);
+        const bool truncated = parsed_ok ? !parsed.has_pixel_data : parsed.reader.is_truncated();
+        if (parsed.file->is_partial() && truncated) {
+            continue;
+        }
+        if (!parsed_ok) {
+            return false;
+        }
+        fill_slice_info(*parsed.tags, parsed.reader.get_transfer_syntax(), info);
+        // Enhanced files: frame 0 stands for the file
+        std::vector<FrameValues> frames;
+        if (!read_frame_values(parsed, 1, frames, error)) {
+            return false;
+        }
+        if (!frames.empty()) {
+            frames[0].apply(info);
+        }
+        return true;
+    }
+}
+
+bool builtin_is_other_format(const std::string &path) {
+    MappedFile file;
+    std::string error;
+    return file.open_prefix(path, 132, error) && !Part10Reader::has_part10_prefix(file.data(), file.get_size());
+}
+
+} // namespace dicom
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "dicom_decoder.h"
+#include "mapped_file.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace dicom {
+
+// DICOM reader used when the extension is built without DCMTK, and by the
+// DCMTK build for uncompressed files it can map in place. It handles
+// Part 10 files in implicit or explicit VR little endian (uncompressed
+// pixels are mapped in place when possible) and RLE Lossless, for
+// single-sample greyscale images. Other compressed transfer syntaxes fail
+// with an error naming them.
+
+// A file opened by the built-in reader: header parsed and Pixel Data
+// located, with frames decoded on request. Read-only once opened, so
+// frames can be decoded from several threads.
+struct BuiltinFile {
+    struct Fragment {
+        size_t offset;
+        uint32_t length;
+    };
+
+    std::shared_ptr<MappedFile> file;
+    SliceInfo info;
+    std::shared_ptr<const TagStore> tags;
+    // Frames actually present, which may be fewer than Number of Frames
+    int frame_count = 0;
+    bool rle = false;
+    // Modality LUT Sequence present; it is not applied
+    bool has_modality_lut = false;
+    // One per frame for enhanced files with Functional Groups, else empty
+    std::vector<FrameValues> frame_values;
+    // Uncompressed Pixel Data
+    const uint8_t *pixel_data = nullptr;
+    size_t pixel_data_length = 0;
+    // RLE: one fragment per frame
+    std::vector<Fragment> fragments;
+};
+
+bool builtin_open(const std::string &path, BuiltinFile &file, std::string &error);
+// Header fields of frame `index`: file.info with that frame's values
+void builtin_get_frame_info(const BuiltinFile &file, int index, SliceInfo &info);
+// `info` is the frame's, from builtin_get_frame_info()
+bool builtin_decode_frame(const BuiltinFile &file, int index, const SliceInfo &info, PixelBuffer &pixels, DecodeTimings &timings,
+        std::string &error);
+
+// Header only; stops at Pixel Data
+bool builtin_read_header(const std::string &path, SliceInfo &info, std::string &error);
+
+// The file can be read but has no Part 10 preamble: some other format
+bool builtin_is_other_format(const std::string &path);
+
+} // namespace dicom
@@ -0,0 +1,238 @@
+#include "case_index.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace dicom {
+
+struct CaseIndex::Header {
+    char magic[4];
+    uint32_t version;
+    uint32_t case_count;
+    uint32_t file_count;
+    uint64_t case_offset;
+    uint64_t file_offset;
+    uint64_t string_offset;
+    uint64_t string_size;
+};
+
+namespace {
+
+const char INDEX_MAGIC[4] = { 'D', 'C', 'I', 'X' };
+// Bump when a record layout or the meaning of a field changes; older files
+// are then rebuilt. 2: modification times in nanoseconds.
+const uint32_t INDEX_VERSION = 2;
+
+class StringTable {
+public:
+    CaseIndex::StringRef add(const std::string &text) {
+        CaseIndex::StringRef ref;
+        ref.offset = uint32_t(bytes.size());
+        ref.length = uint32_t(text.size());
+        bytes.insert(bytes.end(), text.begin(), text.end());
+        return ref;
+    }
+    const std::vector<char> &get_bytes() const { return bytes; }
+
+private:
+    std::vector<char> bytes;
+};
+
+void append(std::vector<uint8_t> &out, const void *data, size_t size) {
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    out.insert(out.end(), bytes, bytes + size);
+}
+
+size_t align8(size_t offset) {
+    return (offset + 7) & ~size_t(7);
+}
+
+} // namespace
+
+bool CaseIndex::open(const std::string &path, std::string &error) {
+    close();
+    if (!file.open(path, error)) {
+        return false;
+    }
+    const uint8_t *data = file.data();
+    const size_t size = file.get_size();
+    const Header *candidate = reinterpret_cast<const Header *>(data);
+    if (size < sizeof(Header) || std::memcmp(candidate->magic, INDEX_MAGIC, 4) != 0 || candidate->version != INDEX_VERSION) {
+        file.close();
+        error = "Not a case index or an older version: " + path;
+        return false;
+    }
+    const uint64_t case_end = candidate->case_offset + uint64_t(candidate->case_count) * sizeof(CaseRecord);
+    const uint64_t file_end = candidate->file_offset + uint64_t(candidate->file_count) * sizeof(FileRecord);
+    if (case_end > size || file_end > size || candidate->string_offset + candidate->string_size > size ||
+            candidate->case_offset % 8 != 0 || candidate->file_offset % 8 != 0) {
+        file.close();
+        error = "Truncated case index: " + path;
+        return false;
+    }
+    header = candidate;
+    cases = reinterpret_cast<const CaseRecord *>(data + header->case_offset);
+    files = reinterpret_cast<const FileRecord *>(data + header->file_offset);
+    strings = reinterpret_cast<const char *>(data + header->string_offset);
+
+    for (uint32_t i = 0; i < header->case_count; ++i) {
+        const CaseRecord &record = cases[i];
+        if (uint64_t(record.first_file) + record.file_count > header->file_count) {
+            close();
+            error = "Corrupt case index: " + path;
+            return false;
+        }
+        case_lookup[get_string(record.path)] = i;
+    }
+    return true;
+}
+
+void CaseIndex::close() {
+    file.close();
+    header = nullptr;
+    cases = nullptr;
+    files = nullptr;
+    strings = nullptr;
+    case_lookup.clear();
+}
+
+uint32_t CaseIndex::get_case_count() const {
+    return header ? header->case_count : 0;
+}
+
+uint32_t CaseIndex::get_file_count() const {
+    return header ? header->file_count : 0;
+}
+
+std::string CaseIndex::get_string(const StringRef &ref) const {
+    if (!header || uint64_t(ref.offset) + ref.length > header->string_size) {
+        return std::string();
+    }
+    return std::string(strings + ref.offset, ref.length);
+}
+
+int CaseIndex::find_case(const std::string &path) const {
+    auto found = case_lookup.find(path);
+    return found != case_lookup.end() ? int(found->second) : -1;
+}
+
+void CaseIndex::read_file(uint32_t index, IndexedFile &out) const {
+    const FileRecord &record = files[index];
+    out.path = get_string(record.path);
+    out.mtime = record.mtime;
+    out.size = record.size;
+    out.has_header = (record.flags & FILE_HAS_HEADER) != 0;
+    out.info = SliceInfo();
+    out.info.study_instance_uid = get_string(record.study_uid);
+    out.info.series_instance_uid = get_string(record.series_uid);
+    out.info.sop_instance_uid = get_string(record.sop_uid);
+    out.info.modality = get_string(record.modality);
+    out.info.rows = record.rows;
+    out.info.columns = record.columns;
+    out.info.instance_number = record.instance_number;
+    out.info.has_instance_number = (record.flags & FILE_HAS_INSTANCE_NUMBER) != 0;
+    std::memcpy(out.info.image_position, record.position, sizeof(record.position));
+    out.info.has_image_position = (record.flags & FILE_HAS_POSITION) != 0;
+    std::memcpy(out.info.image_orientation, record.orientation, sizeof(record.orientation));
+    out.info.has_image_orientation = (record.flags & FILE_HAS_ORIENTATION) != 0;
+}
+
+void CaseIndex::read_case(uint32_t index, IndexedCase &out) const {
+    const CaseRecord &record = cases[index];
+    out.path = get_string(record.path);
+    out.mtime = record.mtime;
+    out.size = record.size;
+    out.name = get_string(record.name);
+    out.description = get_string(record.description);
+    out.question_count = record.question_count;
+    out.files.resize(record.file_count);
+    for (uint32_t i = 0; i < record.file_count; ++i) {
+        read_file(record.first_file + i, out.files[i]);
+    }
+}
+
+bool CaseIndex::write(const std::string &path, const std::vector<IndexedCase> &library, std::string &error) {
+    StringTable table;
+    std::vector<CaseRecord> case_records;
+    std::vector<FileRecord> file_records;
+    case_records.reserve(library.size());
+
+    for (const IndexedCase &entry : library) {
+        CaseRecord record;
+        std::memset(&record, 0, sizeof(record));
+        record.path = table.add(entry.path);
+        record.name = table.add(entry.name);
+        record.description = table.add(entry.description);
+        record.mtime = entry.mtime;
+        record.size = entry.size;
+        record.first_file = uint32_t(file_records.size());
+        record.file_count = uint32_t(entry.files.size());
+        record.question_count = entry.question_count;
+        case_records.push_back(record);
+
+        for (const IndexedFile &indexed : entry.files) {
+            const SliceInfo &info = indexed.info;
+            FileRecord file_record;
+            std::memset(&file_record, 0, sizeof(file_record));
+            file_record.path = table.add(indexed.path);
+            file_record.study_uid = table.add(info.study_instance_uid);
+            file_record.series_uid = table.add(info.series_instance_uid);
+            file_record.sop_uid = table.add(info.sop_instance_uid);
+            file_record.modality = table.add(info.modality);
+            file_record.mtime = indexed.mtime;
+            file_record.size = indexed.size;
+            std::memcpy(file_record.position, info.image_position, sizeof(file_record.position));
+            std::memcpy(file_record.orientation, info.image_orientation, sizeof(file_record.orientation));
+            file_record.instance_number = info.instance_number;
+            file_record.rows = info.rows;
+            file_record.columns = info.columns;
+            file_record.flags = (indexed.has_header ? FILE_HAS_HEADER : 0) |
+                    (info.has_instance_number ? FILE_HAS_INSTANCE_NUMBER : 0) |
+                    (info.has_image_position ? FILE_HAS_POSITION : 0) |
+                    (info.has_image_orientation ? FILE_HAS_ORIENTATION : 0);
+            file_records.push_back(file_record);
+        }
+    }
+
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, INDEX_MAGIC, 4);
+    header.version = INDEX_VERSION;
+    header.case_count = uint32_t(case_records.size());
+    header.file_count = uint32_t(file_records.size());
+    header.case_offset = align8(sizeof(Header));
+    header.file_offset = align8(header.case_offset + case_records.size() * sizeof(CaseRecord));
+    header.string_offset = header.file_offset + file_records.size() * sizeof(FileRecord);
+    header.string_size = table.get_bytes().size();
+
+    std::vector<uint8_t> out;
+    out.reserve(size_t(header.string_offset + header.string_size));
+    append(out, &header, sizeof(header));
+    out.resize(size_t(header.case_offset), 0);
+    append(out, case_records.data(), case_records.size() * sizeof(CaseRecord));
+    out.resize(size_t(header.file_offset), 0);
+    append(out, file_records.data(), file_records.size() * sizeof(FileRecord));
+    append(out, table.get_bytes().data(), table.get_bytes().size());
+
+    const std::string temp_path = path + ".tmp";
+    FILE *handle = open_file(temp_path, "wb");
+    if (!handle) {
+        error = "Cannot write " + temp_path;
+        return false;
+    }
+    const bool written = std::fwrite(out.data(), 1, out.size(), handle) == out.size();
+    const bool closed = std::fclose(handle) == 0;
+    if (!written || !closed) {
+        remove_file(temp_path);
+        error = "Cannot write " + temp_path;
+        return false;
+    }
+    if (!replace_file(temp_path, path)) {
+        remove_file(temp_path);
+        error = "Cannot replace " + path;
+        return false;
+    }
+    return true;
+}
+
+} // namespace dicom
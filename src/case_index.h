@@ -0,0 +1,110 @@
+#pragma once
+
+#include "dicom_decoder.h"
+#include "mapped_file.h"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace dicom {
+
+// One image file referenced by a case, with the header fields the library
+// needs. `mtime`/`size` identify the version of the file that was read.
+struct IndexedFile {
+    std::string path;
+    uint64_t mtime = 0;
+    uint64_t size = 0;
+    // False for files that are missing or not DICOM
+    bool has_header = false;
+    SliceInfo info;
+};
+
+// Case-level metadata plus its files
+struct IndexedCase {
+    std::string path;
+    uint64_t mtime = 0;
+    uint64_t size = 0;
+    std::string name;
+    std::string description;
+    int question_count = 0;
+    std::vector<IndexedFile> files;
+};
+
+// On-disk index of the case library, read through a memory map so opening
+// it costs one mmap regardless of library size. Layout: a header, fixed-size
+// case records, fixed-size file records (each case owns a contiguous run)
+// and a string table the records point into. Records are stored in native
+// byte order; the index is a local cache and is rebuilt if the header does
+// not match.
+class CaseIndex {
+public:
+    struct StringRef {
+        uint32_t offset;
+        uint32_t length;
+    };
+    struct CaseRecord {
+        StringRef path;
+        StringRef name;
+        StringRef description;
+        uint64_t mtime;
+        uint64_t size;
+        uint32_t first_file;
+        uint32_t file_count;
+        int32_t question_count;
+        uint32_t reserved;
+    };
+    // FileRecord::flags
+    static constexpr uint32_t FILE_HAS_HEADER = 1 << 0;
+    static constexpr uint32_t FILE_HAS_INSTANCE_NUMBER = 1 << 1;
+    static constexpr uint32_t FILE_HAS_POSITION = 1 << 2;
+    static constexpr uint32_t FILE_HAS_ORIENTATION = 1 << 3;
+    struct FileRecord {
+        StringRef path;
+        StringRef study_uid;
+        StringRef series_uid;
+        StringRef sop_uid;
+        StringRef modality;
+        uint64_t mtime;
+        uint64_t size;
+        double position[3];
+        double orientation[6];
+        int32_t instance_number;
+        int32_t rows;
+        int32_t columns;
+        uint32_t flags;
+    };
+
+    bool open(const std::string &path, std::string &error);
+    void close();
+    bool is_open() const { return header != nullptr; }
+
+    uint32_t get_case_count() const;
+    uint32_t get_file_count() const;
+    const CaseRecord &get_case(uint32_t index) const { return cases[index]; }
+    const FileRecord &get_file(uint32_t index) const { return files[index]; }
+    std::string get_string(const StringRef &ref) const;
+    // Index of the case stored for `path`, or -1
+    int find_case(const std::string &path) const;
+
+    // Copy records back into editable form
+    void read_case(uint32_t index, IndexedCase &out) const;
+    void read_file(uint32_t index, IndexedFile &out) const;
+
+    // Serialize `library` to `path`. Written to a temporary file first and
+    // renamed over the old index, so readers never see a partial file.
+    static bool write(const std::string &path, const std::vector<IndexedCase> &library, std::string &error);
+
+private:
+    struct Header;
+
+    MappedFile file;
+    const Header *header = nullptr;
+    const CaseRecord *cases = nullptr;
+    const FileRecord *files = nullptr;
+    const char *strings = nullptr;
+    std::unordered_map<std::string, uint32_t> case_lookup;
+};
+
+} // namespace dicom
@@ -0,0 +1,225 @@
+#include "case_library_index.h"
+#include "dicom_viewer.h"
+#include "radiology_case.h"
+#include "thread_pool.h"
+
+#include <string>
+#include <vector>
+
+#include <godot_cpp/classes/dir_access.hpp>
+#include <godot_cpp/classes/resource_loader.hpp>
+#include <godot_cpp/classes/time.hpp>
+#include <godot_cpp/core/class_db.hpp>
+#include <godot_cpp/variant/packed_string_array.hpp>
+#include <godot_cpp/variant/utility_functions.hpp>
+#include <godot_cpp/variant/vector3.hpp>
+
+using namespace godot;
+
+static String to_string(const std::string &text) {
+    return String::utf8(text.c_str(), (int64_t)text.size());
+}
+
+void CaseLibraryIndex::_bind_methods() {
+    ClassDB::bind_method(D_METHOD("set_index_path", "path"), &CaseLibraryIndex::set_index_path);
+    ClassDB::bind_method(D_METHOD("get_index_path"), &CaseLibraryIndex::get_index_path);
+    ClassDB::bind_method(D_METHOD("update", "cases_dir"), &CaseLibraryIndex::update, DEFVAL("user://cases"));
+    ClassDB::bind_method(D_METHOD("get_update_stats"), &CaseLibraryIndex::get_update_stats);
+    ClassDB::bind_method(D_METHOD("get_case_count"), &CaseLibraryIndex::get_case_count);
+    ClassDB::bind_method(D_METHOD("get_case", "case_index"), &CaseLibraryIndex::get_case);
+    ClassDB::bind_method(D_METHOD("find_case", "path"), &CaseLibraryIndex::find_case);
+    ClassDB::bind_method(D_METHOD("get_case_file_paths", "case_index"), &CaseLibraryIndex::get_case_file_paths);
+    ClassDB::bind_method(D_METHOD("get_case_files", "case_index"), &CaseLibraryIndex::get_case_files);
+
+    ADD_PROPERTY(PropertyInfo(Variant::STRING, "index_path"), "set_index_path", "get_index_path");
+}
+
+CaseLibraryIndex::CaseLibraryIndex() {
+    index_path = "user://case_index.bin";
+}
+
+void CaseLibraryIndex::set_index_path(const String &path) {
+    index_path = path;
+    index.close();
+}
+
+void CaseLibraryIndex::open_index() {
+    std::string error;
+    if (!index.open(DicomViewer::globalize_path(index_path).utf8().get_data(), error)) {
+        index.close();
+    }
+}
+
+int CaseLibraryIndex::update(const String &cases_dir) {
+    const uint64_t update_start = Time::get_singleton()->get_ticks_usec();
+    if (!index.is_open()) {
+        open_index();
+    }
+
+    // Cases: reuse the stored record while the resource file is unchanged
+    std::vector<dicom::IndexedCase> library;
+    int cases_reloaded = 0;
+    const PackedStringArray names = DirAccess::get_files_at(cases_dir);
+    for (int i = 0; i < names.size(); ++i) {
+        if (!names[i].ends_with(".tres") && !names[i].ends_with(".res")) {
+            continue;
+        }
+        const String path = cases_dir.path_join(names[i]);
+        const std::string key = path.utf8().get_data();
+        uint64_t mtime = 0, size = 0;
+        if (!dicom::get_file_stat(DicomViewer::globalize_path(path).utf8().get_data(), mtime, size)) {
+            continue;
+        }
+
+        dicom::IndexedCase entry;
+        const int stored = index.find_case(key);
+        if (stored >= 0 && index.get_case((uint32_t)stored).mtime == mtime && index.get_case((uint32_t)stored).size == size) {
+            index.read_case((uint32_t)stored, entry);
+            library.push_back(std::move(entry));
+            continue;
+        }
+
+        Ref<RadiologyCase> loaded = ResourceLoader::get_singleton()->load(path);
+        if (loaded.is_null()) {
+            UtilityFunctions::push_error("Failed to load case: ", path);
+            continue;
+        }
+        ++cases_reloaded;
+        entry.path = key;
+        entry.mtime = mtime;
+        entry.size = size;
+        entry.name = loaded->get_case_name().utf8().get_data();
+        entry.description = loaded->get_case_description().utf8().get_data();
+        entry.question_count = (int)loaded->get_questions().size();
+        const Array paths = loaded->get_dicom_file_paths();
+        entry.files.resize(paths.size());
+        for (int j = 0; j < paths.size(); ++j) {
+            const String file_path = paths[j];
+            entry.files[j].path = file_path.utf8().get_data();
+            // Keep headers already indexed for this file under another case
+            // version; the stat below decides whether they are still valid
+            for (uint32_t k = 0; stored >= 0 && k < index.get_case((uint32_t)stored).file_count; ++k) {
+                const uint32_t record = index.get_case((uint32_t)stored).first_file + k;
+                if (index.get_string(index.get_file(record).path) == entry.files[j].path) {
+                    index.read_file(record, entry.files[j]);
+                    break;
+                }
+            }
+        }
+        library.push_back(std::move(entry));
+    }
+
+    // Files: stat everything in parallel and re-read headers that changed
+    std::vector<dicom::IndexedFile *> files;
+    std::vector<std::string> absolute_paths;
+    for (dicom::IndexedCase &entry : library) {
+        for (dicom::IndexedFile &file : entry.files) {
+            files.push_back(&file);
+            absolute_paths.push_back(DicomViewer::globalize_path(to_string(file.path)).utf8().get_data());
+        }
+    }
+    std::vector<uint8_t> reread(files.size(), 0);
+    dicom::ThreadPool::get_singleton()->parallel_for(files.size(), 16, [&](size_t begin, size_t end) {
+        std::string error;
+        for (size_t i = begin; i < end; ++i) {
+            dicom::IndexedFile &file = *files[i];
+            uint64_t mtime = 0, size = 0;
+            if (!dicom::get_file_stat(absolute_paths[i], mtime, size)) {
+                mtime = size = 0;
+            }
+            if (mtime == file.mtime && size == file.size) {
+                continue;
+            }
+            reread[i] = 1;
+            file.mtime = mtime;
+            file.size = size;
+            file.info = dicom::SliceInfo();
+            file.has_header = size > 0 && dicom::read_dicom_header(absolute_paths[i], file.info, error);
+        }
+    });
+    int files_reread = 0;
+    for (uint8_t flag : reread) {
+        files_reread += flag;
+    }
+
+    // Rewrite only when something changed, including removed cases
+    bool written = false;
+    if (cases_reloaded > 0 || files_reread > 0 || library.size() != index.get_case_count()) {
+        const std::string path = DicomViewer::globalize_path(index_path).utf8().get_data();
+        // Unmap first; Windows cannot replace a mapped file
+        index.close();
+        std::string error;
+        written = dicom::CaseIndex::write(path, library, error);
+        if (!written) {
+            UtilityFunctions::push_error("Failed to write case index: ", to_string(error));
+        }
+        open_index();
+    }
+
+    update_stats = Dictionary();
+    update_stats["cases"] = (int64_t)library.size();
+    update_stats["cases_reloaded"] = cases_reloaded;
+    update_stats["files"] = (int64_t)files.size();
+    update_stats["files_reread"] = files_reread;
+    update_stats["written"] = written;
+    update_stats["update_usec"] = (int64_t)(Time::get_singleton()->get_ticks_usec() - update_start);
+    return (int)library.size();
+}
+
+Dictionary CaseLibraryIndex::get_case(int case_index) const {
+    Dictionary result;
+    if (case_index < 0 || case_index >= get_case_count()) {
+        return result;
+    }
+    const dicom::CaseIndex::CaseRecord &record = index.get_case((uint32_t)case_index);
+    result["path"] = to_string(index.get_string(record.path));
+    result["name"] = to_string(index.get_string(record.name));
+    result["description"] = to_string(index.get_string(record.description));
+    result["question_count"] = record.question_count;
+    result["file_count"] = (int64_t)record.file_count;
+    return result;
+}
+
+int CaseLibraryIndex::find_case(const String &path) const {
+    return index.find_case(path.utf8().get_data());
+}
+
+Array CaseLibraryIndex::get_case_file_paths(int case_index) const {
+    Array paths;
+    if (case_index < 0 || case_index >= get_case_count()) {
+        return paths;
+    }
+    const dicom::CaseIndex::CaseRecord &record = index.get_case((uint32_t)case_index);
+    for (uint32_t i = 0; i < record.file_count; ++i) {
+        paths.append(to_string(index.get_string(index.get_file(record.first_file + i).path)));
+    }
+    return paths;
+}
+
+Array CaseLibraryIndex::get_case_files(int case_index) const {
+    Array result;
+    if (case_index < 0 || case_index >= get_case_count()) {
+        return result;
+    }
+    const dicom::CaseIndex::CaseRecord &record = index.get_case((uint32_t)case_index);
+    for (uint32_t i = 0; i < record.file_count; ++i) {
+        const dicom::CaseIndex::FileRecord &file = index.get_file(record.first_file + i);
+        Dictionary item;
+        item["path"] = to_string(index.get_string(file.path));
+        item["has_header"] = (file.flags & dicom::CaseIndex::FILE_HAS_HEADER) != 0;
+        item["study_instance_uid"] = to_string(index.get_string(file.study_uid));
+        item["series_instance_uid"] = to_string(index.get_string(file.series_uid));
+        item["sop_instance_uid"] = to_string(index.get_string(file.sop_uid));
+        item["modality"] = to_string(index.get_string(file.modality));
+        item["rows"] = file.rows;
+        item["columns"] = file.columns;
+        if (file.flags & dicom::CaseIndex::FILE_HAS_INSTANCE_NUMBER) {
+            item["instance_number"] = file.instance_number;
+        }
+        if (file.flags & dicom::CaseIndex::FILE_HAS_POSITION) {
+            item["image_position"] = Vector3((real_t)file.position[0], (real_t)file.position[1], (real_t)file.position[2]);
+        }
+        result.append(item);
+    }
+    return result;
+}
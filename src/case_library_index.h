@@ -0,0 +1,53 @@
+#pragma once
+
+#include "case_index.h"
+
+#include <godot_cpp/classes/ref_counted.hpp>
+#include <godot_cpp/variant/array.hpp>
+#include <godot_cpp/variant/dictionary.hpp>
+#include <godot_cpp/variant/string.hpp>
+
+namespace godot {
+
+// Persistent index of the case library and the DICOM headers of every file
+// the cases reference. update() only reloads cases and re-reads headers of
+// files whose modification time or size changed, so startup cost stays
+// flat as the library grows.
+class CaseLibraryIndex : public RefCounted {
+    GDCLASS(CaseLibraryIndex, RefCounted);
+
+private:
+    String index_path;
+    dicom::CaseIndex index;
+    Dictionary update_stats;
+
+    // Map the index at `index_path`; a missing or stale file is not an error
+    void open_index();
+
+protected:
+    static void _bind_methods();
+
+public:
+    CaseLibraryIndex();
+
+    void set_index_path(const String &path);
+    String get_index_path() const { return index_path; }
+
+    // Bring the index up to date with the .tres/.res cases in `cases_dir`.
+    // Returns the number of cases in the library.
+    int update(const String &cases_dir);
+    // cases, cases_reloaded, files, files_reread, written, update_usec
+    Dictionary get_update_stats() const { return update_stats; }
+
+    int get_case_count() const { return (int)index.get_case_count(); }
+    // path, name, description, question_count, file_count
+    Dictionary get_case(int case_index) const;
+    // Index of the case saved at `path`, or -1
+    int find_case(const String &path) const;
+    Array get_case_file_paths(int case_index) const;
+    // Per-file header fields: path, has_header, study/series/SOP instance
+    // UIDs, modality, instance_number, image_position, rows, columns
+    Array get_case_files(int case_index) const;
+};
+
+}
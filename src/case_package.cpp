@@ -0,0 +1,438 @@
+#include "case_package.h"
+
+#include <algorithm>
+#include <vector>
+
+#include <godot_cpp/classes/dir_access.hpp>
+#include <godot_cpp/classes/file_access.hpp>
+#include <godot_cpp/core/class_db.hpp>
+#include <godot_cpp/variant/array.hpp>
+#include <godot_cpp/variant/packed_byte_array.hpp>
+#include <godot_cpp/variant/utility_functions.hpp>
+
+using namespace godot;
+
+// "RCPK"
+static const uint32_t PACKAGE_MAGIC = 0x4B504352;
+// Version 1 was the JSON/base64 format
+static const uint32_t PACKAGE_VERSION = 2;
+// Header: magic, version, flags, reserved, table offset
+static const uint64_t TABLE_OFFSET_POSITION = 16;
+static const uint64_t HEADER_SIZE = 24;
+// Header flags
+static const uint32_t PACKAGE_COMPRESSED = 1 << 0;
+static const int64_t PACKAGE_COMPRESSION = FileAccess::COMPRESSION_ZSTD;
+// Raw and stored size
+static const uint64_t CHUNK_HEADER_SIZE = 8;
+
+enum EntryKind : uint32_t {
+    ENTRY_DICOM = 0,
+    ENTRY_IMAGE = 1,
+};
+
+namespace {
+
+struct Entry {
+    String name;
+    uint32_t kind = ENTRY_DICOM;
+    // File the entry is exported from
+    String source;
+    uint64_t offset = 0;
+    uint64_t size = 0;
+    uint64_t stored_size = 0;
+    uint32_t chunk_count = 0;
+};
+
+struct Table {
+    uint32_t flags = 0;
+    uint64_t offset = 0;
+    Dictionary case_data;
+    std::vector<Entry> entries;
+};
+
+// Replace every file path in `case_data` through `dicom_map` and
+// `image_map`; paths missing from the maps are dropped
+void remap_paths(Dictionary &case_data, const Dictionary &dicom_map, const Dictionary &image_map) {
+    const Array paths = case_data.get("dicom_file_paths", Array());
+    Array mapped_paths;
+    for (int i = 0; i < paths.size(); ++i) {
+        if (dicom_map.has(paths[i])) {
+            mapped_paths.append(dicom_map[paths[i]]);
+        }
+    }
+    case_data["dicom_file_paths"] = mapped_paths;
+
+    const Array questions = case_data.get("questions", Array());
+    for (int i = 0; i < questions.size(); ++i) {
+        if (questions[i].get_type() != Variant::DICTIONARY) {
+            continue;
+        }
+        const Dictionary question = questions[i];
+        if (question.get("explanation", Variant()).get_type() != Variant::DICTIONARY) {
+            continue;
+        }
+        // Dictionaries are shared, so this edits `case_data` in place
+        Dictionary explanation = question["explanation"];
+        const Array images = explanation.get("images", Array());
+        Array mapped_images;
+        for (int j = 0; j < images.size(); ++j) {
+            if (image_map.has(images[j])) {
+                mapped_images.append(image_map[images[j]]);
+            }
+        }
+        explanation["images"] = mapped_images;
+    }
+}
+
+// Add `source` as an entry named after its file, made unique within the
+// package. Files already added or missing are skipped.
+void add_entry(const String &source, uint32_t kind, Dictionary &map, Dictionary &used_names, std::vector<Entry> &entries) {
+    if (map.has(source)) {
+        return;
+    }
+    if (!FileAccess::file_exists(source)) {
+        UtilityFunctions::push_warning("Case file not found, leaving it out of the package: ", source);
+        return;
+    }
+    String name = source.get_file();
+    for (int counter = 1; used_names.has(name); ++counter) {
+        const String extension = source.get_extension();
+        name = source.get_file().get_basename() + "_" + String::num_int64(counter) + (extension.is_empty() ? String() : "." + extension);
+    }
+    used_names[name] = true;
+    map[source] = name;
+
+    Entry entry;
+    entry.name = name;
+    entry.kind = kind;
+    entry.source = source;
+    entries.push_back(entry);
+}
+
+bool write_entry(FileAccess &out, Entry &entry, bool compress, String &error) {
+    Ref<FileAccess> in = FileAccess::open(entry.source, FileAccess::READ);
+    if (in.is_null()) {
+        error = "Failed to open " + entry.source;
+        return false;
+    }
+    entry.offset = out.get_position();
+    entry.size = in->get_length();
+    for (uint64_t remaining = entry.size; remaining > 0;) {
+        const int64_t raw_size = (int64_t)std::min<uint64_t>(remaining, CasePackage::CHUNK_SIZE);
+        const PackedByteArray raw = in->get_buffer(raw_size);
+        if (raw.size() != raw_size) {
+            error = "Failed to read " + entry.source;
+            return false;
+        }
+        // Keep the chunk raw when compression does not shrink it
+        PackedByteArray stored = raw;
+        if (compress) {
+            const PackedByteArray packed = raw.compress(PACKAGE_COMPRESSION);
+            if (packed.size() > 0 && packed.size() < raw.size()) {
+                stored = packed;
+            }
+        }
+        out.store_32((uint32_t)raw_size);
+        out.store_32((uint32_t)stored.size());
+        out.store_buffer(stored);
+        remaining -= (uint64_t)raw_size;
+        entry.stored_size += (uint64_t)stored.size();
+        ++entry.chunk_count;
+    }
+    return true;
+}
+
+bool read_table(FileAccess &file, Table &table, String &error) {
+    const uint64_t length = file.get_length();
+    if (length < HEADER_SIZE || file.get_32() != PACKAGE_MAGIC) {
+        error = "Not a case package";
+        return false;
+    }
+    const uint32_t version = file.get_32();
+    if (version != PACKAGE_VERSION) {
+        error = "Unsupported case package version " + String::num_int64(version);
+        return false;
+    }
+    table.flags = file.get_32();
+    file.get_32();
+    table.offset = file.get_64();
+    if (table.offset < HEADER_SIZE || table.offset + 8 > length) {
+        error = "Truncated case package";
+        return false;
+    }
+
+    file.seek(table.offset);
+    const uint32_t case_size = file.get_32();
+    if (case_size > length - file.get_position()) {
+        error = "Truncated case package";
+        return false;
+    }
+    const Variant case_data = UtilityFunctions::bytes_to_var(file.get_buffer(case_size));
+    if (case_data.get_type() != Variant::DICTIONARY) {
+        error = "Invalid case data";
+        return false;
+    }
+    table.case_data = case_data;
+
+    const uint32_t entry_count = file.get_32();
+    table.entries.clear();
+    for (uint32_t i = 0; i < entry_count && !file.eof_reached(); ++i) {
+        Entry entry;
+        entry.name = file.get_pascal_string();
+        entry.kind = file.get_32();
+        entry.offset = file.get_64();
+        entry.size = file.get_64();
+        entry.stored_size = file.get_64();
+        entry.chunk_count = file.get_32();
+        // Names become file names on import, so they must not carry a path
+        if (entry.name.is_empty() || entry.name != entry.name.get_file() || entry.name == "." || entry.name == "..") {
+            error = "Invalid file name in case package: " + entry.name;
+            return false;
+        }
+        if (entry.kind != ENTRY_DICOM && entry.kind != ENTRY_IMAGE) {
+            error = "Unknown file kind in case package";
+            return false;
+        }
+        const uint64_t end = entry.offset + entry.stored_size + uint64_t(entry.chunk_count) * CHUNK_HEADER_SIZE;
+        if (entry.offset < HEADER_SIZE || end < entry.offset || end > table.offset) {
+            error = "Invalid file record in case package: " + entry.name;
+            return false;
+        }
+        table.entries.push_back(entry);
+    }
+    if (file.eof_reached() || table.entries.size() != entry_count) {
+        error = "Truncated case package";
+        return false;
+    }
+    return true;
+}
+
+bool extract_chunks(FileAccess &file, const Table &table, const Entry &entry, FileAccess &out, String &error) {
+    file.seek(entry.offset);
+    uint64_t written = 0;
+    for (uint32_t i = 0; i < entry.chunk_count; ++i) {
+        const uint32_t raw_size = file.get_32();
+        const uint32_t stored_size = file.get_32();
+        const bool compressed = stored_size < raw_size;
+        if (raw_size == 0 || raw_size > CasePackage::CHUNK_SIZE || stored_size > raw_size ||
+                raw_size > entry.size - written || (compressed && !(table.flags & PACKAGE_COMPRESSED))) {
+            error = "Corrupt chunk in " + entry.name;
+            return false;
+        }
+        const PackedByteArray stored = file.get_buffer(stored_size);
+        if (stored.size() != (int64_t)stored_size) {
+            error = "Truncated chunk in " + entry.name;
+            return false;
+        }
+        if (compressed) {
+            const PackedByteArray raw = stored.decompress(raw_size, PACKAGE_COMPRESSION);
+            if (raw.size() != (int64_t)raw_size) {
+                error = "Failed to decompress " + entry.name;
+                return false;
+            }
+            out.store_buffer(raw);
+        } else {
+            out.store_buffer(stored);
+        }
+        written += raw_size;
+    }
+    if (written != entry.size) {
+        error = "Truncated file in case package: " + entry.name;
+        return false;
+    }
+    return true;
+}
+
+// Written to a temporary name and renamed into place, so an existing file
+// (which may be mapped by the slice cache) is never truncated and a failed
+// import leaves nothing behind at `target`
+bool extract_entry(FileAccess &file, const Table &table, const Entry &entry, const String &target, String &error) {
+    if (FileAccess::file_exists(target)) {
+        error = "File already exists: " + target;
+        return false;
+    }
+    const String temp_path = target + ".tmp";
+    Ref<FileAccess> out = FileAccess::open(temp_path, FileAccess::WRITE);
+    if (out.is_null()) {
+        error = "Failed to create " + target;
+        return false;
+    }
+    const bool extracted = extract_chunks(file, table, entry, *out.ptr(), error);
+    const bool written = out->get_error() == OK;
+    out.unref();
+    if (!extracted || !written || DirAccess::rename_absolute(temp_path, target) != OK) {
+        DirAccess::remove_absolute(temp_path);
+        if (extracted) {
+            error = "Failed to write " + target;
+        }
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+void CasePackage::_bind_methods() {
+    ClassDB::bind_static_method("CasePackage", D_METHOD("export_case", "radiology_case", "path", "compress"), &CasePackage::export_case, DEFVAL(true));
+    ClassDB::bind_static_method("CasePackage", D_METHOD("is_package", "path"), &CasePackage::is_package);
+    ClassDB::bind_static_method("CasePackage", D_METHOD("list_package", "path"), &CasePackage::list_package);
+    ClassDB::bind_static_method("CasePackage", D_METHOD("import_case", "path", "dicom_dir", "images_dir", "name_suffix"), &CasePackage::import_case, DEFVAL(""));
+}
+
+bool CasePackage::export_case(const Ref<RadiologyCase> &radiology_case, const String &path, bool compress) {
+    if (radiology_case.is_null()) {
+        UtilityFunctions::push_error("No case to export");
+        return false;
+    }
+    // to_dict() shares the case's arrays; the copy gets entry names
+    Dictionary case_data = radiology_case->to_dict().duplicate(true);
+
+    Table table;
+    table.flags = compress ? PACKAGE_COMPRESSED : 0;
+    Dictionary dicom_map, image_map, used_names;
+    const Array paths = case_data.get("dicom_file_paths", Array());
+    for (int i = 0; i < paths.size(); ++i) {
+        add_entry(paths[i], ENTRY_DICOM, dicom_map, used_names, table.entries);
+    }
+    const Array questions = case_data.get("questions", Array());
+    for (int i = 0; i < questions.size(); ++i) {
+        if (questions[i].get_type() != Variant::DICTIONARY) {
+            continue;
+        }
+        const Dictionary question = questions[i];
+        if (question.get("explanation", Variant()).get_type() != Variant::DICTIONARY) {
+            continue;
+        }
+        const Dictionary explanation = question["explanation"];
+        const Array images = explanation.get("images", Array());
+        for (int j = 0; j < images.size(); ++j) {
+            add_entry(images[j], ENTRY_IMAGE, image_map, used_names, table.entries);
+        }
+    }
+    remap_paths(case_data, dicom_map, image_map);
+
+    // Written next to the target and renamed over it at the end, so a
+    // failed export never leaves a partial package behind
+    const String temp_path = path + ".tmp";
+    Ref<FileAccess> out = FileAccess::open(temp_path, FileAccess::WRITE);
+    if (out.is_null()) {
+        UtilityFunctions::push_error("Failed to create case package: ", path);
+        return false;
+    }
+    out->store_32(PACKAGE_MAGIC);
+    out->store_32(PACKAGE_VERSION);
+    out->store_32(table.flags);
+    out->store_32(0);
+    out->store_64(0);
+
+    String error;
+    for (Entry &entry : table.entries) {
+        if (!write_entry(*out.ptr(), entry, compress, error)) {
+            out.unref();
+            DirAccess::remove_absolute(temp_path);
+            UtilityFunctions::push_error("Failed to export case: ", error);
+            return false;
+        }
+    }
+
+    table.offset = out->get_position();
+    const PackedByteArray case_bytes = UtilityFunctions::var_to_bytes(case_data);
+    out->store_32((uint32_t)case_bytes.size());
+    out->store_buffer(case_bytes);
+    out->store_32((uint32_t)table.entries.size());
+    for (const Entry &entry : table.entries) {
+        out->store_pascal_string(entry.name);
+        out->store_32(entry.kind);
+        out->store_64(entry.offset);
+        out->store_64(entry.size);
+        out->store_64(entry.stored_size);
+        out->store_32(entry.chunk_count);
+    }
+    out->seek(TABLE_OFFSET_POSITION);
+    out->store_64(table.offset);
+    const bool written = out->get_error() == OK;
+    out.unref();
+
+    if (!written || DirAccess::rename_absolute(temp_path, path) != OK) {
+        DirAccess::remove_absolute(temp_path);
+        UtilityFunctions::push_error("Failed to write case package: ", path);
+        return false;
+    }
+    return true;
+}
+
+bool CasePackage::is_package(const String &path) {
+    Ref<FileAccess> file = FileAccess::open(path, FileAccess::READ);
+    return file.is_valid() && file->get_length() >= HEADER_SIZE && file->get_32() == PACKAGE_MAGIC;
+}
+
+Dictionary CasePackage::list_package(const String &path) {
+    Dictionary result;
+    Ref<FileAccess> file = FileAccess::open(path, FileAccess::READ);
+    if (file.is_null()) {
+        UtilityFunctions::push_error("Failed to open case package: ", path);
+        return result;
+    }
+    Table table;
+    String error;
+    if (!read_table(*file.ptr(), table, error)) {
+        UtilityFunctions::push_error(error, ": ", path);
+        return result;
+    }
+    Array entries;
+    for (const Entry &entry : table.entries) {
+        Dictionary item;
+        item["name"] = entry.name;
+        item["kind"] = entry.kind == ENTRY_DICOM ? "dicom" : "image";
+        item["size"] = (int64_t)entry.size;
+        item["stored_size"] = (int64_t)entry.stored_size;
+        entries.append(item);
+    }
+    result["version"] = (int64_t)PACKAGE_VERSION;
+    result["compressed"] = (table.flags & PACKAGE_COMPRESSED) != 0;
+    result["case_data"] = table.case_data;
+    result["entries"] = entries;
+    return result;
+}
+
+Ref<RadiologyCase> CasePackage::import_case(const String &path, const String &dicom_dir, const String &images_dir, const String &name_suffix) {
+    Ref<FileAccess> file = FileAccess::open(path, FileAccess::READ);
+    if (file.is_null()) {
+        UtilityFunctions::push_error("Failed to open case package: ", path);
+        return Ref<RadiologyCase>();
+    }
+    Table table;
+    String error;
+    if (!read_table(*file.ptr(), table, error)) {
+        UtilityFunctions::push_error(error, ": ", path);
+        return Ref<RadiologyCase>();
+    }
+
+    DirAccess::make_dir_recursive_absolute(dicom_dir);
+    DirAccess::make_dir_recursive_absolute(images_dir);
+    Dictionary dicom_map, image_map;
+    std::vector<String> extracted;
+    for (const Entry &entry : table.entries) {
+        String file_name = entry.name;
+        if (!name_suffix.is_empty()) {
+            const String extension = entry.name.get_extension();
+            file_name = entry.name.get_basename() + "_" + name_suffix + (extension.is_empty() ? String() : "." + extension);
+        }
+        const String target = (entry.kind == ENTRY_DICOM ? dicom_dir : images_dir).path_join(file_name);
+        if (!extract_entry(*file.ptr(), table, entry, target, error)) {
+            for (const String &done : extracted) {
+                DirAccess::remove_absolute(done);
+            }
+            UtilityFunctions::push_error("Failed to import case: ", error);
+            return Ref<RadiologyCase>();
+        }
+        extracted.push_back(target);
+        (entry.kind == ENTRY_DICOM ? dicom_map : image_map)[entry.name] = target;
+    }
+
+    remap_paths(table.case_data, dicom_map, image_map);
+    Ref<RadiologyCase> result;
+    result.instantiate();
+    result->from_dict(table.case_data);
+    return result;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "radiology_case.h"
+
+#include <godot_cpp/classes/ref_counted.hpp>
+#include <godot_cpp/variant/dictionary.hpp>
+#include <godot_cpp/variant/string.hpp>
+
+namespace godot {
+
+// Binary .radcase container for exporting a case with its DICOM files and
+// explanation images. Layout (little endian): a header, then every file as
+// a run of chunks (raw and stored size, then the bytes, compressed when that
+// makes the chunk smaller), then a table holding the case (var_to_bytes of
+// RadiologyCase::to_dict with file paths replaced by entry names) and one
+// record per file. Files are streamed a chunk at a time in both directions,
+// so memory use does not grow with the case, and the table can be read on
+// its own to list a package without extracting it.
+class CasePackage : public RefCounted {
+    GDCLASS(CasePackage, RefCounted);
+
+public:
+    static constexpr uint32_t CHUNK_SIZE = 1 << 20;
+
+    // Write `radiology_case` and the files it references to `path`.
+    // Missing files are left out of the package with a warning.
+    static bool export_case(const Ref<RadiologyCase> &radiology_case, const String &path, bool compress);
+    // True if `path` starts with the package header
+    static bool is_package(const String &path);
+    // version, compressed, case_data and entries (name, kind, size,
+    // stored_size); empty if `path` is not a readable package
+    static Dictionary list_package(const String &path);
+    // Extract DICOM files into `dicom_dir` and images into `images_dir`,
+    // adding `name_suffix` to each file name, and return the case pointing
+    // at the extracted copies. Existing files are never overwritten: a name
+    // that is already taken fails the import. Returns a null Ref (and
+    // removes anything this import extracted) on failure.
+    static Ref<RadiologyCase> import_case(const String &path, const String &dicom_dir, const String &images_dir, const String &name_suffix);
+
+protected:
+    static void _bind_methods();
+};
+
+}
@@ -0,0 +1,383 @@
+#include "decoded_file.h"
+#include "mapped_file.h"
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace dicom {
+
+namespace {
+
+const char DECODED_MAGIC[4] = { 'D', 'C', 'D', 'F' };
+// Bump when the layout changes; older files then miss
+const uint32_t DECODED_VERSION = 2;
+const size_t PIXEL_ALIGNMENT = 64;
+
+struct StringRef {
+    uint64_t offset;
+    uint64_t length;
+};
+
+// SliceInfo strings, in this order, then the source path
+enum {
+    STRING_MODALITY,
+    STRING_TRANSFER_SYNTAX,
+    STRING_PHOTOMETRIC,
+    STRING_STUDY_UID,
+    STRING_SERIES_UID,
+    STRING_SOP_UID,
+    STRING_SOURCE_PATH,
+    STRING_COUNT,
+};
+
+// Header flags
+const uint32_t HAS_PIXEL_SPACING = 1 << 0;
+const uint32_t HAS_INSTANCE_NUMBER = 1 << 1;
+const uint32_t HAS_IMAGE_POSITION = 1 << 2;
+const uint32_t HAS_IMAGE_ORIENTATION = 1 << 3;
+const uint32_t HAS_VOI = 1 << 4;
+
+struct Header {
+    char magic[4];
+    uint32_t version;
+    uint32_t flags;
+    int32_t rows;
+    int32_t columns;
+    int32_t bits_allocated;
+    int32_t bits_stored;
+    int32_t high_bit;
+    int32_t pixel_representation;
+    int32_t frame_count;
+    int32_t instance_number;
+    float pixel_aspect_ratio;
+    double pixel_spacing_row;
+    double pixel_spacing_col;
+    double image_position[3];
+    double image_orientation[6];
+    double slice_thickness;
+    double spacing_between_slices;
+    double rescale_slope;
+    double rescale_intercept;
+    double voi_center;
+    double voi_width;
+
+    uint32_t pixel_format;
+    int32_t width;
+    int32_t height;
+    uint32_t tag_count;
+    double slope;
+    double intercept;
+
+    uint64_t source_mtime;
+    uint64_t source_size;
+    StringRef strings[STRING_COUNT];
+    uint64_t tag_offset;
+    uint64_t string_offset;
+    uint64_t string_size;
+    uint64_t pixel_offset;
+    uint64_t pixel_size;
+};
+
+// Tag records point into the string table like the SliceInfo strings
+struct TagRecord {
+    uint32_t tag;
+    char vr[2];
+    uint16_t reserved;
+    uint64_t offset;
+    uint64_t length;
+};
+
+class StringTable {
+public:
+    StringRef add(const std::string &text) {
+        StringRef ref;
+        ref.offset = bytes.size();
+        ref.length = text.size();
+        bytes.insert(bytes.end(), text.begin(), text.end());
+        return ref;
+    }
+    const std::vector<char> &get_bytes() const { return bytes; }
+
+private:
+    std::vector<char> bytes;
+};
+
+size_t align_up(size_t offset, size_t alignment) {
+    return (offset + alignment - 1) / alignment * alignment;
+}
+
+bool write_padding(FILE *handle, size_t from, size_t to) {
+    static const char zeros[PIXEL_ALIGNMENT] = {};
+    return to - from <= sizeof(zeros) && std::fwrite(zeros, 1, to - from, handle) == to - from;
+}
+
+template <typename T>
+void point_at(const uint8_t *src, const Header &header, const std::shared_ptr<const void> &owner, PixelBuffer &pixels) {
+    pixels.set_external(reinterpret_cast<const T *>(src), header.width, header.height, owner, header.slope, header.intercept);
+}
+
+} // namespace
+
+bool write_decoded_file(const std::string &path, const DecodedSlice &slice, const DecodedFileSource &source,
+        std::string &error) {
+    const SliceInfo &info = slice.info;
+    const PixelBuffer &pixels = slice.pixels;
+    if (pixels.is_empty()) {
+        error = "No pixels to write";
+        return false;
+    }
+
+    StringTable table;
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, DECODED_MAGIC, 4);
+    header.version = DECODED_VERSION;
+    header.flags = (info.has_pixel_spacing ? HAS_PIXEL_SPACING : 0) |
+            (info.has_instance_number ? HAS_INSTANCE_NUMBER : 0) |
+            (info.has_image_position ? HAS_IMAGE_POSITION : 0) |
+            (info.has_image_orientation ? HAS_IMAGE_ORIENTATION : 0) |
+            (info.has_voi ? HAS_VOI : 0);
+    header.rows = info.rows;
+    header.columns = info.columns;
+    header.bits_allocated = info.bits_allocated;
+    header.bits_stored = info.bits_stored;
+    header.high_bit = info.high_bit;
+    header.pixel_representation = info.pixel_representation;
+    header.frame_count = info.frame_count;
+    header.instance_number = info.instance_number;
+    header.pixel_aspect_ratio = info.pixel_aspect_ratio;
+    header.pixel_spacing_row = info.pixel_spacing_row;
+    header.pixel_spacing_col = info.pixel_spacing_col;
+    std::memcpy(header.image_position, info.image_position, sizeof(header.image_position));
+    std::memcpy(header.image_orientation, info.image_orientation, sizeof(header.image_orientation));
+    header.slice_thickness = info.slice_thickness;
+    header.spacing_between_slices = info.spacing_between_slices;
+    header.rescale_slope = info.rescale_slope;
+    header.rescale_intercept = info.rescale_intercept;
+    header.voi_center = info.voi_center;
+    header.voi_width = info.voi_width;
+
+    header.pixel_format = uint32_t(pixels.get_format());
+    header.width = pixels.get_width();
+    header.height = pixels.get_height();
+    header.slope = pixels.get_slope();
+    header.intercept = pixels.get_intercept();
+
+    header.strings[STRING_MODALITY] = table.add(info.modality);
+    header.strings[STRING_TRANSFER_SYNTAX] = table.add(info.transfer_syntax);
+    header.strings[STRING_PHOTOMETRIC] = table.add(info.photometric_interpretation);
+    header.strings[STRING_STUDY_UID] = table.add(info.study_instance_uid);
+    header.strings[STRING_SERIES_UID] = table.add(info.series_instance_uid);
+    header.strings[STRING_SOP_UID] = table.add(info.sop_instance_uid);
+    header.source_mtime = source.mtime;
+    header.source_size = source.size;
+    header.strings[STRING_SOURCE_PATH] = table.add(source.path);
+
+    std::vector<TagRecord> tags;
+    if (slice.tags) {
+        tags.resize(slice.tags->get_count());
+        for (size_t i = 0; i < tags.size(); ++i) {
+            const TagStore::Entry &entry = slice.tags->get_entry(i);
+            std::memset(&tags[i], 0, sizeof(TagRecord));
+            tags[i].tag = entry.tag;
+            std::memcpy(tags[i].vr, entry.vr, 2);
+            const StringRef value = table.add(slice.tags->get_value(entry));
+            tags[i].offset = value.offset;
+            tags[i].length = value.length;
+        }
+    }
+    header.tag_count = uint32_t(tags.size());
+    header.tag_offset = sizeof(Header);
+    header.string_offset = header.tag_offset + tags.size() * sizeof(TagRecord);
+    header.string_size = table.get_bytes().size();
+    header.pixel_offset = align_up(size_t(header.string_offset + header.string_size), PIXEL_ALIGNMENT);
+    header.pixel_size = pixels.get_pixel_count() * pixel_format_size(pixels.get_format());
+
+    // Written piecewise so the pixels are not copied into another buffer
+    const std::string temp_path = path + ".tmp";
+    FILE *handle = open_file(temp_path, "wb");
+    if (!handle) {
+        error = "Cannot write " + temp_path;
+        return false;
+    }
+    bool written = std::fwrite(&header, sizeof(header), 1, handle) == 1;
+    written = written && (tags.empty() || std::fwrite(tags.data(), sizeof(TagRecord), tags.size(), handle) == tags.size());
+    written = written && std::fwrite(table.get_bytes().data(), 1, table.get_bytes().size(), handle) == table.get_bytes().size();
+    written = written && write_padding(handle, size_t(header.string_offset + header.string_size), size_t(header.pixel_offset));
+    written = written && std::fwrite(pixels.get_data(), 1, size_t(header.pixel_size), handle) == header.pixel_size;
+    const bool closed = std::fclose(handle) == 0;
+    if (!written || !closed) {
+        remove_file(temp_path);
+        error = "Cannot write " + temp_path;
+        return false;
+    }
+    if (!replace_file(temp_path, path)) {
+        remove_file(temp_path);
+        error = "Cannot replace " + path;
+        return false;
+    }
+    return true;
+}
+
+bool read_decoded_source(const std::string &path, DecodedFileSource &source, std::string &error) {
+    FILE *handle = open_file(path, "rb");
+    if (!handle) {
+        error = "Cannot open " + path;
+        return false;
+    }
+    Header header;
+    const bool read_header = std::fread(&header, sizeof(header), 1, handle) == 1;
+    const StringRef &ref = header.strings[STRING_SOURCE_PATH];
+    bool valid = read_header && std::memcmp(header.magic, DECODED_MAGIC, 4) == 0 && header.version == DECODED_VERSION &&
+            ref.offset + ref.length <= header.string_size && ref.length <= 4096;
+    if (valid) {
+        source.path.resize(size_t(ref.length));
+        valid = std::fseek(handle, long(header.string_offset + ref.offset), SEEK_SET) == 0 &&
+                (ref.length == 0 || std::fread(&source.path[0], 1, size_t(ref.length), handle) == ref.length);
+    }
+    std::fclose(handle);
+    if (!valid) {
+        error = "Not a decoded slice file or an older version: " + path;
+        return false;
+    }
+    source.mtime = header.source_mtime;
+    source.size = header.source_size;
+    return true;
+}
+
+bool map_decoded_file(const std::string &path, const DecodedFileSource &source, DecodedSlice &slice, std::string &error) {
+    const uint64_t parse_start = get_ticks_usec();
+    std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>();
+    if (!file->open(path, error)) {
+        return false;
+    }
+    const uint8_t *data = file->data();
+    const size_t size = file->get_size();
+    if (size < sizeof(Header)) {
+        error = "Not a decoded slice file: " + path;
+        return false;
+    }
+    Header header;
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, DECODED_MAGIC, 4) != 0 || header.version != DECODED_VERSION) {
+        error = "Not a decoded slice file or an older version: " + path;
+        return false;
+    }
+    const PixelFormat format = PixelFormat(header.pixel_format);
+    const uint64_t expected_pixels = uint64_t(header.width > 0 ? header.width : 0) * uint64_t(header.height > 0 ? header.height : 0) *
+            pixel_format_size(format);
+    if (expected_pixels == 0 || header.pixel_size != expected_pixels || header.pixel_offset % PIXEL_ALIGNMENT != 0 ||
+            header.pixel_offset + header.pixel_size > size || header.string_offset + header.string_size > header.pixel_offset ||
+            header.tag_offset + uint64_t(header.tag_count) * sizeof(TagRecord) > header.string_offset) {
+        error = "Corrupt decoded slice file: " + path;
+        return false;
+    }
+    const char *strings = reinterpret_cast<const char *>(data + header.string_offset);
+    auto get_string = [&](uint64_t offset, uint64_t length, std::string &out) {
+        if (offset + length > header.string_size) {
+            return false;
+        }
+        out.assign(strings + offset, size_t(length));
+        return true;
+    };
+    std::string source_path;
+    if (!get_string(header.strings[STRING_SOURCE_PATH].offset, header.strings[STRING_SOURCE_PATH].length, source_path) ||
+            source_path != source.path || header.source_mtime != source.mtime || header.source_size != source.size) {
+        error = "Decoded slice file is stale: " + path;
+        return false;
+    }
+
+    SliceInfo &info = slice.info;
+    info = SliceInfo();
+    std::string *fields[STRING_SOURCE_PATH] = {
+        &info.modality, &info.transfer_syntax, &info.photometric_interpretation,
+        &info.study_instance_uid, &info.series_instance_uid, &info.sop_instance_uid,
+    };
+    for (int i = 0; i < STRING_SOURCE_PATH; ++i) {
+        if (!get_string(header.strings[i].offset, header.strings[i].length, *fields[i])) {
+            error = "Corrupt decoded slice file: " + path;
+            return false;
+        }
+    }
+    info.rows = header.rows;
+    info.columns = header.columns;
+    info.bits_allocated = header.bits_allocated;
+    info.bits_stored = header.bits_stored;
+    info.high_bit = header.high_bit;
+    info.pixel_representation = header.pixel_representation;
+    info.frame_count = header.frame_count;
+    info.pixel_spacing_row = header.pixel_spacing_row;
+    info.pixel_spacing_col = header.pixel_spacing_col;
+    info.has_pixel_spacing = (header.flags & HAS_PIXEL_SPACING) != 0;
+    info.pixel_aspect_ratio = header.pixel_aspect_ratio;
+    info.instance_number = header.instance_number;
+    info.has_instance_number = (header.flags & HAS_INSTANCE_NUMBER) != 0;
+    std::memcpy(info.image_position, header.image_position, sizeof(info.image_position));
+    info.has_image_position = (header.flags & HAS_IMAGE_POSITION) != 0;
+    std::memcpy(info.image_orientation, header.image_orientation, sizeof(info.image_orientation));
+    info.has_image_orientation = (header.flags & HAS_IMAGE_ORIENTATION) != 0;
+    info.slice_thickness = header.slice_thickness;
+    info.spacing_between_slices = header.spacing_between_slices;
+    info.rescale_slope = header.rescale_slope;
+    info.rescale_intercept = header.rescale_intercept;
+    info.voi_center = header.voi_center;
+    info.voi_width = header.voi_width;
+    info.has_voi = (header.flags & HAS_VOI) != 0;
+
+    std::shared_ptr<TagStore> tags = std::make_shared<TagStore>();
+    const uint8_t *tag_data = data + header.tag_offset;
+    for (uint32_t i = 0; i < header.tag_count; ++i) {
+        TagRecord record;
+        std::memcpy(&record, tag_data + size_t(i) * sizeof(TagRecord), sizeof(record));
+        std::string value;
+        if (!get_string(record.offset, record.length, value)) {
+            error = "Corrupt decoded slice file: " + path;
+            return false;
+        }
+        const char vr[3] = { record.vr[0], record.vr[1], '\0' };
+        tags->add(uint16_t(record.tag >> 16), uint16_t(record.tag & 0xFFFF), vr, value);
+    }
+    tags->finish();
+    slice.tags = tags;
+    slice.frame_index = 0;
+    slice.frames.reset();
+    slice.timings = DecodeTimings();
+    slice.timings.parse_usec = get_ticks_usec() - parse_start;
+
+    // The range scan in set_external pages the pixels in
+    const uint64_t map_start = get_ticks_usec();
+    const uint8_t *src = data + header.pixel_offset;
+    std::shared_ptr<const void> owner = file;
+    switch (format) {
+        case PIXEL_FORMAT_U8:
+            point_at<uint8_t>(src, header, owner, slice.pixels);
+            break;
+        case PIXEL_FORMAT_S8:
+            point_at<int8_t>(src, header, owner, slice.pixels);
+            break;
+        case PIXEL_FORMAT_U16:
+            point_at<uint16_t>(src, header, owner, slice.pixels);
+            break;
+        case PIXEL_FORMAT_S16:
+            point_at<int16_t>(src, header, owner, slice.pixels);
+            break;
+        case PIXEL_FORMAT_U32:
+            point_at<uint32_t>(src, header, owner, slice.pixels);
+            break;
+        case PIXEL_FORMAT_S32:
+            point_at<int32_t>(src, header, owner, slice.pixels);
+            break;
+        case PIXEL_FORMAT_F32:
+            point_at<float>(src, header, owner, slice.pixels);
+            break;
+        default:
+            error = "Corrupt decoded slice file: " + path;
+            return false;
+    }
+    slice.timings.decode_usec = get_ticks_usec() - map_start;
+    return true;
+}
+
+} // namespace dicom
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "dicom_decoder.h"
+
+#include <string>
+
+namespace dicom {
+
+// A decoded slice saved to disk so it can be loaded again without decoding:
+// a header with the SliceInfo fields and the source file's path, size and
+// modification time, the tags, and the pixels at a 64-byte aligned offset so
+// they are used straight from a memory map. Records are stored in native
+// byte order; these files are a local cache, and one that does not match the
+// header or its source is treated as a miss.
+
+// The file a decoded slice was made from, as get_file_stat() saw it when it
+// was written. A copy whose source no longer matches is stale.
+struct DecodedFileSource {
+    std::string path;
+    uint64_t mtime = 0;
+    uint64_t size = 0;
+
+    bool operator==(const DecodedFileSource &other) const {
+        return path == other.path && mtime == other.mtime && size == other.size;
+    }
+};
+
+// Write `slice` to `path` through a temporary file, so readers never see a
+// partial one
+bool write_decoded_file(const std::string &path, const DecodedSlice &slice, const DecodedFileSource &source,
+        std::string &error);
+
+// The source recorded in a file written by write_decoded_file(); reads the
+// header only
+bool read_decoded_source(const std::string &path, DecodedFileSource &source, std::string &error);
+
+// Load a file written by write_decoded_file(), failing if it was made from
+// anything but `source`. The pixels stay in the mapping, which the slice
+// keeps alive; `slice.path` is left for the caller.
+bool map_decoded_file(const std::string &path, const DecodedFileSource &source, DecodedSlice &slice, std::string &error);
+
+} // namespace dicom
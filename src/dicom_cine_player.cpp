@@ -0,0 +1,400 @@
+#include "dicom_cine_player.h"
+#include "dicom_viewer.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <utility>
+
+#include <godot_cpp/classes/time.hpp>
+#include <godot_cpp/core/class_db.hpp>
+#include <godot_cpp/variant/utility_functions.hpp>
+
+using namespace godot;
+
+void DicomCinePlayer::_bind_methods() {
+    ClassDB::bind_method(D_METHOD("play_series", "paths", "start_index"), &DicomCinePlayer::play_series, DEFVAL(0));
+    ClassDB::bind_method(D_METHOD("play_frames", "start_index"), &DicomCinePlayer::play_frames, DEFVAL(0));
+    ClassDB::bind_method(D_METHOD("play"), &DicomCinePlayer::play);
+    ClassDB::bind_method(D_METHOD("pause"), &DicomCinePlayer::pause);
+    ClassDB::bind_method(D_METHOD("stop"), &DicomCinePlayer::stop);
+    ClassDB::bind_method(D_METHOD("is_playing"), &DicomCinePlayer::is_playing);
+    ClassDB::bind_method(D_METHOD("seek", "index"), &DicomCinePlayer::seek);
+    ClassDB::bind_method(D_METHOD("get_position"), &DicomCinePlayer::get_position);
+    ClassDB::bind_method(D_METHOD("get_frame_count"), &DicomCinePlayer::get_frame_count);
+    ClassDB::bind_method(D_METHOD("set_viewer_path", "path"), &DicomCinePlayer::set_viewer_path);
+    ClassDB::bind_method(D_METHOD("get_viewer_path"), &DicomCinePlayer::get_viewer_path);
+    ClassDB::bind_method(D_METHOD("set_fps", "fps"), &DicomCinePlayer::set_fps);
+    ClassDB::bind_method(D_METHOD("get_fps"), &DicomCinePlayer::get_fps);
+    ClassDB::bind_method(D_METHOD("get_effective_fps"), &DicomCinePlayer::get_effective_fps);
+    ClassDB::bind_method(D_METHOD("set_loop", "enabled"), &DicomCinePlayer::set_loop);
+    ClassDB::bind_method(D_METHOD("is_loop"), &DicomCinePlayer::is_loop);
+    ClassDB::bind_method(D_METHOD("set_buffer_size", "frames"), &DicomCinePlayer::set_buffer_size);
+    ClassDB::bind_method(D_METHOD("get_buffer_size"), &DicomCinePlayer::get_buffer_size);
+    ClassDB::bind_method(D_METHOD("get_playback_stats"), &DicomCinePlayer::get_playback_stats);
+    ClassDB::bind_method(D_METHOD("reset_playback_stats"), &DicomCinePlayer::reset_playback_stats);
+
+    ADD_SIGNAL(MethodInfo("frame_changed", PropertyInfo(Variant::INT, "index")));
+    ADD_SIGNAL(MethodInfo("playback_finished"));
+
+    ADD_PROPERTY(PropertyInfo(Variant::NODE_PATH, "viewer_path", PROPERTY_HINT_NODE_PATH_VALID_TYPES, "DicomViewer"), "set_viewer_path", "get_viewer_path");
+    ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "fps", PROPERTY_HINT_RANGE, "0,240,0.1"), "set_fps", "get_fps");
+    ADD_PROPERTY(PropertyInfo(Variant::BOOL, "loop"), "set_loop", "is_loop");
+    ADD_PROPERTY(PropertyInfo(Variant::INT, "buffer_size", PROPERTY_HINT_RANGE, "1,256,1"), "set_buffer_size", "get_buffer_size");
+}
+
+DicomCinePlayer::DicomCinePlayer() {
+    fps = 0.0f;
+    loop = true;
+    buffer_size = 8;
+    frame_count = 0;
+    playing = false;
+    playing_fps = DEFAULT_FPS;
+    shown_sequence = -1;
+    clock_sequence = 0;
+    clock_start_usec = 0;
+    displayed_frames = 0;
+    dropped_frames = 0;
+    late_ticks = 0;
+    display_times.assign(FPS_SAMPLES, 0);
+    display_time_next = 0;
+
+    buffer = std::make_shared<BufferState>();
+    buffer->slots.resize(size_t(buffer_size));
+    set_process(false);
+}
+
+DicomCinePlayer::~DicomCinePlayer() {
+    // Running jobs drop their results
+    std::lock_guard<std::mutex> lock(buffer->mutex);
+    buffer->generation++;
+}
+
+DicomViewer *DicomCinePlayer::get_viewer() const {
+    if (viewer_path.is_empty() || !is_inside_tree()) {
+        return nullptr;
+    }
+    return Object::cast_to<DicomViewer>(get_node_or_null(viewer_path));
+}
+
+float DicomCinePlayer::get_file_fps(const dicom::DecodedSlice &slice) {
+    if (!slice.tags) {
+        return 0.0f;
+    }
+    const dicom::TagStore &tags = *slice.tags;
+    // Frame Time is in milliseconds per frame
+    const double frame_time = atof(tags.get_string(dicom::TagStore::make_tag(0x0018, 0x1063)).c_str());
+    if (frame_time > 0.0) {
+        return float(1000.0 / frame_time);
+    }
+    const double cine_rate = atof(tags.get_string(dicom::TagStore::make_tag(0x0018, 0x0040)).c_str());
+    if (cine_rate > 0.0) {
+        return float(cine_rate);
+    }
+    const double display_rate = atof(tags.get_string(dicom::TagStore::make_tag(0x0008, 0x2144)).c_str());
+    return display_rate > 0.0 ? float(display_rate) : 0.0f;
+}
+
+void DicomCinePlayer::reset_buffer() {
+    std::lock_guard<std::mutex> lock(buffer->mutex);
+    buffer->generation++;
+    buffer->slots.assign(size_t(buffer_size), BufferState::Slot());
+    buffer->playhead = 0;
+}
+
+void DicomCinePlayer::fill_buffer(int64_t from) {
+    dicom::ThreadPool *pool = dicom::ThreadPool::get_singleton();
+    if (pool->get_thread_count() == 0) {
+        return;
+    }
+    std::vector<std::function<void()>> jobs;
+    {
+        std::lock_guard<std::mutex> lock(buffer->mutex);
+        buffer->playhead = from;
+        const uint64_t generation = buffer->generation;
+        const int64_t size = int64_t(buffer->slots.size());
+        for (int64_t sequence = from; sequence < from + size; ++sequence) {
+            if (!loop && sequence >= frame_count) {
+                break;
+            }
+            BufferState::Slot &slot = buffer->slots[size_t(sequence % size)];
+            if (slot.sequence == sequence) {
+                continue;
+            }
+            slot = BufferState::Slot();
+            slot.sequence = sequence;
+
+            // Jobs only see the shared state, never the player
+            std::shared_ptr<BufferState> state = buffer;
+            const int frame = get_frame_of(sequence);
+            const String path = frames ? String() : series_paths[size_t(frame)];
+            std::shared_ptr<const dicom::FrameSource> source = frames;
+            jobs.push_back([state, generation, sequence, frame, path, source]() {
+                {
+                    std::lock_guard<std::mutex> job_lock(state->mutex);
+                    if (state->generation != generation || sequence < state->playhead) {
+                        return;
+                    }
+                }
+                String error;
+                std::shared_ptr<const dicom::DecodedSlice> decoded = source ? DicomViewer::get_frame_slice(source, frame, error)
+                                                                            : DicomViewer::get_file_slice(path, error);
+                std::lock_guard<std::mutex> job_lock(state->mutex);
+                BufferState::Slot &target = state->slots[size_t(sequence % int64_t(state->slots.size()))];
+                if (state->generation == generation && target.sequence == sequence) {
+                    // A failed frame is ready without a slice and gets skipped
+                    target.slice = std::move(decoded);
+                    target.ready = true;
+                }
+            });
+        }
+    }
+    for (std::function<void()> &job : jobs) {
+        pool->submit(std::move(job));
+    }
+}
+
+void DicomCinePlayer::show(int64_t sequence, const std::shared_ptr<const dicom::DecodedSlice> &slice) {
+    const bool first = shown_sequence < 0;
+    shown_sequence = sequence;
+    DicomViewer *viewer = get_viewer();
+    if (viewer) {
+        // The first frame opens at the file's window; later frames keep
+        // whatever the user has set meanwhile
+        viewer->show_slice(slice, !first);
+    }
+    displayed_frames++;
+    display_times[display_time_next] = Time::get_singleton()->get_ticks_usec();
+    display_time_next = (display_time_next + 1) % display_times.size();
+    emit_signal("frame_changed", get_frame_of(sequence));
+}
+
+bool DicomCinePlayer::start(int start_index) {
+    playing = false;
+    set_process(false);
+    reset_buffer();
+    reset_playback_stats();
+    shown_sequence = -1;
+    if (frame_count <= 0) {
+        UtilityFunctions::push_error("DicomCinePlayer: nothing to play");
+        return false;
+    }
+    start_index = std::min(std::max(start_index, 0), frame_count - 1);
+
+    String error;
+    std::shared_ptr<const dicom::DecodedSlice> first = frames ? DicomViewer::get_frame_slice(frames, start_index, error)
+                                                              : DicomViewer::get_file_slice(series_paths[size_t(start_index)], error);
+    if (!first) {
+        UtilityFunctions::push_error("DicomCinePlayer: failed to decode frame ", start_index, ": ", error);
+        return false;
+    }
+    const float file_fps = get_file_fps(*first);
+    playing_fps = fps > 0.0f ? fps : (file_fps > 0.0f ? file_fps : DEFAULT_FPS);
+    show(start_index, first);
+
+    playing = true;
+    clock_sequence = shown_sequence;
+    clock_start_usec = Time::get_singleton()->get_ticks_usec();
+    fill_buffer(shown_sequence + 1);
+    set_process(true);
+    return true;
+}
+
+bool DicomCinePlayer::play_series(const Array &paths, int start_index) {
+    series_paths.clear();
+    series_paths.reserve(paths.size());
+    // Resolved here: decode jobs must not touch ProjectSettings
+    for (int i = 0; i < paths.size(); ++i) {
+        series_paths.push_back(DicomViewer::globalize_path(paths[i]));
+    }
+    frames.reset();
+    frame_count = int(series_paths.size());
+    return start(start_index);
+}
+
+bool DicomCinePlayer::play_frames(int start_index) {
+    DicomViewer *viewer = get_viewer();
+    std::shared_ptr<const dicom::DecodedSlice> slice = viewer ? viewer->get_slice() : nullptr;
+    if (!slice || !slice->frames) {
+        UtilityFunctions::push_error("DicomCinePlayer: the viewer is not showing a multi-frame image");
+        return false;
+    }
+    series_paths.clear();
+    frames = slice->frames;
+    frame_count = frames->get_frame_count();
+    return start(start_index);
+}
+
+void DicomCinePlayer::play() {
+    if (playing || frame_count <= 0) {
+        return;
+    }
+    // After stop(), or at the end without looping, start over
+    if (shown_sequence < 0 || (!loop && shown_sequence >= frame_count - 1)) {
+        start(0);
+        return;
+    }
+    playing = true;
+    clock_sequence = shown_sequence;
+    clock_start_usec = Time::get_singleton()->get_ticks_usec();
+    fill_buffer(shown_sequence + 1);
+    set_process(true);
+}
+
+void DicomCinePlayer::pause() {
+    playing = false;
+    set_process(false);
+}
+
+void DicomCinePlayer::stop() {
+    pause();
+    reset_buffer();
+    shown_sequence = -1;
+}
+
+bool DicomCinePlayer::seek(int index) {
+    if (index < 0 || index >= frame_count) {
+        UtilityFunctions::push_error("DicomCinePlayer: frame index ", index, " out of range (0-", frame_count - 1, ")");
+        return false;
+    }
+    String error;
+    std::shared_ptr<const dicom::DecodedSlice> slice = frames ? DicomViewer::get_frame_slice(frames, index, error)
+                                                              : DicomViewer::get_file_slice(series_paths[size_t(index)], error);
+    if (!slice) {
+        UtilityFunctions::push_error("DicomCinePlayer: failed to decode frame ", index, ": ", error);
+        return false;
+    }
+    // Sequences restart at the new frame; buffered ones no longer apply
+    reset_buffer();
+    show(index, slice);
+    if (playing) {
+        clock_sequence = shown_sequence;
+        clock_start_usec = Time::get_singleton()->get_ticks_usec();
+        fill_buffer(shown_sequence + 1);
+    }
+    return true;
+}
+
+void DicomCinePlayer::_process(double p_delta) {
+    (void)p_delta;
+    if (!playing) {
+        set_process(false);
+        return;
+    }
+    // Which frame the clock says should be on screen now
+    const uint64_t now = Time::get_singleton()->get_ticks_usec();
+    int64_t due = clock_sequence + int64_t(double(now - clock_start_usec) * double(playing_fps) / 1000000.0);
+    if (!loop && due > frame_count - 1) {
+        due = frame_count - 1;
+    }
+
+    if (due > shown_sequence && dicom::ThreadPool::get_singleton()->get_thread_count() == 0) {
+        // No workers: decode the due frame here and skip the ones before it
+        const int frame = get_frame_of(due);
+        String error;
+        std::shared_ptr<const dicom::DecodedSlice> decoded = frames ? DicomViewer::get_frame_slice(frames, frame, error)
+                                                                    : DicomViewer::get_file_slice(series_paths[size_t(frame)], error);
+        if (decoded) {
+            dropped_frames += uint64_t(due - shown_sequence - 1);
+            show(due, decoded);
+        } else {
+            dropped_frames += uint64_t(due - shown_sequence);
+            shown_sequence = due;
+        }
+    } else if (due > shown_sequence) {
+        // The newest frame that is ready; anything older is skipped
+        std::shared_ptr<const dicom::DecodedSlice> ready;
+        int64_t ready_sequence = -1;
+        {
+            std::lock_guard<std::mutex> lock(buffer->mutex);
+            const int64_t size = int64_t(buffer->slots.size());
+            for (int64_t sequence = due; sequence > shown_sequence && sequence > due - size; --sequence) {
+                const BufferState::Slot &slot = buffer->slots[size_t(sequence % size)];
+                if (slot.sequence == sequence && slot.ready) {
+                    ready = slot.slice;
+                    ready_sequence = sequence;
+                    break;
+                }
+            }
+        }
+        if (ready_sequence < 0) {
+            late_ticks++;
+        } else if (ready) {
+            dropped_frames += uint64_t(ready_sequence - shown_sequence - 1);
+            show(ready_sequence, ready);
+        } else {
+            // Undecodable: pass over it as if it had been dropped
+            dropped_frames += uint64_t(ready_sequence - shown_sequence);
+            shown_sequence = ready_sequence;
+        }
+        // Overdue frames are not worth decoding any more
+        fill_buffer(std::max(shown_sequence + 1, due));
+    }
+
+    if (!loop && shown_sequence >= frame_count - 1) {
+        pause();
+        emit_signal("playback_finished");
+    }
+}
+
+void DicomCinePlayer::set_fps(float p_fps) {
+    fps = p_fps > 0.0f ? p_fps : 0.0f;
+    if (fps > 0.0f) {
+        playing_fps = fps;
+    }
+    // Rebase the clock so the new rate applies from the frame on screen
+    clock_sequence = shown_sequence;
+    clock_start_usec = Time::get_singleton()->get_ticks_usec();
+}
+
+void DicomCinePlayer::set_buffer_size(int p_frames) {
+    p_frames = std::min(std::max(p_frames, 1), 256);
+    if (p_frames == buffer_size) {
+        return;
+    }
+    buffer_size = p_frames;
+    reset_buffer();
+    if (playing) {
+        fill_buffer(shown_sequence + 1);
+    }
+}
+
+Dictionary DicomCinePlayer::get_playback_stats() const {
+    Dictionary stats;
+    stats["target_fps"] = playing_fps;
+
+    // Over the last FPS_SAMPLES frames shown
+    const size_t samples = size_t(std::min<uint64_t>(displayed_frames, display_times.size()));
+    double achieved = 0.0;
+    if (samples > 1) {
+        const uint64_t newest = display_times[(display_time_next + display_times.size() - 1) % display_times.size()];
+        const uint64_t oldest = display_times[(display_time_next + display_times.size() - samples) % display_times.size()];
+        if (newest > oldest) {
+            achieved = double(samples - 1) * 1000000.0 / double(newest - oldest);
+        }
+    }
+    stats["achieved_fps"] = achieved;
+    stats["displayed_frames"] = (int64_t)displayed_frames;
+    stats["dropped_frames"] = (int64_t)dropped_frames;
+    stats["late_ticks"] = (int64_t)late_ticks;
+
+    int64_t buffered = 0;
+    {
+        std::lock_guard<std::mutex> lock(buffer->mutex);
+        for (const BufferState::Slot &slot : buffer->slots) {
+            if (slot.ready && slot.slice && slot.sequence > shown_sequence) {
+                buffered++;
+            }
+        }
+    }
+    stats["buffered_frames"] = buffered;
+    return stats;
+}
+
+void DicomCinePlayer::reset_playback_stats() {
+    displayed_frames = 0;
+    dropped_frames = 0;
+    late_ticks = 0;
+    display_time_next = 0;
+}
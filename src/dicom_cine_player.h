@@ -0,0 +1,128 @@
+#pragma once
+
+#include "dicom_decoder.h"
+
+#include <godot_cpp/classes/node.hpp>
+#include <godot_cpp/variant/array.hpp>
+#include <godot_cpp/variant/dictionary.hpp>
+#include <godot_cpp/variant/node_path.hpp>
+#include <godot_cpp/variant/string.hpp>
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace godot {
+
+class DicomViewer;
+
+// Plays a series (one file per frame) or the frames of a multi-frame file
+// on a DicomViewer at a fixed rate. Frames are decoded ahead on the shared
+// thread pool into a small ring buffer. Playback follows the clock: when
+// decoding falls behind, the newest ready frame is shown and the frames
+// passed over are counted as dropped instead of being shown late. A pool
+// without workers (single-core machines, web builds without threads) would
+// run every job on the main thread, so there only the frame that is due is
+// decoded, with no decode-ahead.
+class DicomCinePlayer : public Node {
+    GDCLASS(DicomCinePlayer, Node);
+
+private:
+    // Shared with decode jobs, so it outlives the player if a job is still
+    // running. Slot `s % size` holds the frame at play sequence `s`.
+    struct BufferState {
+        struct Slot {
+            int64_t sequence = -1;
+            bool ready = false;
+            std::shared_ptr<const dicom::DecodedSlice> slice;
+        };
+        std::mutex mutex;
+        uint64_t generation = 0;
+        std::vector<Slot> slots;
+        // Jobs for earlier sequences are no longer needed
+        int64_t playhead = 0;
+    };
+    std::shared_ptr<BufferState> buffer;
+
+    NodePath viewer_path;
+    // 0 = from the file (Frame Time, Cine Rate or Recommended Display
+    // Frame Rate), else `DEFAULT_FPS`
+    float fps;
+    bool loop;
+    int buffer_size;
+    static constexpr float DEFAULT_FPS = 15.0f;
+
+    // Source: absolute series paths, or the frames of an open multi-frame file
+    std::vector<String> series_paths;
+    std::shared_ptr<const dicom::FrameSource> frames;
+    int frame_count;
+
+    bool playing;
+    float playing_fps;
+    // Play sequence numbers count frames shown since play(); with looping
+    // they run past frame_count and wrap
+    int64_t shown_sequence;
+    int64_t clock_sequence;
+    uint64_t clock_start_usec;
+
+    uint64_t displayed_frames;
+    uint64_t dropped_frames;
+    uint64_t late_ticks;
+    // Recent display times for the achieved rate
+    static constexpr int FPS_SAMPLES = 32;
+    std::vector<uint64_t> display_times;
+    size_t display_time_next;
+
+    DicomViewer *get_viewer() const;
+    int get_frame_of(int64_t sequence) const { return frame_count > 0 ? int(sequence % frame_count) : 0; }
+    // Frame rate the file asks for, or 0
+    static float get_file_fps(const dicom::DecodedSlice &slice);
+    // Cancel queued decodes and empty the ring buffer
+    void reset_buffer();
+    // Queue decodes for the sequences after `from` that are not buffered;
+    // a no-op without pool workers
+    void fill_buffer(int64_t from);
+    void show(int64_t sequence, const std::shared_ptr<const dicom::DecodedSlice> &slice);
+    bool start(int start_index);
+
+protected:
+    static void _bind_methods();
+
+public:
+    DicomCinePlayer();
+    ~DicomCinePlayer();
+
+    virtual void _process(double p_delta) override;
+
+    // Play `paths` (one frame per file) from `start_index`
+    bool play_series(const Array &paths, int start_index);
+    // Play the multi-frame file on display in the viewer
+    bool play_frames(int start_index);
+    // Resume, pause or stop (which also rewinds to the first frame)
+    void play();
+    void pause();
+    void stop();
+    bool is_playing() const { return playing; }
+    // Show frame `index` now; playback continues from there if playing
+    bool seek(int index);
+    int get_position() const { return frame_count > 0 && shown_sequence >= 0 ? get_frame_of(shown_sequence) : 0; }
+    int get_frame_count() const { return frame_count; }
+
+    void set_viewer_path(const NodePath &path) { viewer_path = path; }
+    NodePath get_viewer_path() const { return viewer_path; }
+    void set_fps(float p_fps);
+    float get_fps() const { return fps; }
+    // Rate in use: `fps`, else the file's, else the default
+    float get_effective_fps() const { return playing_fps; }
+    void set_loop(bool enabled) { loop = enabled; }
+    bool is_loop() const { return loop; }
+    void set_buffer_size(int frames);
+    int get_buffer_size() const { return buffer_size; }
+
+    // target_fps, achieved_fps, displayed_frames, dropped_frames, late_ticks
+    // (frames due but not decoded yet) and buffered_frames
+    Dictionary get_playback_stats() const;
+    void reset_playback_stats();
+};
+
+} // namespace godot
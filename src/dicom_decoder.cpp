@@ -0,0 +1,665 @@
+#include "dicom_decoder.h"
+#include "builtin_decoder.h"
+#include "mapped_pixels.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <mutex>
+#include <vector>
+
+#ifdef USE_DCMTK
+#include <dcmtk/dcmimgle/dcmimage.h>
+#include <dcmtk/dcmdata/dctk.h>
+#include <dcmtk/ofstd/ofstd.h>
+#include <dcmtk/ofstd/ofstring.h>
+// Add these headers for decompression support
+#include <dcmtk/dcmjpeg/djdecode.h>  // JPEG decoders
+#include <dcmtk/dcmjpls/djdecode.h>  // JPEG-LS decoders
+#include <dcmtk/dcmdata/dcrledrg.h>  // RLE decoder
+#endif
+
+namespace dicom {
+
+uint64_t get_ticks_usec() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+}
+
+void FrameValues::apply(SliceInfo &info) const {
+    if (has_rescale) {
+        info.rescale_slope = rescale_slope;
+        info.rescale_intercept = rescale_intercept;
+    }
+    if (has_voi) {
+        info.voi_center = voi_center;
+        info.voi_width = voi_width;
+        info.has_voi = true;
+    }
+    if (has_image_position) {
+        for (int i = 0; i < 3; ++i) info.image_position[i] = image_position[i];
+        info.has_image_position = true;
+    }
+    if (has_image_orientation) {
+        for (int i = 0; i < 6; ++i) info.image_orientation[i] = image_orientation[i];
+        info.has_image_orientation = true;
+    }
+    if (has_pixel_spacing) {
+        info.pixel_spacing_row = pixel_spacing_row;
+        info.pixel_spacing_col = pixel_spacing_col;
+        info.has_pixel_spacing = true;
+        if (pixel_spacing_col > 0.0) {
+            info.pixel_aspect_ratio = static_cast<float>(pixel_spacing_row / pixel_spacing_col);
+        }
+    }
+    if (has_slice_thickness) {
+        info.slice_thickness = slice_thickness;
+    }
+}
+
+FrameSource::FrameSource() {}
+
+FrameSource::~FrameSource() {}
+
+#ifdef USE_DCMTK
+
+// Decoders may run on several worker threads at once; register codecs once
+static std::once_flag dcmtk_codecs_once;
+
+static void register_dcmtk_codecs() {
+    std::call_once(dcmtk_codecs_once, [] {
+        // Register JPEG decompression codecs
+        DJDecoderRegistration::registerCodecs();
+        // Register JPEG-LS decompression codecs
+        DJLSDecoderRegistration::registerCodecs();
+        // Register RLE decompression codec
+        DcmRLEDecoderRegistration::registerCodecs();
+    });
+}
+
+static std::string get_string(DcmItem *item, const DcmTagKey &key, unsigned long pos = 0) {
+    OFString value;
+    if (item->findAndGetOFString(key, value, pos).good()) {
+        return std::string(value.c_str());
+    }
+    return std::string();
+}
+
+static void read_slice_info(DcmDataset *ds, SliceInfo &info) {
+    info.modality = get_string(ds, DCM_Modality);
+    info.photometric_interpretation = get_string(ds, DCM_PhotometricInterpretation);
+    info.transfer_syntax = DcmXfer(ds->getOriginalXfer()).getXferID();
+    info.study_instance_uid = get_string(ds, DCM_StudyInstanceUID);
+    info.series_instance_uid = get_string(ds, DCM_SeriesInstanceUID);
+    info.sop_instance_uid = get_string(ds, DCM_SOPInstanceUID);
+
+    Sint32 instance_number = 0;
+    if (ds->findAndGetSint32(DCM_InstanceNumber, instance_number).good()) {
+        info.instance_number = instance_number;
+        info.has_instance_number = true;
+    }
+    double position[3];
+    if (ds->findAndGetFloat64(DCM_ImagePositionPatient, position[0], 0).good() &&
+            ds->findAndGetFloat64(DCM_ImagePositionPatient, position[1], 1).good() &&
+            ds->findAndGetFloat64(DCM_ImagePositionPatient, position[2], 2).good()) {
+        for (int i = 0; i < 3; ++i) info.image_position[i] = position[i];
+        info.has_image_position = true;
+    }
+    double orientation[6];
+    bool have_orientation = true;
+    for (int i = 0; i < 6 && have_orientation; ++i) {
+        have_orientation = ds->findAndGetFloat64(DCM_ImageOrientationPatient, orientation[i], i).good();
+    }
+    if (have_orientation) {
+        for (int i = 0; i < 6; ++i) info.image_orientation[i] = orientation[i];
+        info.has_image_orientation = true;
+    }
+    ds->findAndGetFloat64(DCM_SliceThickness, info.slice_thickness);
+    ds->findAndGetFloat64(DCM_SpacingBetweenSlices, info.spacing_between_slices);
+
+    Uint16 value = 0;
+    if (ds->findAndGetUint16(DCM_BitsAllocated, value).good()) info.bits_allocated = value;
+    if (ds->findAndGetUint16(DCM_BitsStored, value).good()) info.bits_stored = value;
+    if (ds->findAndGetUint16(DCM_HighBit, value).good()) info.high_bit = value;
+    if (ds->findAndGetUint16(DCM_PixelRepresentation, value).good()) info.pixel_representation = value;
+    Sint32 frames = 1;
+    if (ds->findAndGetSint32(DCM_NumberOfFrames, frames).good() && frames > 1) info.frame_count = frames;
+
+    // Try Pixel Spacing first (most common - for cross-sectional imaging),
+    // then Imager Pixel Spacing (projection radiography)
+    double row = 1.0, col = 1.0;
+    if (ds->findAndGetFloat64(DCM_PixelSpacing, row, 0).good() &&
+            ds->findAndGetFloat64(DCM_PixelSpacing, col, 1).good()) {
+        info.has_pixel_spacing = true;
+    } else if (ds->findAndGetFloat64(DCM_ImagerPixelSpacing, row, 0).good() &&
+            ds->findAndGetFloat64(DCM_ImagerPixelSpacing, col, 1).good()) {
+        info.has_pixel_spacing = true;
+    }
+    if (info.has_pixel_spacing) {
+        info.pixel_spacing_row = row;
+        info.pixel_spacing_col = col;
+    }
+    if (info.has_pixel_spacing && col > 0.0) {
+        info.pixel_aspect_ratio = static_cast<float>(row / col);
+    }
+
+    std::string text = get_string(ds, DCM_RescaleSlope);
+    if (!text.empty()) info.rescale_slope = atof(text.c_str());
+    text = get_string(ds, DCM_RescaleIntercept);
+    if (!text.empty()) info.rescale_intercept = atof(text.c_str());
+
+    // WindowCenter and WindowWidth can have multiple values (multiple presets)
+    // We'll take the first value
+    text = get_string(ds, DCM_WindowCenter);
+    if (!text.empty()) {
+        info.voi_center = atof(text.c_str());
+        info.has_voi = true;
+    }
+    text = get_string(ds, DCM_WindowWidth);
+    if (!text.empty()) info.voi_width = atof(text.c_str());
+}
+
+// Values of one item of a Functional Groups Sequence
+static void read_functional_groups(DcmItem *groups, FrameValues &values) {
+    DcmItem *item = nullptr;
+    Float64 number = 0.0;
+    if (groups->findAndGetSequenceItem(DCM_PixelValueTransformationSequence, item).good()) {
+        if (item->findAndGetFloat64(DCM_RescaleSlope, number).good()) {
+            values.rescale_slope = number;
+            values.has_rescale = true;
+        }
+        if (item->findAndGetFloat64(DCM_RescaleIntercept, number).good()) {
+            values.rescale_intercept = number;
+            values.has_rescale = true;
+        }
+    }
+    if (groups->findAndGetSequenceItem(DCM_FrameVOILUTSequence, item).good() &&
+            item->findAndGetFloat64(DCM_WindowCenter, values.voi_center).good()) {
+        item->findAndGetFloat64(DCM_WindowWidth, values.voi_width);
+        values.has_voi = true;
+    }
+    if (groups->findAndGetSequenceItem(DCM_PlanePositionSequence, item).good()) {
+        values.has_image_position = true;
+        for (int i = 0; i < 3 && values.has_image_position; ++i) {
+            values.has_image_position = item->findAndGetFloat64(DCM_ImagePositionPatient, values.image_position[i], i).good();
+        }
+    }
+    if (groups->findAndGetSequenceItem(DCM_PlaneOrientationSequence, item).good()) {
+        values.has_image_orientation = true;
+        for (int i = 0; i < 6 && values.has_image_orientation; ++i) {
+            values.has_image_orientation = item->findAndGetFloat64(DCM_ImageOrientationPatient, values.image_orientation[i], i).good();
+        }
+    }
+    if (groups->findAndGetSequenceItem(DCM_PixelMeasuresSequence, item).good()) {
+        values.has_pixel_spacing = item->findAndGetFloat64(DCM_PixelSpacing, values.pixel_spacing_row, 0).good() &&
+                item->findAndGetFloat64(DCM_PixelSpacing, values.pixel_spacing_col, 1).good();
+        values.has_slice_thickness = item->findAndGetFloat64(DCM_SliceThickness, values.slice_thickness).good();
+    }
+}
+
+// Shared values first, then each frame's own on top. Empty for files
+// without Functional Groups.
+static void read_frame_values(DcmDataset *ds, int frame_count, std::vector<FrameValues> &frames) {
+    frames.clear();
+    DcmItem *shared_groups = nullptr;
+    DcmSequenceOfItems *per_frame_groups = nullptr;
+    const bool has_shared = ds->findAndGetSequenceItem(DCM_SharedFunctionalGroupsSequence, shared_groups).good();
+    const bool has_per_frame = ds->findAndGetSequence(DCM_PerFrameFunctionalGroupsSequence, per_frame_groups).good() &&
+            per_frame_groups;
+    if (!has_shared && !has_per_frame) {
+        return;
+    }
+    FrameValues shared;
+    if (has_shared) {
+        read_functional_groups(shared_groups, shared);
+    }
+    frames.assign(size_t(std::max(frame_count, 1)), shared);
+    if (has_per_frame) {
+        const unsigned long count = std::min(per_frame_groups->card(), (unsigned long)frames.size());
+        for (unsigned long i = 0; i < count; ++i) {
+            read_functional_groups(per_frame_groups->getItem(i), frames[i]);
+        }
+    }
+}
+
+// Enhanced files: frame 0 stands for the file
+static void apply_first_frame_values(DcmDataset *ds, SliceInfo &info) {
+    std::vector<FrameValues> frames;
+    read_frame_values(ds, 1, frames);
+    if (!frames.empty()) {
+        frames[0].apply(info);
+    }
+}
+
+// Keep every top-level element that has a text form. Binary values and
+// sequences are skipped; Pixel Data would dwarf everything else.
+static void collect_tags(DcmItem *item, TagStore &tags) {
+    if (!item) {
+        return;
+    }
+    for (unsigned long i = 0; i < item->card(); ++i) {
+        DcmElement *element = item->getElement(i);
+        if (!element) {
+            continue;
+        }
+        const DcmEVR evr = element->ident();
+        switch (evr) {
+            case EVR_SQ:
+            case EVR_OB:
+            case EVR_OW:
+            case EVR_OF:
+            case EVR_OD:
+            case EVR_OL:
+            case EVR_UN:
+            case EVR_ox:
+            case EVR_px:
+            case EVR_pixelSQ:
+                continue;
+            default:
+                break;
+        }
+        OFString value;
+        if (element->getLength() > 0 && !element->getOFStringArray(value).good()) {
+            continue;
+        }
+        const DcmTag &tag = element->getTag();
+        tags.add(tag.getGroup(), tag.getElement(), DcmVR(evr).getVRName(), std::string(value.c_str(), value.length()));
+    }
+}
+
+// Meta header and dataset. DCMTK built with character set support converts
+// the dataset to UTF-8 first; otherwise TagStore handles ISO_IR 100 itself.
+static void collect_file_tags(DcmFileFormat &file, TagStore &tags) {
+    collect_tags(file.getMetaInfo(), tags);
+    DcmDataset *ds = file.getDataset();
+#ifdef DCMTK_ENABLE_CHARSET_CONVERSION
+    if (ds) {
+        ds->convertToUTF8();
+    }
+#endif
+    collect_tags(ds, tags);
+}
+
+// Copy DicomImage's internal pixels (stored values, or modality values if
+// DCMTK had to apply a Modality LUT Sequence) at their native width
+static bool copy_inter_data(const DicomImage &image, double slope, double intercept, PixelBuffer &pixels, std::string &error) {
+    const int w = image.getWidth();
+    const int h = image.getHeight();
+    const DiPixel *pixel_data = image.getInterData();
+    if (!pixel_data) {
+        error = "DCMTK Error: Failed to get internal pixel data";
+        return false;
+    }
+    // The representation might differ from the original
+    const EP_Representation representation = pixel_data->getRepresentation();
+    const void *data = pixel_data->getData();
+    if (!data) {
+        error = "DCMTK Error: Internal pixel data pointer is null";
+        return false;
+    }
+
+    switch (representation) {
+        case EPR_Uint8:
+            pixels.assign(static_cast<const uint8_t *>(data), w, h, slope, intercept);
+            break;
+        case EPR_Sint8:
+            pixels.assign(static_cast<const int8_t *>(data), w, h, slope, intercept);
+            break;
+        case EPR_Uint16:
+            pixels.assign(static_cast<const uint16_t *>(data), w, h, slope, intercept);
+            break;
+        case EPR_Sint16:
+            pixels.assign(static_cast<const int16_t *>(data), w, h, slope, intercept);
+            break;
+        case EPR_Uint32:
+            pixels.assign(static_cast<const uint32_t *>(data), w, h, slope, intercept);
+            break;
+        case EPR_Sint32:
+            pixels.assign(static_cast<const int32_t *>(data), w, h, slope, intercept);
+            break;
+        default:
+            error = "DCMTK Error: Unsupported pixel representation: " + std::to_string((int)representation);
+            return false;
+    }
+    return true;
+}
+
+// Fast path for uncompressed single-frame greyscale files: the built-in
+// reader walks the header once, which gives both the tags and the Pixel
+// Data offset, and the pixels are used in place from its memory map instead
+// of being copied through the dataset, DicomImage and the PixelBuffer.
+// Returns false, leaving `slice` untouched, when the file does not qualify;
+// compressed, colour and big endian files are left to DCMTK.
+static bool decode_mapped(const std::string &path, DecodedSlice &slice) {
+    uint64_t stage_start = get_ticks_usec();
+    BuiltinFile file;
+    std::string reason;
+    if (!builtin_open(path, file, reason) || file.rle || file.info.frame_count > 1 || file.has_modality_lut) {
+        return false;
+    }
+    const uint64_t parse_usec = get_ticks_usec() - stage_start;
+
+    stage_start = get_ticks_usec();
+    SliceInfo info;
+    builtin_get_frame_info(file, 0, info);
+    PixelBuffer pixels;
+    if (!map_pixel_data(file.file, file.pixel_data, file.pixel_data_length, info, pixels, reason)) {
+        return false;
+    }
+    slice.timings.parse_usec = parse_usec;
+    // The stored-range scan, which is the first touch of the pages
+    slice.timings.decode_usec = get_ticks_usec() - stage_start;
+    slice.timings.convert_usec = 0;
+    slice.tags = file.tags;
+    slice.info = info;
+    slice.pixels = std::move(pixels);
+    return true;
+}
+
+bool decode_dicom_file(const std::string &path, DecodedSlice &slice, std::string &error, DecodeFailure *failure) {
+    register_dcmtk_codecs();
+    slice.path = path;
+    // DCMTK reads any file it can as DICOM
+    if (failure) {
+        *failure = DECODE_FAILED;
+    }
+    if (decode_mapped(path, slice)) {
+        return true;
+    }
+
+    // Load file and dataset. The file is parsed exactly once: large element
+    // values (Pixel Data) are pulled into memory here as well, so DicomImage
+    // can be built from this dataset without DCMTK reopening the file.
+    uint64_t stage_start = get_ticks_usec();
+    std::unique_ptr<DcmFileFormat> loaded(new DcmFileFormat());
+    OFCondition loadStatus = loaded->loadFile(path.c_str());
+    if (loadStatus.good()) {
+        // Multi-frame files leave Pixel Data on disk and decode frame 0 only;
+        // the frame source keeps the header loaded here
+        Sint32 frames = 1;
+        DcmDataset *header = loaded->getDataset();
+        if (header && header->findAndGetSint32(DCM_NumberOfFrames, frames).good() && frames > 1) {
+            std::shared_ptr<FrameSource> source = std::make_shared<FrameSource>();
+            if (!source->open(path, std::move(loaded), error)) {
+                return false;
+            }
+            const uint64_t parse_usec = get_ticks_usec() - stage_start;
+            if (!source->decode_frame(0, slice, error)) {
+                return false;
+            }
+            slice.timings.parse_usec = parse_usec;
+            return true;
+        }
+        loadStatus = loaded->loadAllDataIntoMemory();
+    }
+    DcmFileFormat &file = *loaded;
+    if (!loadStatus.good()) {
+        error = std::string("DCMTK Error loading file: ") + loadStatus.text();
+        return false;
+    }
+    slice.timings.parse_usec = get_ticks_usec() - stage_start;
+    DcmDataset *ds = file.getDataset();
+    if (!ds) {
+        error = "DCMTK Error: No dataset found";
+        return false;
+    }
+
+    SliceInfo &info = slice.info;
+    read_slice_info(ds, info);
+    apply_first_frame_values(ds, info);
+    std::shared_ptr<TagStore> tags = std::make_shared<TagStore>();
+    collect_file_tags(file, *tags);
+    tags->finish();
+    slice.tags = tags;
+
+    // Read image dimensions
+    Uint16 rows = 0, cols = 0;
+    if (!ds->findAndGetUint16(DCM_Rows, rows).good() || !ds->findAndGetUint16(DCM_Columns, cols).good()) {
+        error = "DCMTK Error: Missing image dimensions (Rows/Columns)";
+        return false;
+    }
+    if (rows == 0 || cols == 0) {
+        error = "DCMTK Error: Invalid dimensions: " + std::to_string(cols) + "x" + std::to_string(rows);
+        return false;
+    }
+    info.rows = rows;
+    info.columns = cols;
+
+    // Decompress encapsulated pixel data in place, then build DicomImage on
+    // top of the already-parsed dataset instead of handing it the file path.
+    stage_start = get_ticks_usec();
+    E_TransferSyntax xfer = ds->getOriginalXfer();
+    if (DcmXfer(xfer).isEncapsulated()) {
+        OFCondition decodeStatus = ds->chooseRepresentation(EXS_LittleEndianExplicit, NULL);
+        if (!decodeStatus.good()) {
+            error = std::string("DCMTK Error decompressing pixel data: ") + decodeStatus.text();
+            return false;
+        }
+        xfer = EXS_LittleEndianExplicit;
+    }
+
+    // CIF_MayDetachPixelData lets DicomImage drop the dataset's copy of the
+    // pixels once its own intermediate buffer has been filled.
+    // Unless a Modality LUT Sequence is present we keep the stored values and
+    // carry slope/intercept alongside, so the buffer stays at native width.
+    unsigned long image_flags = CIF_MayDetachPixelData;
+    const bool keep_stored_values = !ds->tagExistsWithValue(DCM_ModalityLUTSequence);
+    if (keep_stored_values) {
+        image_flags |= CIF_IgnoreModalityTransformation;
+    }
+    DicomImage dcm_image(&file, xfer, image_flags);
+    slice.timings.decode_usec = get_ticks_usec() - stage_start;
+
+    EI_Status status = dcm_image.getStatus();
+    if (status != EIS_Normal) {
+        error = "DCMTK DicomImage Error (status " + std::to_string((int)status) + "): " +
+                DicomImage::getString(status);
+        return false;
+    }
+
+    stage_start = get_ticks_usec();
+    const double buffer_slope = keep_stored_values ? info.rescale_slope : 1.0;
+    const double buffer_intercept = keep_stored_values ? info.rescale_intercept : 0.0;
+    if (!copy_inter_data(dcm_image, buffer_slope, buffer_intercept, slice.pixels, error)) {
+        return false;
+    }
+    slice.timings.convert_usec = get_ticks_usec() - stage_start;
+    return true;
+}
+
+bool read_dicom_header(const std::string &path, SliceInfo &info, std::string &error) {
+    // Parsing stops at Pixel Data and values over the default read length
+    // are left on disk, so only the first few KB of a file are touched
+    DcmFileFormat file;
+    OFCondition status = file.loadFileUntilTag(path.c_str(), EXS_Unknown, EGL_noChange, DCM_MaxReadLength,
+            ERM_autoDetect, DCM_PixelData);
+    if (!status.good()) {
+        error = std::string("DCMTK Error loading file: ") + status.text();
+        return false;
+    }
+    DcmDataset *ds = file.getDataset();
+    if (!ds) {
+        error = "DCMTK Error: No dataset found";
+        return false;
+    }
+    read_slice_info(ds, info);
+    apply_first_frame_values(ds, info);
+    Uint16 rows = 0, cols = 0;
+    if (ds->findAndGetUint16(DCM_Rows, rows).good()) info.rows = rows;
+    if (ds->findAndGetUint16(DCM_Columns, cols).good()) info.columns = cols;
+    return true;
+}
+
+struct FrameSource::Backend {
+    // Header in memory; Pixel Data stays on disk for partial access
+    std::unique_ptr<DcmFileFormat> file;
+    E_TransferSyntax xfer = EXS_Unknown;
+    unsigned long image_flags = 0;
+    bool keep_stored_values = true;
+    SliceInfo info;
+    std::vector<FrameValues> frame_values;
+    std::shared_ptr<const TagStore> tags;
+    // DicomImage reads frames through the dataset's file stream
+    std::mutex mutex;
+};
+
+bool FrameSource::open(const std::string &p_path, std::string &error) {
+    // Values over the default read length, Pixel Data included, are loaded
+    // on demand
+    std::unique_ptr<DcmFileFormat> file(new DcmFileFormat());
+    OFCondition status = file->loadFile(p_path.c_str());
+    if (!status.good()) {
+        error = std::string("DCMTK Error loading file: ") + status.text();
+        return false;
+    }
+    return open(p_path, std::move(file), error);
+}
+
+bool FrameSource::open(const std::string &p_path, std::unique_ptr<DcmFileFormat> file, std::string &error) {
+    register_dcmtk_codecs();
+    std::unique_ptr<Backend> fresh(new Backend());
+    fresh->file = std::move(file);
+    DcmDataset *ds = fresh->file->getDataset();
+    if (!ds) {
+        error = "DCMTK Error: No dataset found";
+        return false;
+    }
+    SliceInfo &info = fresh->info;
+    read_slice_info(ds, info);
+    Uint16 rows = 0, cols = 0;
+    if (!ds->findAndGetUint16(DCM_Rows, rows).good() || !ds->findAndGetUint16(DCM_Columns, cols).good() || rows == 0 || cols == 0) {
+        error = "DCMTK Error: Missing image dimensions (Rows/Columns)";
+        return false;
+    }
+    info.rows = rows;
+    info.columns = cols;
+    read_frame_values(ds, info.frame_count, fresh->frame_values);
+    std::shared_ptr<TagStore> tags = std::make_shared<TagStore>();
+    collect_file_tags(*fresh->file, *tags);
+    tags->finish();
+    fresh->tags = tags;
+
+    // Same value handling as decode_dicom_file(), but DicomImage must not
+    // detach or load the whole Pixel Data element
+    fresh->xfer = ds->getOriginalXfer();
+    fresh->keep_stored_values = !ds->tagExistsWithValue(DCM_ModalityLUTSequence);
+    fresh->image_flags = CIF_UsePartialAccessToPixelData;
+    if (fresh->keep_stored_values) {
+        fresh->image_flags |= CIF_IgnoreModalityTransformation;
+    }
+
+    path = p_path;
+    frame_count = info.frame_count;
+    backend = std::move(fresh);
+    return true;
+}
+
+bool FrameSource::decode_frame(int index, DecodedSlice &slice, std::string &error) const {
+    if (!backend || index < 0 || index >= frame_count) {
+        error = "Frame index out of range";
+        return false;
+    }
+    SliceInfo info = backend->info;
+    if (size_t(index) < backend->frame_values.size()) {
+        backend->frame_values[size_t(index)].apply(info);
+    }
+    std::lock_guard<std::mutex> lock(backend->mutex);
+    uint64_t stage_start = get_ticks_usec();
+    DicomImage dcm_image(backend->file.get(), backend->xfer, backend->image_flags, (unsigned long)index, 1);
+    slice.timings.parse_usec = 0;
+    slice.timings.decode_usec = get_ticks_usec() - stage_start;
+    EI_Status status = dcm_image.getStatus();
+    if (status != EIS_Normal) {
+        error = "DCMTK DicomImage Error (status " + std::to_string((int)status) + "): " +
+                DicomImage::getString(status);
+        return false;
+    }
+
+    stage_start = get_ticks_usec();
+    const double buffer_slope = backend->keep_stored_values ? info.rescale_slope : 1.0;
+    const double buffer_intercept = backend->keep_stored_values ? info.rescale_intercept : 0.0;
+    if (!copy_inter_data(dcm_image, buffer_slope, buffer_intercept, slice.pixels, error)) {
+        return false;
+    }
+    slice.timings.convert_usec = get_ticks_usec() - stage_start;
+    slice.path = path;
+    slice.info = info;
+    slice.tags = backend->tags;
+    slice.frame_index = index;
+    slice.frames = shared_from_this();
+    return true;
+}
+
+#else
+
+struct FrameSource::Backend {
+    BuiltinFile file;
+};
+
+bool FrameSource::open(const std::string &p_path, std::string &error) {
+    std::unique_ptr<Backend> fresh(new Backend());
+    if (!builtin_open(p_path, fresh->file, error)) {
+        return false;
+    }
+    path = p_path;
+    frame_count = fresh->file.frame_count;
+    backend = std::move(fresh);
+    return true;
+}
+
+bool FrameSource::decode_frame(int index, DecodedSlice &slice, std::string &error) const {
+    if (!backend || index < 0 || index >= frame_count) {
+        error = "Frame index out of range";
+        return false;
+    }
+    slice.timings.parse_usec = 0;
+    builtin_get_frame_info(backend->file, index, slice.info);
+    if (!builtin_decode_frame(backend->file, index, slice.info, slice.pixels, slice.timings, error)) {
+        return false;
+    }
+    slice.path = path;
+    slice.tags = backend->file.tags;
+    slice.frame_index = index;
+    slice.frames = shared_from_this();
+    return true;
+}
+
+// Every file is opened as a FrameSource; only frame 0 is decoded, and
+// single-frame slices drop the source
+static bool decode_first_frame(const std::string &path, DecodedSlice &slice, std::string &error) {
+    const uint64_t stage_start = get_ticks_usec();
+    std::shared_ptr<FrameSource> source = std::make_shared<FrameSource>();
+    if (!source->open(path, error)) {
+        return false;
+    }
+    const uint64_t parse_usec = get_ticks_usec() - stage_start;
+    if (!source->decode_frame(0, slice, error)) {
+        return false;
+    }
+    slice.timings.parse_usec = parse_usec;
+    if (source->get_frame_count() < 2) {
+        slice.frames.reset();
+    }
+    return true;
+}
+
+// Without DCMTK the built-in Part 10 reader takes over
+bool decode_dicom_file(const std::string &path, DecodedSlice &slice, std::string &error, DecodeFailure *failure) {
+    slice.path = path;
+    if (decode_first_frame(path, slice, error)) {
+        return true;
+    }
+    if (failure) {
+        *failure = builtin_is_other_format(path) ? DECODE_NOT_DICOM : DECODE_FAILED;
+    }
+    return false;
+}
+
+bool read_dicom_header(const std::string &path, SliceInfo &info, std::string &error) {
+    return builtin_read_header(path, info, error);
+}
+
+#endif // USE_DCMTK
+
+} // namespace dicom
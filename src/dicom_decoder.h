@@ -0,0 +1,169 @@
+#pragma once
+
+#include "pixel_buffer.h"
+#include "tag_store.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#ifdef USE_DCMTK
+class DcmFileFormat;
+#endif
+
+namespace dicom {
+
+// Header fields of a decoded image that the viewer and its helpers use
+struct SliceInfo {
+    std::string modality;
+    std::string transfer_syntax;
+    std::string photometric_interpretation;
+    std::string study_instance_uid;
+    std::string series_instance_uid;
+    std::string sop_instance_uid;
+
+    int rows = 0;
+    int columns = 0;
+    int bits_allocated = 16;
+    int bits_stored = 12;
+    int high_bit = 15;
+    int pixel_representation = 0;
+    // Number of Frames; 1 for single-frame images
+    int frame_count = 1;
+
+    // Row spacing (vertical) and column spacing (horizontal) in mm
+    double pixel_spacing_row = 1.0;
+    double pixel_spacing_col = 1.0;
+    bool has_pixel_spacing = false;
+    // Height of a pixel relative to its width
+    float pixel_aspect_ratio = 1.0f;
+
+    // Geometry for stacking slices into a volume
+    int instance_number = 0;
+    bool has_instance_number = false;
+    double image_position[3] = { 0.0, 0.0, 0.0 };
+    bool has_image_position = false;
+    // Row direction cosines followed by column direction cosines
+    double image_orientation[6] = { 1.0, 0.0, 0.0, 0.0, 1.0, 0.0 };
+    bool has_image_orientation = false;
+    double slice_thickness = 0.0;
+    double spacing_between_slices = 0.0;
+
+    double rescale_slope = 1.0;
+    double rescale_intercept = 0.0;
+
+    // First Window Center/Width pair from the file, if any
+    double voi_center = 0.0;
+    double voi_width = 0.0;
+    bool has_voi = false;
+};
+
+// Values an enhanced multi-frame file (Enhanced CT, MR, ...) keeps per
+// frame in its Shared and Per-Frame Functional Groups (5200,9229 /
+// 5200,9230) instead of at the top level: Pixel Value Transformation, Frame
+// VOI LUT, Plane Position and Orientation, and Pixel Measures. The flags
+// tell which groups were present.
+struct FrameValues {
+    bool has_rescale = false;
+    double rescale_slope = 1.0;
+    double rescale_intercept = 0.0;
+
+    bool has_voi = false;
+    double voi_center = 0.0;
+    double voi_width = 0.0;
+
+    bool has_image_position = false;
+    double image_position[3] = { 0.0, 0.0, 0.0 };
+    bool has_image_orientation = false;
+    double image_orientation[6] = { 1.0, 0.0, 0.0, 0.0, 1.0, 0.0 };
+
+    bool has_pixel_spacing = false;
+    double pixel_spacing_row = 1.0;
+    double pixel_spacing_col = 1.0;
+    bool has_slice_thickness = false;
+    double slice_thickness = 0.0;
+
+    // Overwrite the fields of `info` these values are present for
+    void apply(SliceInfo &info) const;
+};
+
+// Per-stage durations of one decode, in microseconds
+struct DecodeTimings {
+    uint64_t parse_usec = 0;
+    uint64_t decode_usec = 0;
+    uint64_t convert_usec = 0;
+};
+
+class FrameSource;
+
+// One fully decoded image (a frame, for multi-frame files). Treated as
+// immutable once built, so it can be shared between threads and viewers.
+struct DecodedSlice {
+    std::string path;
+    SliceInfo info;
+    // Every header element read from the file; shared with copies such as
+    // previews. Null when the source was not a DICOM file.
+    std::shared_ptr<const TagStore> tags;
+    PixelBuffer pixels;
+    DecodeTimings timings;
+    // Multi-frame files: which frame this is, and the open file the other
+    // frames are decoded from on request
+    int frame_index = 0;
+    std::shared_ptr<const FrameSource> frames;
+};
+
+// A multi-frame file opened for decoding one frame at a time. Opening reads
+// the header only; each decode_frame() reads and decodes just that frame
+// (DCMTK's partial access to Pixel Data, or a memory map with the built-in
+// reader), so a file of hundreds of frames is never decoded up front.
+// Create through std::make_shared; decoded frames refer back to it.
+// Thread-safe.
+class FrameSource : public std::enable_shared_from_this<FrameSource> {
+public:
+    FrameSource();
+    ~FrameSource();
+
+    bool open(const std::string &path, std::string &error);
+#ifdef USE_DCMTK
+    // Take over `file`, whose header the caller has already loaded with
+    // Pixel Data left on disk, instead of parsing the file again
+    bool open(const std::string &path, std::unique_ptr<DcmFileFormat> file, std::string &error);
+#endif
+
+    const std::string &get_path() const { return path; }
+    int get_frame_count() const { return frame_count; }
+
+    // Decode frame `index` into `slice`. Tags are shared by every frame;
+    // header fields include the frame's own Functional Group values.
+    bool decode_frame(int index, DecodedSlice &slice, std::string &error) const;
+
+private:
+    struct Backend;
+    std::unique_ptr<Backend> backend;
+    std::string path;
+    int frame_count = 0;
+};
+
+// Why decode_dicom_file() failed, for callers that act on it; `error` is
+// the message for people
+enum DecodeFailure {
+    DECODE_FAILED,
+    // Not a DICOM Part 10 file: possibly another image format
+    DECODE_NOT_DICOM,
+};
+
+// Decode the file at the absolute filesystem path `path`. Thread-safe; does
+// not touch any engine state. On failure returns false and fills `error`,
+// and `failure` when given. Multi-frame files decode their first frame and
+// keep a FrameSource.
+bool decode_dicom_file(const std::string &path, DecodedSlice &slice, std::string &error, DecodeFailure *failure = nullptr);
+
+// Read only the header of the file at `path`, stopping before Pixel Data.
+// Fills `info` including rows/columns. Thread-safe. Returns false (with
+// `error`) for files that are not DICOM.
+bool read_dicom_header(const std::string &path, SliceInfo &info, std::string &error);
+
+// Microseconds from a monotonic clock, for stage timings
+uint64_t get_ticks_usec();
+
+} // namespace dicom
@@ -0,0 +1,135 @@
+#include "dicom_indexer.h"
+#include "dicom_viewer.h"
+
+#include <string>
+#include <unordered_map>
+
+#include <godot_cpp/classes/dir_access.hpp>
+#include <godot_cpp/classes/time.hpp>
+#include <godot_cpp/core/class_db.hpp>
+#include <godot_cpp/variant/packed_string_array.hpp>
+#include <godot_cpp/variant/utility_functions.hpp>
+#include <godot_cpp/variant/vector3.hpp>
+
+using namespace godot;
+
+void DicomIndexer::_bind_methods() {
+    ClassDB::bind_method(D_METHOD("scan_directory", "dir_path", "recursive"), &DicomIndexer::scan_directory, DEFVAL(true));
+    ClassDB::bind_method(D_METHOD("index_files", "paths"), &DicomIndexer::index_files);
+    ClassDB::bind_method(D_METHOD("get_series"), &DicomIndexer::get_series);
+    ClassDB::bind_method(D_METHOD("get_file_count"), &DicomIndexer::get_file_count);
+    ClassDB::bind_method(D_METHOD("get_skipped_count"), &DicomIndexer::get_skipped_count);
+    ClassDB::bind_method(D_METHOD("get_scan_time_usec"), &DicomIndexer::get_scan_time_usec);
+}
+
+DicomIndexer::DicomIndexer() {
+    skipped = 0;
+    scan_usec = 0;
+}
+
+void DicomIndexer::list_files(const String &dir_path, bool recursive, std::vector<String> &files) {
+    Ref<DirAccess> dir = DirAccess::open(dir_path);
+    if (dir.is_null()) {
+        UtilityFunctions::push_error("Failed to open directory: ", dir_path);
+        return;
+    }
+    // Hidden files such as .DS_Store are never DICOM
+    dir->set_include_hidden(false);
+    const PackedStringArray names = dir->get_files();
+    for (int i = 0; i < names.size(); ++i) {
+        files.push_back(dir_path.path_join(names[i]));
+    }
+    if (recursive) {
+        const PackedStringArray subdirs = dir->get_directories();
+        for (int i = 0; i < subdirs.size(); ++i) {
+            list_files(dir_path.path_join(subdirs[i]), recursive, files);
+        }
+    }
+}
+
+Array DicomIndexer::scan_directory(const String &dir_path, bool recursive) {
+    const uint64_t scan_start = Time::get_singleton()->get_ticks_usec();
+    std::vector<String> files;
+    list_files(dir_path, recursive, files);
+    Array paths;
+    paths.resize((int64_t)files.size());
+    for (size_t i = 0; i < files.size(); ++i) {
+        paths[(int64_t)i] = files[i];
+    }
+    Array result = index_files(paths);
+    scan_usec = Time::get_singleton()->get_ticks_usec() - scan_start;
+    return result;
+}
+
+Array DicomIndexer::index_files(const Array &paths) {
+    const uint64_t scan_start = Time::get_singleton()->get_ticks_usec();
+
+    std::vector<std::string> absolute_paths;
+    absolute_paths.reserve(paths.size());
+    std::unordered_map<std::string, String> given_paths;
+    for (int i = 0; i < paths.size(); ++i) {
+        const String path = paths[i];
+        absolute_paths.push_back(DicomViewer::globalize_path(path).utf8().get_data());
+        given_paths[absolute_paths.back()] = path;
+    }
+
+    size_t skipped_files = 0;
+    dicom::read_headers(absolute_paths, entries, skipped_files);
+    dicom::sort_headers(entries);
+    skipped = (int64_t)skipped_files;
+
+    entry_paths.clear();
+    entry_paths.reserve(entries.size());
+    Array result;
+    for (const dicom::HeaderEntry &entry : entries) {
+        const dicom::SliceInfo &info = entry.info;
+        entry_paths.push_back(given_paths[entry.path]);
+
+        Dictionary item;
+        item["path"] = entry_paths.back();
+        item["study_instance_uid"] = String::utf8(info.study_instance_uid.c_str());
+        item["series_instance_uid"] = String::utf8(info.series_instance_uid.c_str());
+        item["sop_instance_uid"] = String::utf8(info.sop_instance_uid.c_str());
+        item["modality"] = String::utf8(info.modality.c_str());
+        item["rows"] = info.rows;
+        item["columns"] = info.columns;
+        item["frame_count"] = info.frame_count;
+        if (info.has_instance_number) {
+            item["instance_number"] = info.instance_number;
+        }
+        if (info.has_image_position) {
+            item["image_position"] = Vector3((real_t)info.image_position[0], (real_t)info.image_position[1], (real_t)info.image_position[2]);
+        }
+        if (info.has_image_orientation) {
+            const double *o = info.image_orientation;
+            item["row_direction"] = Vector3((real_t)o[0], (real_t)o[1], (real_t)o[2]);
+            item["column_direction"] = Vector3((real_t)o[3], (real_t)o[4], (real_t)o[5]);
+        }
+        result.append(item);
+    }
+
+    scan_usec = Time::get_singleton()->get_ticks_usec() - scan_start;
+    return result;
+}
+
+Array DicomIndexer::get_series() const {
+    Array series;
+    Dictionary current;
+    Array current_paths;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const dicom::SliceInfo &info = entries[i].info;
+        // Entries are sorted, so a series is a contiguous run
+        if (i == 0 || info.series_instance_uid != entries[i - 1].info.series_instance_uid ||
+                info.study_instance_uid != entries[i - 1].info.study_instance_uid) {
+            current = Dictionary();
+            current_paths = Array();
+            current["study_instance_uid"] = String::utf8(info.study_instance_uid.c_str());
+            current["series_instance_uid"] = String::utf8(info.series_instance_uid.c_str());
+            current["modality"] = String::utf8(info.modality.c_str());
+            current["paths"] = current_paths;
+            series.append(current);
+        }
+        current_paths.append(entry_paths[i]);
+    }
+    return series;
+}
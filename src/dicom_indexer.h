@@ -0,0 +1,51 @@
+#pragma once
+
+#include "header_index.h"
+
+#include <godot_cpp/classes/ref_counted.hpp>
+#include <godot_cpp/variant/array.hpp>
+#include <godot_cpp/variant/dictionary.hpp>
+#include <godot_cpp/variant/string.hpp>
+
+#include <vector>
+
+namespace godot {
+
+// Finds the DICOM files among many paths by reading headers only, and
+// orders them by study, series and slice position
+class DicomIndexer : public RefCounted {
+    GDCLASS(DicomIndexer, RefCounted);
+
+private:
+    std::vector<dicom::HeaderEntry> entries;
+    // Paths as given (res://, user:// or absolute), parallel to `entries`
+    std::vector<String> entry_paths;
+    int64_t skipped;
+    uint64_t scan_usec;
+
+    static void list_files(const String &dir_path, bool recursive, std::vector<String> &files);
+
+protected:
+    static void _bind_methods();
+
+public:
+    DicomIndexer();
+
+    // Index every file under `dir_path`. Returns one Dictionary per DICOM
+    // file (see index_files()).
+    Array scan_directory(const String &dir_path, bool recursive);
+    // Read the headers of `paths` in parallel. Returns one Dictionary per
+    // DICOM file with path, study/series/SOP instance UIDs, instance number,
+    // position, orientation, modality, rows, columns and frame count, sorted
+    // by study, series and slice position. Other files are skipped.
+    Array index_files(const Array &paths);
+
+    // The last result grouped per series: series_instance_uid,
+    // study_instance_uid, modality and ordered paths
+    Array get_series() const;
+    int64_t get_file_count() const { return (int64_t)entries.size(); }
+    int64_t get_skipped_count() const { return skipped; }
+    int64_t get_scan_time_usec() const { return (int64_t)scan_usec; }
+};
+
+}
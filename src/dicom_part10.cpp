@@ -0,0 +1,194 @@
+#include "dicom_part10.h"
+
+#include <cstring>
+
+namespace dicom {
+
+namespace {
+
+const char *const TS_IMPLICIT_LITTLE = "1.2.840.10008.1.2";
+const char *const TS_EXPLICIT_LITTLE = "1.2.840.10008.1.2.1";
+const char *const TS_DEFLATED = "1.2.840.10008.1.2.1.99";
+const char *const TS_EXPLICIT_BIG = "1.2.840.10008.1.2.2";
+
+// Explicit VRs with a 2-byte reserved field and a 4-byte length
+bool has_long_length(const char *vr) {
+    static const char *const long_vrs[] = { "OB", "OD", "OF", "OL", "OV", "OW", "SQ", "SV", "UC", "UN", "UR", "UT", "UV" };
+    for (const char *candidate : long_vrs) {
+        if (vr[0] == candidate[0] && vr[1] == candidate[1]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Nesting limit against malformed or hostile files
+const int MAX_DEPTH = 16;
+
+} // namespace
+
+bool Part10Reader::has_part10_prefix(const uint8_t *p_data, size_t p_size) {
+    return p_size >= 132 && std::memcmp(p_data + 128, "DICM", 4) == 0;
+}
+
+bool Part10Reader::open(const uint8_t *p_data, size_t p_size, std::string &error) {
+    data = p_data;
+    size = p_size;
+    transfer_syntax.clear();
+    truncated = false;
+    if (!has_part10_prefix(data, size)) {
+        error = "Not a DICOM Part 10 file";
+        return false;
+    }
+
+    // The meta group is always explicit VR little endian
+    size_t pos = 132;
+    while (pos + 8 <= size && read16(pos) == 0x0002) {
+        Element element;
+        if (!read_element(pos, true, element, error)) {
+            return false;
+        }
+        if (element.element == 0x0010 && element.value) {
+            transfer_syntax.assign(reinterpret_cast<const char *>(element.value), element.length);
+            while (!transfer_syntax.empty() && (transfer_syntax.back() == '\0' || transfer_syntax.back() == ' ')) {
+                transfer_syntax.pop_back();
+            }
+        }
+    }
+    dataset_offset = pos;
+
+    if (transfer_syntax.empty()) {
+        error = "Missing transfer syntax";
+        return false;
+    }
+    if (transfer_syntax == TS_EXPLICIT_BIG || transfer_syntax == TS_DEFLATED) {
+        error = "Unsupported transfer syntax " + transfer_syntax;
+        return false;
+    }
+    explicit_vr = transfer_syntax != TS_IMPLICIT_LITTLE;
+    encapsulated = transfer_syntax != TS_IMPLICIT_LITTLE && transfer_syntax != TS_EXPLICIT_LITTLE;
+    return true;
+}
+
+bool Part10Reader::read_element(size_t &pos, bool explicit_encoding, Element &element, std::string &error, int depth) const {
+    if (pos + 8 > size) {
+        truncated = true;
+        error = "Truncated element header";
+        return false;
+    }
+    element.group = read16(pos);
+    element.element = read16(pos + 2);
+    uint32_t length;
+    bool is_sequence = false;
+    if (element.group == ITEM_GROUP) {
+        // Item delimiters have no VR in any encoding
+        length = read32(pos + 4);
+        pos += 8;
+    } else if (explicit_encoding) {
+        element.vr[0] = char(data[pos + 4]);
+        element.vr[1] = char(data[pos + 5]);
+        if (has_long_length(element.vr)) {
+            if (pos + 12 > size) {
+                truncated = true;
+                error = "Truncated element header";
+                return false;
+            }
+            length = read32(pos + 8);
+            pos += 12;
+        } else {
+            length = read16(pos + 6);
+            pos += 8;
+        }
+        is_sequence = element.vr[0] == 'S' && element.vr[1] == 'Q';
+    } else {
+        length = read32(pos + 4);
+        pos += 8;
+    }
+    element.length = length;
+    element.offset = pos;
+
+    const bool is_pixel_data = element.group == 0x7FE0 && element.element == 0x0010;
+    if (length == UNDEFINED_LENGTH) {
+        if (is_pixel_data) {
+            // Encapsulated fragments follow; the caller takes it from here
+            element.value = nullptr;
+            pos = size;
+            return true;
+        }
+        // An undefined length is a sequence whatever the VR says (SQ, or
+        // UN/implicit encodings of one)
+        element.value = nullptr;
+        return skip_sequence(pos, explicit_encoding && !(element.vr[0] == 'U' && element.vr[1] == 'N'), depth, error);
+    }
+    if (length > size - pos) {
+        if (is_pixel_data && header_only) {
+            element.value = nullptr;
+            pos = size;
+            return true;
+        }
+        truncated = true;
+        error = "Element value runs past the end of the file";
+        return false;
+    }
+    element.value = is_sequence ? nullptr : data + pos;
+    pos += length;
+    return true;
+}
+
+bool Part10Reader::skip_sequence(size_t &pos, bool explicit_encoding, int depth, std::string &error) const {
+    if (depth > MAX_DEPTH) {
+        error = "Sequences nested too deeply";
+        return false;
+    }
+    while (pos + 8 <= size) {
+        const uint16_t group = read16(pos);
+        const uint16_t element = read16(pos + 2);
+        const uint32_t length = read32(pos + 4);
+        pos += 8;
+        if (group != ITEM_GROUP) {
+            error = "Malformed sequence";
+            return false;
+        }
+        if (element == SEQUENCE_END) {
+            return true;
+        }
+        if (element != ITEM) {
+            error = "Malformed sequence item";
+            return false;
+        }
+        if (length != UNDEFINED_LENGTH) {
+            if (length > size - pos) {
+                truncated = true;
+                error = "Sequence item runs past the end of the file";
+                return false;
+            }
+            pos += length;
+            continue;
+        }
+        // Undefined-length item: elements until the item delimiter
+        for (;;) {
+            if (pos + 8 > size) {
+                truncated = true;
+                error = "Truncated sequence item";
+                return false;
+            }
+            if (read16(pos) == ITEM_GROUP && read16(pos + 2) == ITEM_END) {
+                pos += 8;
+                break;
+            }
+            Element nested;
+            if (!read_element(pos, explicit_encoding, nested, error, depth + 1)) {
+                return false;
+            }
+            if (nested.group == 0x7FE0 && nested.element == 0x0010 && nested.length == UNDEFINED_LENGTH) {
+                error = "Encapsulated Pixel Data inside a sequence";
+                return false;
+            }
+        }
+    }
+    truncated = true;
+    error = "Truncated sequence";
+    return false;
+}
+
+} // namespace dicom
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace dicom {
+
+// Minimal reader for the layout of a DICOM Part 10 file held in memory
+// (typically a MappedFile). It walks the file meta group and the top-level
+// dataset elements without copying values, so callers can locate Pixel Data
+// or pick out header fields. Big endian and deflated transfer syntaxes are
+// not supported.
+class Part10Reader {
+public:
+    static const uint32_t UNDEFINED_LENGTH = 0xFFFFFFFFu;
+
+    struct Element {
+        uint16_t group = 0;
+        uint16_t element = 0;
+        // "??" for implicit VR files
+        char vr[2] = { '?', '?' };
+        // Points into the file; null for sequences, which are skipped (see
+        // for_each_item_element())
+        const uint8_t *value = nullptr;
+        uint32_t length = 0;
+        // Offset of the value from the start of the file
+        size_t offset = 0;
+    };
+
+    // Whether `p_data` starts with the 128-byte preamble and "DICM"
+    static bool has_part10_prefix(const uint8_t *p_data, size_t p_size);
+
+    // Parse the preamble and file meta group. Fails for files without the
+    // "DICM" prefix or with an unsupported transfer syntax.
+    bool open(const uint8_t *p_data, size_t p_size, std::string &error);
+    // The data is only the start of the file, read for its header: Pixel
+    // Data running past the end is reported with a null value instead of
+    // failing the walk. Set before walking.
+    void set_header_only(bool p_header_only) { header_only = p_header_only; }
+    // The last failure was the data ending early rather than a malformed
+    // file; for a header-only prefix, more of the file may parse
+    bool is_truncated() const { return truncated; }
+
+    const std::string &get_transfer_syntax() const { return transfer_syntax; }
+    bool is_explicit_vr() const { return explicit_vr; }
+    // Pixel Data is a sequence of compressed fragments
+    bool is_encapsulated() const { return encapsulated; }
+
+    // Visit the top-level dataset elements in file order. `fn(element)`
+    // returns false to stop early. Returns false (with `error`) on a
+    // malformed file.
+    template <typename Fn>
+    bool for_each_element(Fn &&fn, std::string &error) const {
+        size_t pos = dataset_offset;
+        while (pos < size) {
+            Element element;
+            if (!read_element(pos, explicit_vr, element, error)) {
+                return false;
+            }
+            if (!fn(static_cast<const Element &>(element))) {
+                return true;
+            }
+        }
+        return true;
+    }
+
+    // Visit the elements of each item of `sequence`, a sequence element
+    // reported by for_each_element() or by an earlier call of this one.
+    // `fn(item_index, element)` returns false to stop early. Returns false
+    // (with `error`) on a malformed sequence.
+    template <typename Fn>
+    bool for_each_item_element(const Element &sequence, Fn &&fn, std::string &error) const {
+        const bool defined = sequence.length != UNDEFINED_LENGTH;
+        if (sequence.offset > size || (defined && sequence.length > size - sequence.offset)) {
+            truncated = true;
+            error = "Sequence runs past the end of the file";
+            return false;
+        }
+        const size_t end = defined ? sequence.offset + sequence.length : size;
+        size_t pos = sequence.offset;
+        for (int item = 0; pos + 8 <= end; ++item) {
+            const uint16_t group = read16(pos);
+            const uint16_t tag = read16(pos + 2);
+            const uint32_t length = read32(pos + 4);
+            pos += 8;
+            if (group == ITEM_GROUP && tag == SEQUENCE_END) {
+                return true;
+            }
+            if (group != ITEM_GROUP || tag != ITEM) {
+                error = "Malformed sequence item";
+                return false;
+            }
+            const bool item_defined = length != UNDEFINED_LENGTH;
+            if (item_defined && length > end - pos) {
+                truncated = true;
+                error = "Sequence item runs past the end of the file";
+                return false;
+            }
+            const size_t item_end = item_defined ? pos + length : end;
+            while (pos < item_end) {
+                if (!item_defined && pos + 8 <= item_end && read16(pos) == ITEM_GROUP && read16(pos + 2) == ITEM_END) {
+                    pos += 8;
+                    break;
+                }
+                Element element;
+                if (!read_element(pos, explicit_vr, element, error, 1)) {
+                    return false;
+                }
+                if (!fn(item, static_cast<const Element &>(element))) {
+                    return true;
+                }
+            }
+        }
+        return true;
+    }
+
+private:
+    static const uint16_t ITEM_GROUP = 0xFFFE;
+    static const uint16_t ITEM = 0xE000;
+    static const uint16_t ITEM_END = 0xE00D;
+    static const uint16_t SEQUENCE_END = 0xE0DD;
+
+    // Read the element at `pos` and advance past it (past the whole
+    // sequence for SQ; to the first fragment for encapsulated Pixel Data)
+    bool read_element(size_t &pos, bool explicit_encoding, Element &element, std::string &error, int depth = 0) const;
+    // Skip an undefined-length sequence or item list starting at `pos`
+    bool skip_sequence(size_t &pos, bool explicit_encoding, int depth, std::string &error) const;
+
+    uint16_t read16(size_t pos) const { return uint16_t(data[pos] | (data[pos + 1] << 8)); }
+    uint32_t read32(size_t pos) const {
+        return uint32_t(data[pos]) | (uint32_t(data[pos + 1]) << 8) | (uint32_t(data[pos + 2]) << 16) | (uint32_t(data[pos + 3]) << 24);
+    }
+
+    const uint8_t *data = nullptr;
+    size_t size = 0;
+    size_t dataset_offset = 0;
+    std::string transfer_syntax;
+    bool explicit_vr = true;
+    bool encapsulated = false;
+    bool header_only = false;
+    mutable bool truncated = false;
+};
+
+} // namespace dicom
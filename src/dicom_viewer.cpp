@@ -1,49 +1,56 @@
 #include "dicom_viewer.h"
+#include "downsample.h"
+#include "projection.h"
+#include "slice_cache.h"
+#include "thread_pool.h"
+#include "thumbnail_cache.h"
+#include "transcode_cache.h"
+#include "window_simd.h"
 
-#ifdef USE_DCMTK
-#include <dcmtk/dcmimgle/dcmimage.h>
-#include <dcmtk/dcmdata/dctk.h>
-#include <dcmtk/ofstd/ofstd.h>
-#include <dcmtk/ofstd/ofstring.h>
-// Add these headers for decompression support
-#include <dcmtk/dcmjpeg/djdecode.h>  // JPEG decoders
-#include <dcmtk/dcmjpls/djdecode.h>  // JPEG-LS decoders  
-#include <dcmtk/dcmdata/dcrledrg.h>  // RLE decoder
-#endif
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
 
 #include <godot_cpp/variant/packed_byte_array.hpp>
+#include <godot_cpp/variant/packed_string_array.hpp>
 #include <godot_cpp/variant/utility_functions.hpp>
 #include <godot_cpp/classes/os.hpp>
 #include <godot_cpp/classes/project_settings.hpp>
+#include <godot_cpp/classes/time.hpp>
+#include <godot_cpp/core/class_db.hpp>
 
 using namespace godot;
 
 // Uncomment this line to enable verbose DICOM loading debug output
 // #define DEBUG_DICOM_LOADING
 
-#ifdef USE_DCMTK
-// Static flag to ensure we only register codecs once
-static bool dcmtk_codecs_registered = false;
-
-static void register_dcmtk_codecs() {
-    if (!dcmtk_codecs_registered) {
-        // Register JPEG decompression codecs
-        DJDecoderRegistration::registerCodecs();
-        // Register JPEG-LS decompression codecs
-        DJLSDecoderRegistration::registerCodecs();
-        // Register RLE decompression codec
-        DcmRLEDecoderRegistration::registerCodecs();
-        
-        dcmtk_codecs_registered = true;
-        #ifdef DEBUG_DICOM_LOADING
-        UtilityFunctions::print("DCMTK decompression codecs registered");
-        #endif
-    }
-}
-#endif
-
 void DicomViewer::_bind_methods() {
     ClassDB::bind_method(D_METHOD("load_dicom", "path"), &DicomViewer::load_dicom);
+    ClassDB::bind_method(D_METHOD("load_dicom_async", "path"), &DicomViewer::load_dicom_async);
+    ClassDB::bind_method(D_METHOD("is_loading"), &DicomViewer::is_loading);
+    ClassDB::bind_method(D_METHOD("show_volume_slice", "volume", "index"), &DicomViewer::show_volume_slice);
+    ClassDB::bind_method(D_METHOD("show_volume_plane", "volume", "axis", "index"), &DicomViewer::show_volume_plane);
+    ClassDB::bind_method(D_METHOD("show_volume_slab", "volume", "axis", "index", "thickness_mm", "mode"), &DicomViewer::show_volume_slab, DEFVAL(DicomVolume::PROJECTION_MAX));
+    ClassDB::bind_method(D_METHOD("get_frame_count"), &DicomViewer::get_frame_count);
+    ClassDB::bind_method(D_METHOD("get_frame"), &DicomViewer::get_frame);
+    ClassDB::bind_method(D_METHOD("set_frame", "index"), &DicomViewer::set_frame);
+    ClassDB::bind_method(D_METHOD("set_progressive_loading", "enabled"), &DicomViewer::set_progressive_loading);
+    ClassDB::bind_method(D_METHOD("is_progressive_loading"), &DicomViewer::is_progressive_loading);
+    ClassDB::bind_method(D_METHOD("set_progressive_threshold", "pixels"), &DicomViewer::set_progressive_threshold);
+    ClassDB::bind_method(D_METHOD("get_progressive_threshold"), &DicomViewer::get_progressive_threshold);
+    ClassDB::bind_method(D_METHOD("set_preview_factor", "factor"), &DicomViewer::set_preview_factor);
+    ClassDB::bind_method(D_METHOD("get_preview_factor"), &DicomViewer::get_preview_factor);
+    ClassDB::bind_method(D_METHOD("create_thumbnail", "path", "max_size"), &DicomViewer::create_thumbnail, DEFVAL(256));
+    ClassDB::bind_static_method("DicomViewer", D_METHOD("create_thumbnails", "paths", "max_size"), &DicomViewer::create_thumbnails, DEFVAL(128));
+    ClassDB::bind_static_method("DicomViewer", D_METHOD("clear_thumbnail_cache"), &DicomViewer::clear_thumbnail_cache);
+    ClassDB::bind_static_method("DicomViewer", D_METHOD("transcode_files", "paths"), &DicomViewer::transcode_files);
+    ClassDB::bind_static_method("DicomViewer", D_METHOD("clear_transcode_cache"), &DicomViewer::clear_transcode_cache);
+    ClassDB::bind_method(D_METHOD("prefetch_slices", "paths", "index", "ahead", "behind"), &DicomViewer::prefetch_slices, DEFVAL(4), DEFVAL(2));
+    ClassDB::bind_method(D_METHOD("set_cache_budget_mb", "megabytes"), &DicomViewer::set_cache_budget_mb);
+    ClassDB::bind_method(D_METHOD("get_cache_budget_mb"), &DicomViewer::get_cache_budget_mb);
+    ClassDB::bind_method(D_METHOD("get_cache_stats"), &DicomViewer::get_cache_stats);
+    ClassDB::bind_method(D_METHOD("clear_cache"), &DicomViewer::clear_cache);
     ClassDB::bind_method(D_METHOD("set_window_level", "window", "level"), &DicomViewer::set_window_level);
     ClassDB::bind_method(D_METHOD("set_window", "window"), &DicomViewer::set_window);
     ClassDB::bind_method(D_METHOD("set_level", "level"), &DicomViewer::set_level);
@@ -52,7 +59,19 @@ void DicomViewer::_bind_methods() {
     ClassDB::bind_method(D_METHOD("zoom_in"), &DicomViewer::zoom_in);
     ClassDB::bind_method(D_METHOD("zoom_out"), &DicomViewer::zoom_out);
     ClassDB::bind_method(D_METHOD("reset_view"), &DicomViewer::reset_view);
+    ClassDB::bind_method(D_METHOD("set_zoom", "zoom"), &DicomViewer::set_zoom);
+    ClassDB::bind_method(D_METHOD("get_zoom"), &DicomViewer::get_zoom);
+    ClassDB::bind_method(D_METHOD("set_pan", "pan"), &DicomViewer::set_pan);
+    ClassDB::bind_method(D_METHOD("get_pan"), &DicomViewer::get_pan);
+    ClassDB::bind_method(D_METHOD("get_image_screen_rect"), &DicomViewer::get_image_screen_rect);
+    ClassDB::bind_method(D_METHOD("set_tiled_rendering", "enabled"), &DicomViewer::set_tiled_rendering);
+    ClassDB::bind_method(D_METHOD("is_tiled_rendering"), &DicomViewer::is_tiled_rendering);
+    ClassDB::bind_method(D_METHOD("set_viewport_windowing", "enabled"), &DicomViewer::set_viewport_windowing);
+    ClassDB::bind_method(D_METHOD("is_viewport_windowing"), &DicomViewer::is_viewport_windowing);
     ClassDB::bind_method(D_METHOD("get_metadata"), &DicomViewer::get_metadata);
+    ClassDB::bind_method(D_METHOD("get_tag", "group", "element"), &DicomViewer::get_tag);
+    ClassDB::bind_method(D_METHOD("has_tag", "group", "element"), &DicomViewer::has_tag);
+    ClassDB::bind_method(D_METHOD("get_all_tags"), &DicomViewer::get_all_tags);
     ClassDB::bind_method(D_METHOD("get_pixel_aspect_ratio"), &DicomViewer::get_pixel_aspect_ratio);
     ClassDB::bind_method(D_METHOD("get_modality"), &DicomViewer::get_modality);
     ClassDB::bind_method(D_METHOD("apply_modality_preset"), &DicomViewer::apply_modality_preset);
@@ -67,14 +86,41 @@ void DicomViewer::_bind_methods() {
     
     ClassDB::bind_method(D_METHOD("get_image_width"), &DicomViewer::get_image_width);
     ClassDB::bind_method(D_METHOD("get_image_height"), &DicomViewer::get_image_height);
+    ClassDB::bind_method(D_METHOD("get_load_timings"), &DicomViewer::get_load_timings);
+    ClassDB::bind_method(D_METHOD("get_render_stats"), &DicomViewer::get_render_stats);
+    ClassDB::bind_method(D_METHOD("get_pixel_memory_usage"), &DicomViewer::get_pixel_memory_usage);
+    ClassDB::bind_method(D_METHOD("get_windowing_mode"), &DicomViewer::get_windowing_mode);
+    ClassDB::bind_method(D_METHOD("get_simd_instruction_set"), &DicomViewer::get_simd_instruction_set);
+
+    ClassDB::bind_method(D_METHOD("set_windowing_threads", "threads"), &DicomViewer::set_windowing_threads);
+    ClassDB::bind_method(D_METHOD("get_windowing_threads"), &DicomViewer::get_windowing_threads);
+    ClassDB::bind_method(D_METHOD("set_parallel_windowing_threshold", "pixels"), &DicomViewer::set_parallel_windowing_threshold);
+    ClassDB::bind_method(D_METHOD("get_parallel_windowing_threshold"), &DicomViewer::get_parallel_windowing_threshold);
+
+    ADD_SIGNAL(MethodInfo("load_completed", PropertyInfo(Variant::STRING, "path"), PropertyInfo(Variant::BOOL, "ok")));
+    ADD_SIGNAL(MethodInfo("load_failed", PropertyInfo(Variant::STRING, "path"), PropertyInfo(Variant::STRING, "error")));
+    ADD_SIGNAL(MethodInfo("preview_ready", PropertyInfo(Variant::STRING, "path")));
+    ADD_SIGNAL(MethodInfo("frame_changed", PropertyInfo(Variant::INT, "index")));
 
     ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "window"), "set_window", "get_window");
     ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "level"), "set_level", "get_level");
     ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "pixel_aspect_ratio"), "", "get_pixel_aspect_ratio");
     ADD_PROPERTY(PropertyInfo(Variant::STRING, "modality"), "", "get_modality");
+    ADD_PROPERTY(PropertyInfo(Variant::INT, "windowing_threads", PROPERTY_HINT_RANGE, "0,64,1"), "set_windowing_threads", "get_windowing_threads");
+    ADD_PROPERTY(PropertyInfo(Variant::INT, "parallel_windowing_threshold", PROPERTY_HINT_RANGE, "0,67108864,1"), "set_parallel_windowing_threshold", "get_parallel_windowing_threshold");
+    ADD_PROPERTY(PropertyInfo(Variant::BOOL, "progressive_loading"), "set_progressive_loading", "is_progressive_loading");
+    ADD_PROPERTY(PropertyInfo(Variant::BOOL, "tiled_rendering"), "set_tiled_rendering", "is_tiled_rendering");
+    ADD_PROPERTY(PropertyInfo(Variant::BOOL, "viewport_windowing"), "set_viewport_windowing", "is_viewport_windowing");
+    ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "zoom"), "set_zoom", "get_zoom");
+    ADD_PROPERTY(PropertyInfo(Variant::VECTOR2, "pan"), "set_pan", "get_pan");
+    ADD_PROPERTY(PropertyInfo(Variant::INT, "progressive_threshold", PROPERTY_HINT_RANGE, "0,67108864,1"), "set_progressive_threshold", "get_progressive_threshold");
+    ADD_PROPERTY(PropertyInfo(Variant::INT, "preview_factor", PROPERTY_HINT_RANGE, "2,16,1"), "set_preview_factor", "get_preview_factor");
 }
 
 DicomViewer::DicomViewer() {
+    // Zoomed images overflow the control; clipping keeps what is drawn to
+    // the rect get_visible_pixel_rect() windows
+    set_clip_contents(true);
     texture_rect = memnew(TextureRect);
     add_child(texture_rect);
     texture_rect->set_anchors_preset(PRESET_FULL_RECT);
@@ -96,384 +142,1047 @@ DicomViewer::DicomViewer() {
     has_original_voi = false;
 
     raw_width = raw_height = 0;
+    source_width = source_height = 0;
+
+    windowing_threads = 0;
+    parallel_windowing_threshold = 1 << 20;
+
+    progressive_loading = true;
+    progressive_threshold = 1 << 22;
+    preview_factor = 4;
+
+    tiled_rendering = false;
+    tiles_active = false;
+    tile_version = 0;
+    draw_count = 0;
+
+    viewport_windowing = true;
+    window_blocks_x = 0;
+    window_blocks_y = 0;
+    window_version = 0;
+
+    async_state = std::make_shared<AsyncLoadState>();
+    prefetch_generation = std::make_shared<std::atomic<uint64_t>>(0);
 }
 
-bool DicomViewer::load_dicom(const String &path) {
+DicomViewer::~DicomViewer() {
+    // Orphan any in-flight decode; its result is dropped when it finishes
+    prefetch_generation->fetch_add(1);
+    std::lock_guard<std::mutex> lock(async_state->mutex);
+    async_state->generation++;
+    async_state->result.reset();
+}
 
-#ifdef USE_DCMTK
-    // Register decompression codecs first
-    register_dcmtk_codecs();
-    
+String DicomViewer::globalize_path(const String &path) {
     // Convert Godot's user:// path to absolute filesystem path
-    String absolute_path = path;
     if (path.begins_with("user://")) {
-        absolute_path = OS::get_singleton()->get_user_data_dir().path_join(path.substr(7));
+        return OS::get_singleton()->get_user_data_dir().path_join(path.substr(7));
     } else if (path.begins_with("res://")) {
-        absolute_path = ProjectSettings::get_singleton()->globalize_path(path);
+        return ProjectSettings::get_singleton()->globalize_path(path);
     }
-    
+    return path;
+}
+
+std::shared_ptr<dicom::DecodedSlice> DicomViewer::decode_slice(const String &path, const String &absolute_path, String &error) {
+    // Compressed files transcoded on import are mapped, not decoded again
+    std::shared_ptr<dicom::DecodedSlice> slice = TranscodeCache::load(absolute_path);
+    if (slice) {
+        return slice;
+    }
+    slice = std::make_shared<dicom::DecodedSlice>();
+
+    std::string decode_error;
+#ifdef USE_DCMTK
+    if (!dicom::decode_dicom_file(absolute_path.utf8().get_data(), *slice, decode_error)) {
+        error = String::utf8(decode_error.c_str());
+        return nullptr;
+    }
+#else
+    // The built-in reader covers uncompressed and RLE DICOM; files it cannot
+    // decode keep its error, and only non-DICOM files go on to the fallback
+    dicom::DecodeFailure failure;
+    if (dicom::decode_dicom_file(absolute_path.utf8().get_data(), *slice, decode_error, &failure)) {
+        return slice;
+    }
+    if (failure != dicom::DECODE_NOT_DICOM) {
+        error = String::utf8(decode_error.c_str());
+        return nullptr;
+    }
+    *slice = dicom::DecodedSlice();
+
+    // Fallback: try to load as a regular image via Image::load_from_file
+    uint64_t stage_start = dicom::get_ticks_usec();
+    Ref<Image> tmp = Image::load_from_file(path);
+    if (tmp.is_null()) {
+        error = "Neither a DICOM file nor a readable image";
+        return nullptr;
+    }
+    slice->timings.decode_usec = dicom::get_ticks_usec() - stage_start;
+    stage_start = dicom::get_ticks_usec();
+
+    if (tmp->get_format() != Image::FORMAT_L8) {
+        tmp->convert(Image::FORMAT_L8);
+    }
+
+    PackedByteArray data = tmp->get_data();
+    int w = tmp->get_width();
+    int h = tmp->get_height();
+
+    slice->path = absolute_path.utf8().get_data();
+    slice->pixels.assign(data.ptr(), w, h);
+    slice->info.rows = h;
+    slice->info.columns = w;
+    slice->info.voi_center = 127.5;
+    slice->info.voi_width = 255.0;
+    slice->info.has_voi = true;
+    slice->timings.convert_usec = dicom::get_ticks_usec() - stage_start;
+#endif
+
+    return slice;
+}
+
+uint64_t DicomViewer::supersede_async_loads() {
+    // Running jobs still decrement `pending` when they finish, so it is left
+    // alone; their results are dropped by the generation check
+    std::lock_guard<std::mutex> lock(async_state->mutex);
+    async_state->has_result = false;
+    async_state->result.reset();
+    async_state->prepared_image.unref();
+    async_state->pyramid.reset();
+    async_state->frame = -1;
+    async_state->has_preview = false;
+    async_state->preview.reset();
+    async_state->preview_shown = false;
+    return ++async_state->generation;
+}
+
+bool DicomViewer::load_dicom(const String &path) {
+    const uint64_t load_start = Time::get_singleton()->get_ticks_usec();
+
+    // A synchronous load supersedes any async request still in flight
+    supersede_async_loads();
+
     #ifdef DEBUG_DICOM_LOADING
     UtilityFunctions::print("Loading DICOM from virtual path: ", path);
-    UtilityFunctions::print("Resolved to absolute path: ", absolute_path);
+    UtilityFunctions::print("Resolved to absolute path: ", globalize_path(path));
     #endif
-    
-    // Load file and dataset
-    DcmFileFormat file;
-    OFCondition loadStatus = file.loadFile(absolute_path.utf8().get_data());
-    if (!loadStatus.good()) {
+
+    String error;
+    std::shared_ptr<const dicom::DecodedSlice> decoded = get_file_slice(path, error);
+    if (!decoded) {
         UtilityFunctions::push_error("Failed to load DICOM: ", path);
-        UtilityFunctions::push_error("DCMTK Error loading file: ", loadStatus.text());
+        UtilityFunctions::push_error(error);
         return false;
     }
-    DcmDataset *ds = file.getDataset();
-    if (!ds) {
-        UtilityFunctions::printerr("DCMTK Error: No dataset found");
+
+    display_slice(decoded);
+    load_timings.total_usec = Time::get_singleton()->get_ticks_usec() - load_start;
+    return true;
+}
+
+int DicomViewer::load_dicom_async(const String &path) {
+    const String absolute_path = globalize_path(path);
+    const uint64_t request_start = Time::get_singleton()->get_ticks_usec();
+
+    const std::string cache_key = dicom::SliceCache::make_key(absolute_path.utf8().get_data());
+
+    const uint64_t generation = supersede_async_loads();
+
+    // Warm slices (e.g. prefetched neighbours) are shown right away; the
+    // signal is emitted before this call returns. Tiled ones still go to the
+    // worker, which builds their pyramid.
+    std::shared_ptr<const dicom::DecodedSlice> cached = dicom::SliceCache::get_singleton()->get(cache_key);
+    if (cached && !(tiled_rendering && needs_tiles(*cached))) {
+        display_slice(cached);
+        load_timings.total_usec = Time::get_singleton()->get_ticks_usec() - request_start;
+        emit_signal("load_completed", path, true);
+        return (int)generation;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(async_state->mutex);
+        async_state->pending++;
+    }
+    set_process(true);
+
+    // Settings are copied so the job never reads the viewer
+    const size_t progressive_pixels = progressive_loading && preview_factor > 1 ? (size_t)progressive_threshold : SIZE_MAX;
+    const int factor = preview_factor;
+    const bool tiled = tiled_rendering;
+
+    // The job only touches the shared state, never the viewer, so it is safe
+    // for the viewer to be freed while a decode is running
+    std::shared_ptr<AsyncLoadState> state = async_state;
+    dicom::ThreadPool::get_singleton()->submit([state, generation, path, absolute_path, cache_key, request_start, progressive_pixels, factor, tiled]() {
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (state->generation != generation) {
+                // Superseded before it started; skip the decode entirely
+                state->pending--;
+                return;
+            }
+        }
+
+        // A prefetch may have finished this file while the job was queued
+        std::shared_ptr<const dicom::DecodedSlice> decoded = dicom::SliceCache::get_singleton()->get(cache_key);
+        String error;
+        if (!decoded) {
+            std::shared_ptr<dicom::DecodedSlice> fresh = decode_slice(path, absolute_path, error);
+            if (fresh) {
+                dicom::SliceCache::get_singleton()->put(cache_key, fresh);
+            }
+            decoded = fresh;
+        }
+
+        // Large images: hand a preview to the main thread straight away, then
+        // window the full image here so the main thread only uploads it.
+        // Images drawn tiled get their pyramid built here instead.
+        Ref<Image> prepared;
+        std::shared_ptr<dicom::TilePyramid> pyramid;
+        const bool tiled_result = decoded && tiled && needs_tiles(*decoded);
+        if (decoded && decoded->pixels.get_pixel_count() >= progressive_pixels) {
+            std::shared_ptr<dicom::DecodedSlice> preview = make_preview(*decoded, factor, false);
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                if (state->generation != generation) {
+                    state->pending--;
+                    return;
+                }
+                state->has_preview = true;
+                state->preview = preview;
+                state->result_path = path;
+            }
+            if (!tiled_result) {
+                float center, width;
+                get_default_window(*decoded, center, width);
+                prepared = window_to_image(decoded->pixels, center, width);
+            }
+        }
+        if (tiled_result) {
+            pyramid = std::make_shared<dicom::TilePyramid>();
+            pyramid->build(decoded);
+        }
+
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->pending--;
+        if (state->generation != generation) {
+            return;
+        }
+        state->has_result = true;
+        state->result = decoded;
+        state->prepared_image = prepared;
+        state->pyramid = pyramid;
+        state->result_path = path;
+        state->result_error = error;
+        state->request_start = request_start;
+    });
+
+    return (int)generation;
+}
+
+std::string DicomViewer::get_frame_cache_key(const std::string &path, int index) {
+    const std::string key = dicom::SliceCache::make_key(path);
+    return index == 0 ? key : key + "#frame" + std::to_string(index);
+}
+
+std::shared_ptr<const dicom::DecodedSlice> DicomViewer::get_file_slice(const String &path, String &error) {
+    const String absolute_path = globalize_path(path);
+    const std::string cache_key = dicom::SliceCache::make_key(absolute_path.utf8().get_data());
+    std::shared_ptr<const dicom::DecodedSlice> decoded = dicom::SliceCache::get_singleton()->get(cache_key);
+    if (decoded) {
+        return decoded;
+    }
+    std::shared_ptr<dicom::DecodedSlice> fresh = decode_slice(path, absolute_path, error);
+    if (fresh) {
+        dicom::SliceCache::get_singleton()->put(cache_key, fresh);
+    }
+    return fresh;
+}
+
+std::shared_ptr<const dicom::DecodedSlice> DicomViewer::get_frame_slice(const std::shared_ptr<const dicom::FrameSource> &frames,
+        int index, String &error) {
+    const std::string cache_key = get_frame_cache_key(frames->get_path(), index);
+    std::shared_ptr<const dicom::DecodedSlice> decoded = dicom::SliceCache::get_singleton()->get(cache_key);
+    if (decoded) {
+        return decoded;
+    }
+    std::shared_ptr<dicom::DecodedSlice> fresh = std::make_shared<dicom::DecodedSlice>();
+    std::string decode_error;
+    if (!frames->decode_frame(index, *fresh, decode_error)) {
+        error = String::utf8(decode_error.c_str());
+        return nullptr;
+    }
+    dicom::SliceCache::get_singleton()->put(cache_key, fresh);
+    return fresh;
+}
+
+int DicomViewer::get_frame_count() const {
+    if (!slice) {
+        return 0;
+    }
+    return slice->frames ? slice->frames->get_frame_count() : 1;
+}
+
+bool DicomViewer::set_frame(int index) {
+    const int frame_count = get_frame_count();
+    if (index < 0 || index >= frame_count) {
+        UtilityFunctions::push_error("DicomViewer: frame index ", index, " out of range (0-", frame_count - 1, ")");
         return false;
     }
+    const uint64_t request_start = Time::get_singleton()->get_ticks_usec();
 
-    // Read modality for auto-preset selection
-    OFString modality;
-    if (ds->findAndGetOFString(DCM_Modality, modality).good()) {
-        current_modality = String(modality.c_str());
-        #ifdef DEBUG_DICOM_LOADING
-        UtilityFunctions::print("Modality detected: ", current_modality);
-        #endif
-    } else {
-        current_modality = "";
+    // Like a load, this supersedes any async request in flight, including
+    // one for another frame
+    const uint64_t generation = supersede_async_loads();
+    if (index == slice->frame_index) {
+        return true;
     }
 
-    #ifdef DEBUG_DICOM_LOADING
-    // Print some diagnostic info about the image
-    OFString transferSyntax;
-    if (ds->findAndGetOFString(DCM_TransferSyntaxUID, transferSyntax).good()) {
-        UtilityFunctions::print("Transfer Syntax: ", transferSyntax.c_str());
-    } else {
-        UtilityFunctions::print("Transfer Syntax: Not found (assuming Implicit VR Little Endian)");
+    // Keep the source alive: display_slice() replaces `slice`
+    const std::shared_ptr<const dicom::FrameSource> frames = slice->frames;
+    std::shared_ptr<const dicom::DecodedSlice> cached =
+            dicom::SliceCache::get_singleton()->get(get_frame_cache_key(frames->get_path(), index));
+    if (cached && !(tiled_rendering && needs_tiles(*cached))) {
+        display_slice(cached, true);
+        load_timings.total_usec = Time::get_singleton()->get_ticks_usec() - request_start;
+        emit_signal("frame_changed", index);
+        return true;
     }
-    
-    OFString photometricInterpretation;
-    if (ds->findAndGetOFString(DCM_PhotometricInterpretation, photometricInterpretation).good()) {
-        UtilityFunctions::print("Photometric Interpretation: ", photometricInterpretation.c_str());
+
+    {
+        std::lock_guard<std::mutex> lock(async_state->mutex);
+        async_state->pending++;
     }
-    #endif
+    set_process(true);
+
+    const String path = String::utf8(frames->get_path().c_str());
+    const bool tiled = tiled_rendering;
+    std::shared_ptr<AsyncLoadState> state = async_state;
+    dicom::ThreadPool::get_singleton()->submit([state, generation, frames, index, path, request_start, tiled]() {
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (state->generation != generation) {
+                state->pending--;
+                return;
+            }
+        }
+
+        String error;
+        std::shared_ptr<const dicom::DecodedSlice> decoded = get_frame_slice(frames, index, error);
+        if (!decoded) {
+            error = "Failed to decode frame " + String::num_int64(index) + ": " + error;
+        }
+        std::shared_ptr<dicom::TilePyramid> pyramid;
+        if (decoded && tiled && needs_tiles(*decoded)) {
+            pyramid = std::make_shared<dicom::TilePyramid>();
+            pyramid->build(decoded);
+        }
+
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->pending--;
+        if (state->generation != generation) {
+            return;
+        }
+        state->has_result = true;
+        state->result = decoded;
+        state->pyramid = pyramid;
+        state->frame = index;
+        state->result_path = path;
+        state->result_error = error;
+        state->request_start = request_start;
+    });
+    return true;
+}
+
+void DicomViewer::show_slice(const std::shared_ptr<const dicom::DecodedSlice> &p_slice, bool keep_window) {
+    if (!p_slice) {
+        return;
+    }
+    supersede_async_loads();
+    display_slice(p_slice, keep_window && slice);
+}
+
+bool DicomViewer::show_volume_slice(const Ref<DicomVolume> &volume, int index) {
+    return show_volume_plane(volume, DicomVolume::AXIS_AXIAL, index);
+}
+
+bool DicomViewer::show_volume_plane(const Ref<DicomVolume> &volume, DicomVolume::Axis axis, int index) {
+    return show_volume_slab(volume, axis, index, 0.0f, DicomVolume::PROJECTION_MAX);
+}
 
-    // Read image dimensions
-    Uint16 rows = 0, cols = 0;
-    if (!ds->findAndGetUint16(DCM_Rows, rows).good() || !ds->findAndGetUint16(DCM_Columns, cols).good()) {
-        UtilityFunctions::printerr("DCMTK Error: Missing image dimensions (Rows/Columns)");
+bool DicomViewer::show_volume_slab(const Ref<DicomVolume> &volume, DicomVolume::Axis axis, int index, float thickness_mm, DicomVolume::Projection mode) {
+    if (volume.is_null() || !volume->is_loaded()) {
+        UtilityFunctions::push_error("DicomViewer: no volume loaded");
         return false;
     }
-    
-    if (rows == 0 || cols == 0) {
-        UtilityFunctions::printerr("DCMTK Error: Invalid dimensions: ", cols, "x", rows);
+    const uint64_t load_start = Time::get_singleton()->get_ticks_usec();
+    std::shared_ptr<const dicom::Volume> data = volume->get_volume();
+    const int plane_count = volume->get_plane_count(axis);
+    if (index < 0 || index >= plane_count) {
+        UtilityFunctions::push_error("DicomViewer: plane index ", index, " out of range (0-", plane_count - 1, ")");
+        return false;
+    }
+    if (mode != DicomVolume::PROJECTION_MAX && mode != DicomVolume::PROJECTION_MIN && mode != DicomVolume::PROJECTION_AVERAGE) {
+        UtilityFunctions::push_error("DicomViewer: unknown projection mode ", (int)mode);
         return false;
     }
 
-    #ifdef DEBUG_DICOM_LOADING
-    UtilityFunctions::print("Image dimensions: ", cols, "x", rows);
-    #endif
+    // Like load_dicom(), this supersedes any async request in flight
+    supersede_async_loads();
 
-    // Read pixel spacing to maintain proper aspect ratio
-    double pixel_spacing_row = 1.0;
-    double pixel_spacing_col = 1.0;
-    bool have_pixel_spacing = false;
-    
-    // Try Pixel Spacing first (most common - for cross-sectional imaging)
-    if (ds->findAndGetFloat64(DCM_PixelSpacing, pixel_spacing_row, 0).good() &&
-        ds->findAndGetFloat64(DCM_PixelSpacing, pixel_spacing_col, 1).good()) {
-        have_pixel_spacing = true;
-        #ifdef DEBUG_DICOM_LOADING
-        UtilityFunctions::print("Pixel Spacing: ", pixel_spacing_row, " x ", pixel_spacing_col, " mm");
-        #endif
-    }
-    // Try Imager Pixel Spacing as fallback (for projection radiography)
-    else if (ds->findAndGetFloat64(DCM_ImagerPixelSpacing, pixel_spacing_row, 0).good() &&
-             ds->findAndGetFloat64(DCM_ImagerPixelSpacing, pixel_spacing_col, 1).good()) {
-        have_pixel_spacing = true;
-        #ifdef DEBUG_DICOM_LOADING
-        UtilityFunctions::print("Imager Pixel Spacing: ", pixel_spacing_row, " x ", pixel_spacing_col, " mm");
-        #endif
+    // Slab thickness in planes along the projection axis
+    double plane_spacing = data->spacing[2];
+    if (axis == DicomVolume::AXIS_CORONAL) {
+        plane_spacing = data->spacing[1];
+    } else if (axis == DicomVolume::AXIS_SAGITTAL) {
+        plane_spacing = data->spacing[0];
     }
-    
-    // Calculate aspect ratio correction factor
-    if (have_pixel_spacing && pixel_spacing_col > 0.0) {
-        pixel_aspect_ratio = static_cast<float>(pixel_spacing_row / pixel_spacing_col);
-        #ifdef DEBUG_DICOM_LOADING
-        UtilityFunctions::print("Calculated Pixel Aspect Ratio: ", pixel_aspect_ratio);
-        #endif
-    } else {
-        pixel_aspect_ratio = 1.0f;
-        #ifdef DEBUG_DICOM_LOADING
-        UtilityFunctions::print("No pixel spacing found, assuming square pixels (1:1)");
-        #endif
+    const int thickness = plane_spacing > 0.0 ? (int)(thickness_mm / plane_spacing + 0.5) : 1;
+
+    std::shared_ptr<dicom::DecodedSlice> plane = std::make_shared<dicom::DecodedSlice>();
+    const uint64_t stage_start = dicom::get_ticks_usec();
+    const bool built = thickness > 1 ?
+            dicom::project_slab(*data, (dicom::VolumeAxis)axis, index, thickness, (dicom::ProjectionMode)mode, *plane) :
+            dicom::extract_plane(*data, (dicom::VolumeAxis)axis, index, *plane);
+    if (!built) {
+        UtilityFunctions::push_error("DicomViewer: could not build plane ", index);
+        return false;
     }
+    plane->timings.convert_usec = dicom::get_ticks_usec() - stage_start;
 
-    // Read some metadata values
-    OFString ofstr;
-    double rescale_slope = 1.0;
-    double rescale_intercept = 0.0;
-    Uint16 pixel_representation = 0;
-    Uint16 bits_allocated = 16;
-    Uint16 bits_stored = 12;
-    Uint16 high_bit = 15;
-    double voi_center = 0.0;
-    double voi_width = 0.0;
-    bool have_voi = false;
-
-    ds->findAndGetUint16(DCM_BitsAllocated, bits_allocated);
-    ds->findAndGetUint16(DCM_BitsStored, bits_stored);
-    ds->findAndGetUint16(DCM_HighBit, high_bit);
-    ds->findAndGetUint16(DCM_PixelRepresentation, pixel_representation);
-
-    if (ds->findAndGetOFString(DCM_RescaleSlope, ofstr).good()) {
-        rescale_slope = atof(ofstr.c_str());
-        #ifdef DEBUG_DICOM_LOADING
-        UtilityFunctions::print("Rescale Slope: ", rescale_slope);
-        #endif
+    const bool same_volume = volume_on_display == data;
+    display_slice(plane, same_volume);
+    volume_on_display = data;
+    load_timings.total_usec = Time::get_singleton()->get_ticks_usec() - load_start;
+    return true;
+}
+
+void DicomViewer::prefetch_slices(const Array &paths, int index, int ahead, int behind) {
+    // A new call retires queued jobs from the previous window; they stop
+    // before decoding, and overlapping slices are simply queued again
+    const uint64_t generation = ++(*prefetch_generation);
+    std::shared_ptr<std::atomic<uint64_t>> current_generation = prefetch_generation;
+    dicom::SliceCache *cache = dicom::SliceCache::get_singleton();
+    dicom::ThreadPool *pool = dicom::ThreadPool::get_singleton();
+    // Without workers submit() runs jobs inline, which would decode every
+    // neighbour on the calling thread
+    if (pool->get_thread_count() == 0) {
+        return;
     }
-    if (ds->findAndGetOFString(DCM_RescaleIntercept, ofstr).good()) {
-        rescale_intercept = atof(ofstr.c_str());
-        #ifdef DEBUG_DICOM_LOADING
-        UtilityFunctions::print("Rescale Intercept: ", rescale_intercept);
-        #endif
+
+    auto queue_slice = [&](int i) {
+        if (i < 0 || i >= paths.size()) {
+            return;
+        }
+        const String path = paths[i];
+        const String absolute_path = globalize_path(path);
+        const std::string cache_key = dicom::SliceCache::make_key(absolute_path.utf8().get_data());
+        if (cache->contains(cache_key)) {
+            return;
+        }
+        pool->submit([current_generation, generation, path, absolute_path, cache_key]() {
+            if (current_generation->load() != generation) {
+                return;
+            }
+            dicom::SliceCache *slice_cache = dicom::SliceCache::get_singleton();
+            if (!slice_cache->begin_decode(cache_key)) {
+                return;
+            }
+            String error;
+            std::shared_ptr<dicom::DecodedSlice> decoded = decode_slice(path, absolute_path, error);
+            if (decoded) {
+                slice_cache->put(cache_key, decoded);
+            }
+            slice_cache->end_decode(cache_key);
+        });
+    };
+
+    // Nearest slices first, alternating forward and backward
+    const int reach = ahead > behind ? ahead : behind;
+    for (int distance = 1; distance <= reach; ++distance) {
+        if (distance <= ahead) {
+            queue_slice(index + distance);
+        }
+        if (distance <= behind) {
+            queue_slice(index - distance);
+        }
     }
-    
-    // WindowCenter and WindowWidth can have multiple values (multiple presets)
-    // We'll take the first value
-    if (ds->findAndGetOFString(DCM_WindowCenter, ofstr, 0).good()) {
-        voi_center = atof(ofstr.c_str());
-        have_voi = true;
-        #ifdef DEBUG_DICOM_LOADING
-        UtilityFunctions::print("Window Center (VOI): ", voi_center);
-        #endif
+}
+
+void DicomViewer::set_progressive_threshold(int pixels_threshold) {
+    progressive_threshold = pixels_threshold > 0 ? pixels_threshold : 0;
+}
+
+void DicomViewer::set_preview_factor(int factor) {
+    preview_factor = factor > 1 ? factor : 1;
+}
+
+Ref<Image> DicomViewer::make_thumbnail(const String &path, int max_size, bool use_slice_cache, String &error) {
+    const String absolute_path = globalize_path(path);
+    Ref<Image> thumbnail = ThumbnailCache::load(absolute_path, max_size);
+    if (thumbnail.is_valid()) {
+        return thumbnail;
     }
-    if (ds->findAndGetOFString(DCM_WindowWidth, ofstr, 0).good()) {
-        voi_width = atof(ofstr.c_str());
-        #ifdef DEBUG_DICOM_LOADING
-        UtilityFunctions::print("Window Width (VOI): ", voi_width);
-        #endif
+
+    const std::string cache_key = dicom::SliceCache::make_key(absolute_path.utf8().get_data());
+    std::shared_ptr<const dicom::DecodedSlice> decoded = dicom::SliceCache::get_singleton()->get(cache_key);
+    if (!decoded) {
+        std::shared_ptr<dicom::DecodedSlice> fresh = decode_slice(path, absolute_path, error);
+        if (!fresh) {
+            return Ref<Image>();
+        }
+        if (use_slice_cache) {
+            dicom::SliceCache::get_singleton()->put(cache_key, fresh);
+        }
+        decoded = fresh;
     }
 
-    #ifdef DEBUG_DICOM_LOADING
-    UtilityFunctions::print("Bits Allocated/Stored: ", bits_allocated, "/", bits_stored, 
-                           ", Pixel Representation: ", pixel_representation);
-    #endif
+    // Downsample the native pixels first so only the small image is windowed
+    const int factor = dicom::get_downsample_factor(decoded->pixels.get_width(), decoded->pixels.get_height(), max_size);
+    std::shared_ptr<const dicom::DecodedSlice> small = factor > 1 ? make_preview(*decoded, factor, true) : decoded;
+    float center, width;
+    get_default_window(*small, center, width);
+    thumbnail = window_to_image(small->pixels, center, width);
+    ThumbnailCache::store(absolute_path, max_size, thumbnail);
+    return thumbnail;
+}
 
-    // Use DicomImage - with codecs registered, it should handle decompression
-    DicomImage dcm_image(absolute_path.utf8().get_data());
-    
-    EI_Status status = dcm_image.getStatus();
-    if (status != EIS_Normal) {
-        UtilityFunctions::push_error("Failed to load DICOM: ", path);
-        UtilityFunctions::push_error("DCMTK DicomImage Error (status ", (int)status, "): ", 
-                                  DicomImage::getString(status));
-        return false;
+Ref<Image> DicomViewer::create_thumbnail(const String &path, int max_size) {
+    ThumbnailCache::ensure_directory();
+    String error;
+    Ref<Image> thumbnail = make_thumbnail(path, max_size, true, error);
+    if (thumbnail.is_null()) {
+        UtilityFunctions::push_error("Failed to create thumbnail: ", path);
+        UtilityFunctions::push_error(error);
     }
-    
-    const int w = dcm_image.getWidth();
-    const int h = dcm_image.getHeight();
-    
-    #ifdef DEBUG_DICOM_LOADING
-    UtilityFunctions::print("Successfully loaded DICOM image via DicomImage: ", w, "x", h);
-    #endif
+    return thumbnail;
+}
 
-    // Get min/max values from DicomImage (these are already rescaled)
-    double minValue = 0.0;
-    double maxValue = 0.0;
-    if (dcm_image.getMinMaxValues(minValue, maxValue) > 0) {
-        #ifdef DEBUG_DICOM_LOADING
-        UtilityFunctions::print("DicomImage reports min/max: ", minValue, " to ", maxValue);
-        #endif
+Array DicomViewer::create_thumbnails(const Array &paths, int max_size) {
+    ThumbnailCache::ensure_directory();
+    const size_t count = (size_t)paths.size();
+    std::vector<String> files(count);
+    for (size_t i = 0; i < count; ++i) {
+        files[i] = paths[(int64_t)i];
     }
 
-    raw_pixels.assign((size_t)w * (size_t)h, 0.0);
-    raw_width = w;
-    raw_height = h;
+    // One file per job; a library scan would only churn the slice cache, so
+    // fresh decodes are not kept there
+    std::vector<Ref<Image>> thumbnails(count);
+    std::vector<String> errors(count);
+    dicom::ThreadPool::get_singleton()->parallel_for(count, 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            thumbnails[i] = make_thumbnail(files[i], max_size, false, errors[i]);
+        }
+    });
 
-    // Get internal pixel data which has modality LUT applied (rescale slope/intercept)
-    const DiPixel* pixelData = dcm_image.getInterData();
-    if (!pixelData) {
-        UtilityFunctions::printerr("DCMTK Error: Failed to get internal pixel data");
-        return false;
+    Array result;
+    result.resize((int64_t)count);
+    for (size_t i = 0; i < count; ++i) {
+        if (thumbnails[i].is_valid()) {
+            result[(int64_t)i] = thumbnails[i];
+        } else {
+            UtilityFunctions::push_error("Failed to create thumbnail: ", files[i]);
+            UtilityFunctions::push_error(errors[i]);
+        }
     }
+    return result;
+}
 
-    // Get the representation (might be different from original)
-    EP_Representation pixelRep = pixelData->getRepresentation();
-    const void* dataPtr = pixelData->getData();
-    
-    if (!dataPtr) {
-        UtilityFunctions::printerr("DCMTK Error: Internal pixel data pointer is null");
-        return false;
+void DicomViewer::clear_thumbnail_cache() {
+    ThumbnailCache::clear();
+}
+
+int DicomViewer::transcode_files(const Array &paths) {
+    TranscodeCache::ensure_directory();
+    const size_t count = (size_t)paths.size();
+    std::vector<String> files(count);
+    for (size_t i = 0; i < count; ++i) {
+        files[i] = paths[(int64_t)i];
     }
 
-    double computed_min = 0.0, computed_max = 0.0;
-    bool first = true;
-
-    // Read based on actual internal representation
-    if (pixelRep == EPR_Sint16) {
-        const Sint16* pixels = static_cast<const Sint16*>(dataPtr);
-        for (int i = 0; i < w * h; ++i) {
-            double val = static_cast<double>(pixels[i]);
-            raw_pixels[i] = val;
-            
-            if (first) {
-                computed_min = computed_max = val;
-                first = false;
-            } else {
-                if (val < computed_min) computed_min = val;
-                if (val > computed_max) computed_max = val;
+    // One file per job. Files already transcoded are skipped without
+    // parsing them, uncompressed or non-DICOM ones after a header read;
+    // decodes bypass the slice cache.
+    std::vector<uint8_t> cached(count, 0);
+    std::vector<String> errors(count);
+    dicom::ThreadPool::get_singleton()->parallel_for(count, 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const String absolute_path = globalize_path(files[i]);
+            if (TranscodeCache::has(absolute_path)) {
+                cached[i] = 1;
+                continue;
             }
-        }
-    } else if (pixelRep == EPR_Uint16) {
-        const Uint16* pixels = static_cast<const Uint16*>(dataPtr);
-        for (int i = 0; i < w * h; ++i) {
-            double val = static_cast<double>(pixels[i]);
-            raw_pixels[i] = val;
-            
-            if (first) {
-                computed_min = computed_max = val;
-                first = false;
-            } else {
-                if (val < computed_min) computed_min = val;
-                if (val > computed_max) computed_max = val;
+            dicom::SliceInfo info;
+            std::string header_error;
+            if (!dicom::read_dicom_header(absolute_path.utf8().get_data(), info, header_error) || !TranscodeCache::is_cacheable(info)) {
+                continue;
             }
+            std::shared_ptr<dicom::DecodedSlice> decoded = decode_slice(files[i], absolute_path, errors[i]);
+            cached[i] = decoded && TranscodeCache::store(*decoded, errors[i]);
         }
-    } else if (pixelRep == EPR_Sint32) {
-        const Sint32* pixels = static_cast<const Sint32*>(dataPtr);
-        for (int i = 0; i < w * h; ++i) {
-            double val = static_cast<double>(pixels[i]);
-            raw_pixels[i] = val;
-            
-            if (first) {
-                computed_min = computed_max = val;
-                first = false;
-            } else {
-                if (val < computed_min) computed_min = val;
-                if (val > computed_max) computed_max = val;
-            }
+    });
+
+    int transcoded = 0;
+    for (size_t i = 0; i < count; ++i) {
+        transcoded += cached[i];
+        if (!errors[i].is_empty()) {
+            UtilityFunctions::push_error("Failed to transcode: ", files[i]);
+            UtilityFunctions::push_error(errors[i]);
         }
-    } else if (pixelRep == EPR_Uint32) {
-        const Uint32* pixels = static_cast<const Uint32*>(dataPtr);
-        for (int i = 0; i < w * h; ++i) {
-            double val = static_cast<double>(pixels[i]);
-            raw_pixels[i] = val;
-            
-            if (first) {
-                computed_min = computed_max = val;
-                first = false;
-            } else {
-                if (val < computed_min) computed_min = val;
-                if (val > computed_max) computed_max = val;
+    }
+    return transcoded;
+}
+
+void DicomViewer::clear_transcode_cache() {
+    TranscodeCache::clear();
+}
+
+void DicomViewer::set_cache_budget_mb(int megabytes) {
+    dicom::SliceCache::get_singleton()->set_budget(size_t(megabytes > 0 ? megabytes : 0) * 1024 * 1024);
+}
+
+int DicomViewer::get_cache_budget_mb() const {
+    return (int)(dicom::SliceCache::get_singleton()->get_budget() / (1024 * 1024));
+}
+
+Dictionary DicomViewer::get_cache_stats() const {
+    const dicom::SliceCache::Stats cache_stats = dicom::SliceCache::get_singleton()->get_stats();
+    Dictionary stats;
+    stats["hits"] = (int64_t)cache_stats.hits;
+    stats["misses"] = (int64_t)cache_stats.misses;
+    stats["evictions"] = (int64_t)cache_stats.evictions;
+    stats["bytes"] = (int64_t)cache_stats.bytes;
+    stats["entries"] = (int64_t)cache_stats.entries;
+    return stats;
+}
+
+void DicomViewer::clear_cache() {
+    dicom::SliceCache::get_singleton()->clear();
+}
+
+bool DicomViewer::is_loading() const {
+    std::lock_guard<std::mutex> lock(async_state->mutex);
+    return async_state->pending > 0 || async_state->has_result || async_state->has_preview;
+}
+
+void DicomViewer::_process(double p_delta) {
+    std::shared_ptr<const dicom::DecodedSlice> decoded;
+    std::shared_ptr<const dicom::DecodedSlice> preview;
+    Ref<Image> prepared;
+    std::shared_ptr<const dicom::TilePyramid> pyramid;
+    bool keep_window = false;
+    int frame = -1;
+    String result_path;
+    String result_error;
+    uint64_t request_start = 0;
+    {
+        std::lock_guard<std::mutex> lock(async_state->mutex);
+        if (async_state->has_result) {
+            decoded = std::move(async_state->result);
+            prepared = async_state->prepared_image;
+            pyramid = std::move(async_state->pyramid);
+            frame = async_state->frame;
+            keep_window = async_state->preview_shown || frame >= 0;
+            async_state->frame = -1;
+            async_state->prepared_image.unref();
+            async_state->has_result = false;
+            // A preview that has not been shown yet is no longer needed
+            async_state->has_preview = false;
+            async_state->preview.reset();
+            async_state->preview_shown = false;
+        } else if (async_state->has_preview) {
+            preview = std::move(async_state->preview);
+            async_state->has_preview = false;
+            async_state->preview_shown = true;
+        } else {
+            if (async_state->pending == 0) {
+                set_process(false);
             }
+            return;
+        }
+        result_path = async_state->result_path;
+        result_error = async_state->result_error;
+        request_start = async_state->request_start;
+    }
+
+    if (preview) {
+        display_slice(preview);
+        emit_signal("preview_ready", result_path);
+        return;
+    }
+
+    // Texture work happens here, on the main thread
+    if (!decoded) {
+        UtilityFunctions::push_error("Failed to load DICOM: ", result_path);
+        UtilityFunctions::push_error(result_error);
+        emit_signal("load_failed", result_path, result_error);
+        if (frame < 0) {
+            emit_signal("load_completed", result_path, false);
         }
+        return;
+    }
+
+    // Keep the window the preview or the previous frame was shown with (the
+    // user may have changed it meanwhile); the prepared image is only used
+    // if it still matches
+    display_slice(decoded, keep_window, prepared, pyramid);
+    load_timings.total_usec = Time::get_singleton()->get_ticks_usec() - request_start;
+    if (frame >= 0) {
+        emit_signal("frame_changed", frame);
     } else {
-        UtilityFunctions::printerr("DCMTK Error: Unsupported pixel representation: ", (int)pixelRep);
-        return false;
+        emit_signal("load_completed", result_path, true);
     }
+}
+
+bool DicomViewer::needs_tiles(const dicom::DecodedSlice &p_slice) {
+    const int tile_size = dicom::TilePyramid::TILE_SIZE;
+    return p_slice.pixels.get_width() > tile_size || p_slice.pixels.get_height() > tile_size;
+}
+
+void DicomViewer::display_slice(const std::shared_ptr<const dicom::DecodedSlice> &p_slice, bool keep_window, const Ref<Image> &prepared,
+        const std::shared_ptr<const dicom::TilePyramid> &pyramid) {
+    Time *time = Time::get_singleton();
+    slice = p_slice;
+    volume_on_display.reset();
+    const dicom::SliceInfo &info = slice->info;
+
+    load_timings = LoadTimings();
+    load_timings.parse_usec = slice->timings.parse_usec;
+    load_timings.decode_usec = slice->timings.decode_usec;
+    load_timings.convert_usec = slice->timings.convert_usec;
+
+    current_modality = String::utf8(info.modality.c_str());
+    pixel_aspect_ratio = info.pixel_aspect_ratio;
+    raw_width = slice->pixels.get_width();
+    raw_height = slice->pixels.get_height();
+    source_width = info.columns > 0 ? info.columns : raw_width;
+    source_height = info.rows > 0 ? info.rows : raw_height;
 
     #ifdef DEBUG_DICOM_LOADING
+    // Modality value range (slope/intercept applied)
+    const double computed_min = slice->pixels.get_min_value();
+    const double computed_max = slice->pixels.get_max_value();
+    UtilityFunctions::print("Modality detected: ", current_modality);
+    UtilityFunctions::print("Transfer Syntax: ", info.transfer_syntax.c_str());
+    UtilityFunctions::print("Photometric Interpretation: ", info.photometric_interpretation.c_str());
+    UtilityFunctions::print("Image dimensions: ", raw_width, "x", raw_height);
+    UtilityFunctions::print("Pixel Spacing: ", info.pixel_spacing_row, " x ", info.pixel_spacing_col, " mm");
+    UtilityFunctions::print("Calculated Pixel Aspect Ratio: ", pixel_aspect_ratio);
+    UtilityFunctions::print("Rescale Slope/Intercept: ", info.rescale_slope, " / ", info.rescale_intercept);
+    UtilityFunctions::print("Bits Allocated/Stored: ", info.bits_allocated, "/", info.bits_stored,
+                           ", Pixel Representation: ", info.pixel_representation);
     UtilityFunctions::print("Computed pixel value range: ", computed_min, " to ", computed_max);
     #endif
 
-    // If VOI WindowCenter/Width available, use them as defaults
-    if (have_voi && voi_width > 0.0) {
-        window_center = static_cast<float>(voi_center);
-        window_width = static_cast<float>(voi_width);
-        original_window_center = window_center;
-        original_window_width = window_width;
-        has_original_voi = true;
-        #ifdef DEBUG_DICOM_LOADING
-        UtilityFunctions::print("Using DICOM VOI Window/Level: ", window_width, " / ", window_center);
-        #endif
-    } else {
-        // Otherwise pick a sensible default from actual data range
-        window_center = static_cast<float>((computed_min + computed_max) * 0.5);
-        window_width = static_cast<float>((computed_max - computed_min));
-        if (window_width <= 0.0f) window_width = 1.0f;
+    // VOI WindowCenter/Width if available, else the actual data range
+    float default_center = 0.0f;
+    float default_width = 1.0f;
+    get_default_window(*slice, default_center, default_width);
+    if (!keep_window) {
+        window_center = default_center;
+        window_width = default_width;
         original_window_center = window_center;
         original_window_width = window_width;
-        has_original_voi = false;
+        has_original_voi = info.has_voi && info.voi_width > 0.0;
         #ifdef DEBUG_DICOM_LOADING
-        UtilityFunctions::print("No VOI metadata, using calculated Window/Level: ", window_width, " / ", window_center);
+        if (has_original_voi) {
+            UtilityFunctions::print("Using DICOM VOI Window/Level: ", window_width, " / ", window_center);
+        } else {
+            UtilityFunctions::print("No VOI metadata, using calculated Window/Level: ", window_width, " / ", window_center);
+        }
         #endif
     }
 
-#else
-    // Fallback: try to load as a regular image via Image::load_from_file
-    Ref<Image> tmp = Image::load_from_file(path);
-    if (tmp.is_null()) {
-        return false;
+    tiles_active = tiled_rendering && needs_tiles(*slice);
+    texture_rect->set_visible(!tiles_active);
+    if (tiles_active) {
+        // Tiles are windowed lazily in _draw(); drop the full-size staging
+        // image and texture so they do not hold memory in the meantime
+        uint64_t stage_start = time->get_ticks_usec();
+        if (pyramid && pyramid->get_source() == slice) {
+            tile_pyramid = pyramid;
+        } else if (!tile_pyramid || tile_pyramid->get_source() != slice) {
+            // Synchronous loads and re-displays build it here
+            std::shared_ptr<dicom::TilePyramid> built = std::make_shared<dicom::TilePyramid>();
+            built->build(slice);
+            tile_pyramid = built;
+        }
+        image_data.unref();
+        image_texture.unref();
+        texture_rect->set_texture(Ref<Texture2D>());
+        apply_window_level();
+        load_timings.window_usec = time->get_ticks_usec() - stage_start;
+        return;
     }
+    tile_pyramid.reset();
+    tile_textures.clear();
 
-    if (tmp->get_format() != Image::FORMAT_L8) {
-        tmp->convert(Image::FORMAT_L8);
+    uint64_t stage_start = time->get_ticks_usec();
+    if (prepared.is_valid() && prepared->get_width() == raw_width && prepared->get_height() == raw_height &&
+            prepared->get_format() == Image::FORMAT_L8 &&
+            window_center == default_center && window_width == default_width) {
+        // Windowed on the worker already; keep the engine in step for later
+        // window changes
+        image_data = prepared;
+        render_stats.image_allocations++;
+        window_engine.configure(slice->pixels, window_center, window_width);
+        window_version++;
+        reset_window_blocks(true);
+    } else {
+        apply_window_level();
     }
+    load_timings.window_usec = time->get_ticks_usec() - stage_start;
 
-    PackedByteArray data = tmp->get_data();
-    int w = tmp->get_width();
-    int h = tmp->get_height();
+    stage_start = time->get_ticks_usec();
+    update_texture();
+    load_timings.texture_usec = time->get_ticks_usec() - stage_start;
+}
 
-    raw_pixels.assign(w * h, 0.0);
-    const uint8_t *ptr = data.ptr();
-    for (int i = 0; i < w * h; ++i) {
-        raw_pixels[i] = static_cast<double>(ptr[i]);
+void DicomViewer::get_default_window(const dicom::DecodedSlice &p_slice, float &center, float &width) {
+    const dicom::SliceInfo &info = p_slice.info;
+    if (info.has_voi && info.voi_width > 0.0) {
+        center = static_cast<float>(info.voi_center);
+        width = static_cast<float>(info.voi_width);
+        return;
     }
-    raw_width = w;
-    raw_height = h;
-    pixel_aspect_ratio = 1.0f;
-
-    window_center = 127.5f;
-    window_width = 255.0f;
-#endif
+    // Modality value range (slope/intercept applied)
+    const double computed_min = p_slice.pixels.get_min_value();
+    const double computed_max = p_slice.pixels.get_max_value();
+    center = static_cast<float>((computed_min + computed_max) * 0.5);
+    width = static_cast<float>((computed_max - computed_min));
+    if (width <= 0.0f) width = 1.0f;
+}
 
-    apply_window_level();
-    update_texture();
+std::shared_ptr<dicom::DecodedSlice> DicomViewer::make_preview(const dicom::DecodedSlice &full, int factor, bool box_filter) {
+    std::shared_ptr<dicom::DecodedSlice> preview = std::make_shared<dicom::DecodedSlice>();
+    preview->path = full.path;
+    preview->info = full.info;
+    preview->tags = full.tags;
+    preview->timings = full.timings;
+    preview->frame_index = full.frame_index;
+    preview->frames = full.frames;
+    if (box_filter) {
+        dicom::downsample_box(full.pixels, factor, preview->pixels);
+    } else {
+        dicom::downsample_sample(full.pixels, factor, preview->pixels);
+    }
+    // Same range as the source, so the preview opens at the window the full
+    // image will get
+    preview->pixels.set_stored_range(full.pixels.get_min_stored(), full.pixels.get_max_stored());
+    return preview;
+}
 
-    return true;
+Ref<Image> DicomViewer::window_to_image(const dicom::PixelBuffer &pixels, float center, float width) {
+    if (pixels.is_empty()) {
+        return Ref<Image>();
+    }
+    Ref<Image> image = Image::create_empty(pixels.get_width(), pixels.get_height(), false, Image::FORMAT_L8);
+    uint8_t *dst = image->ptrw();
+    dicom::WindowEngine engine;
+    engine.configure(pixels, center, width);
+    const size_t row_width = (size_t)pixels.get_width();
+    dicom::ThreadPool::get_singleton()->parallel_for((size_t)pixels.get_height(), 64,
+            [&engine, &pixels, row_width, dst](size_t row_begin, size_t row_end) {
+                engine.apply(pixels, row_begin * row_width, (row_end - row_begin) * row_width, dst + row_begin * row_width);
+            });
+    return image;
 }
 
 void DicomViewer::apply_window_level() {
-    if (raw_pixels.empty() || raw_width <= 0 || raw_height <= 0) {
+    if (!slice || slice->pixels.is_empty() || raw_width <= 0 || raw_height <= 0) {
+        return;
+    }
+    const dicom::PixelBuffer &pixels = slice->pixels;
+
+    if (tiles_active) {
+        // Every level shares the source's stored range, so one engine
+        // configuration serves all tiles
+        window_engine.configure(pixels, window_center, window_width);
+        tile_version++;
+        queue_redraw();
         return;
     }
 
-    PackedByteArray bytes;
     const size_t total = size_t(raw_width) * size_t(raw_height);
-    bytes.resize((int)total);
-    uint8_t *dst = bytes.ptrw();
 
-    double low = static_cast<double>(window_center) - (static_cast<double>(window_width) * 0.5);
-    double high = static_cast<double>(window_center) + (static_cast<double>(window_width) * 0.5);
-    double denom = (high - low);
-    if (denom <= 0.0) denom = 1.0;
+    // Reuse the L8 image as the staging buffer while the size is unchanged,
+    // so a window/level tweak does not allocate
+    bool reallocated = false;
+    if (image_data.is_null() || image_data->get_width() != raw_width ||
+            image_data->get_height() != raw_height || image_data->get_format() != Image::FORMAT_L8) {
+        image_data = Image::create_empty(raw_width, raw_height, false, Image::FORMAT_L8);
+        render_stats.image_allocations++;
+        reset_window_blocks(false);
+        reallocated = true;
+    }
+
+    // Rebuilds the lookup table only when the window actually changed
+    window_engine.configure(pixels, window_center, window_width);
+    window_version++;
+
+    // Large images that are partly off screen: window what is in view only.
+    // A new staging size is windowed whole, as the layout has not caught up.
+    // The caller still uploads the full staging image afterwards.
+    if (viewport_windowing && !reallocated && total >= (size_t)parallel_windowing_threshold) {
+        int x0, y0, x1, y1;
+        if (get_visible_pixel_rect(x0, y0, x1, y1) && size_t(x1 - x0) * size_t(y1 - y0) < total) {
+            window_visible_blocks();
+            return;
+        }
+    }
+
+    uint8_t *dst = image_data->ptrw();
+
+    // Large images are windowed in bands of whole rows on the shared pool;
+    // the engine is read-only after configure() so bands run independently
+    int bands = 1;
+    if (total >= (size_t)parallel_windowing_threshold) {
+        dicom::ThreadPool *pool = dicom::ThreadPool::get_singleton();
+        bands = windowing_threads > 0 ? windowing_threads : pool->get_thread_count() + 1;
+    }
+    if (bands <= 1) {
+        window_engine.apply(pixels, 0, total, dst);
+    } else {
+        const size_t width = (size_t)raw_width;
+        const size_t rows_per_band = ((size_t)raw_height + bands - 1) / bands;
+        dicom::ThreadPool::get_singleton()->parallel_for((size_t)raw_height, rows_per_band,
+                [this, &pixels, width, dst](size_t row_begin, size_t row_end) {
+                    window_engine.apply(pixels, row_begin * width, (row_end - row_begin) * width, dst + row_begin * width);
+                });
+    }
+    reset_window_blocks(true);
+    render_stats.windowed_pixels += total;
+}
+
+void DicomViewer::reset_window_blocks(bool current) {
+    const int blocks_x = (raw_width + WINDOW_BLOCK_SIZE - 1) / WINDOW_BLOCK_SIZE;
+    const int blocks_y = (raw_height + WINDOW_BLOCK_SIZE - 1) / WINDOW_BLOCK_SIZE;
+    window_blocks_x = blocks_x;
+    window_blocks_y = blocks_y;
+    window_block_versions.assign(size_t(blocks_x) * size_t(blocks_y), current ? window_version : 0);
+}
+
+bool DicomViewer::get_visible_pixel_rect(int &x0, int &y0, int &x1, int &y1) const {
+    const Rect2 image_rect = get_image_screen_rect();
+    if (!image_rect.has_area()) {
+        return false;
+    }
+    const Rect2 visible = image_rect.intersection(Rect2(Vector2(), get_size()));
+    x0 = y0 = x1 = y1 = 0;
+    if (!visible.has_area()) {
+        // Entirely off screen
+        return true;
+    }
+    const double scale_x = raw_width / image_rect.size.x;
+    const double scale_y = raw_height / image_rect.size.y;
+    x0 = std::max(0, (int)std::floor((visible.position.x - image_rect.position.x) * scale_x));
+    y0 = std::max(0, (int)std::floor((visible.position.y - image_rect.position.y) * scale_y));
+    x1 = std::min(raw_width, (int)std::ceil((visible.get_end().x - image_rect.position.x) * scale_x));
+    y1 = std::min(raw_height, (int)std::ceil((visible.get_end().y - image_rect.position.y) * scale_y));
+    return x1 > x0 && y1 > y0;
+}
+
+size_t DicomViewer::window_visible_blocks() {
+    int x0, y0, x1, y1;
+    if (image_data.is_null() || !slice || !get_visible_pixel_rect(x0, y0, x1, y1) || x1 <= x0 || y1 <= y0) {
+        return 0;
+    }
+    std::vector<int> stale;
+    for (int by = y0 / WINDOW_BLOCK_SIZE; by <= (y1 - 1) / WINDOW_BLOCK_SIZE; ++by) {
+        for (int bx = x0 / WINDOW_BLOCK_SIZE; bx <= (x1 - 1) / WINDOW_BLOCK_SIZE; ++bx) {
+            const int index = by * window_blocks_x + bx;
+            if (window_block_versions[index] != window_version) {
+                stale.push_back(index);
+            }
+        }
+    }
+    if (stale.empty()) {
+        return 0;
+    }
+
+    const dicom::PixelBuffer &pixels = slice->pixels;
+    uint8_t *dst = image_data->ptrw();
+    const size_t stride = (size_t)raw_width;
+    dicom::ThreadPool::get_singleton()->parallel_for(stale.size(), 1,
+            [this, &pixels, &stale, dst, stride](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    const int bx = stale[i] % window_blocks_x;
+                    const int by = stale[i] / window_blocks_x;
+                    const int x = bx * WINDOW_BLOCK_SIZE;
+                    const int y = by * WINDOW_BLOCK_SIZE;
+                    const size_t width = (size_t)std::min(WINDOW_BLOCK_SIZE, raw_width - x);
+                    const int height = std::min(WINDOW_BLOCK_SIZE, raw_height - y);
+                    for (int row = 0; row < height; ++row) {
+                        const size_t first = size_t(y + row) * stride + size_t(x);
+                        window_engine.apply(pixels, first, width, dst + first);
+                    }
+                }
+            });
+
+    size_t windowed = 0;
+    for (int index : stale) {
+        window_block_versions[index] = window_version;
+        const int x = (index % window_blocks_x) * WINDOW_BLOCK_SIZE;
+        const int y = (index / window_blocks_x) * WINDOW_BLOCK_SIZE;
+        windowed += size_t(std::min(WINDOW_BLOCK_SIZE, raw_width - x)) * size_t(std::min(WINDOW_BLOCK_SIZE, raw_height - y));
+    }
+    render_stats.windowed_pixels += windowed;
+    return windowed;
+}
 
-    for (size_t i = 0; i < total; ++i) {
-        double v = raw_pixels[i];
-        double mapped = (v - low) * 255.0 / denom;
-        if (mapped < 0.0) mapped = 0.0;
-        if (mapped > 255.0) mapped = 255.0;
-        dst[i] = uint8_t(mapped);
+void DicomViewer::refresh_visible_window() {
+    if (tiles_active) {
+        queue_redraw();
+        return;
     }
+    if (window_visible_blocks() > 0) {
+        update_texture();
+    }
+}
 
-    image_data = Image::create_from_data(raw_width, raw_height, false, Image::FORMAT_L8, bytes);
+void DicomViewer::set_viewport_windowing(bool enabled) {
+    if (viewport_windowing == enabled) {
+        return;
+    }
+    viewport_windowing = enabled;
+    // Bring off-screen blocks up to date when switching it off
+    if (!enabled && !tiles_active && image_data.is_valid()) {
+        apply_window_level();
+        update_texture();
+    }
 }
 
 void DicomViewer::update_texture() {
-    if (image_data.is_null()) {
+    if (tiles_active || image_data.is_null()) {
         return;
     }
 
-    image_texture = ImageTexture::create_from_image(image_data);
-    texture_rect->set_texture(image_texture);
+    // Same size and format: upload into the existing texture in place.
+    // Otherwise a new GPU texture has to be allocated. Either way the whole
+    // image is uploaded, even when viewport windowing only rewrote the
+    // blocks in view: ImageTexture and RenderingServer::texture_2d_update()
+    // take whole images only, so upload time follows the image size.
+    if (image_texture.is_valid() && image_texture->get_width() == image_data->get_width() &&
+            image_texture->get_height() == image_data->get_height() &&
+            image_texture->get_format() == image_data->get_format()) {
+        image_texture->update(image_data);
+        render_stats.texture_updates++;
+    } else {
+        image_texture = ImageTexture::create_from_image(image_data);
+        texture_rect->set_texture(image_texture);
+        render_stats.texture_allocations++;
+    }
     
     // Apply aspect ratio correction to the TextureRect's custom minimum size
     // This ensures the image displays with correct physical proportions
-    if (pixel_aspect_ratio != 1.0f && raw_width > 0 && raw_height > 0) {
+    // Sized from the source image, so a preview takes the same space
+    if (pixel_aspect_ratio != 1.0f && source_width > 0 && source_height > 0) {
         // Calculate the display size with aspect ratio correction
         // If pixel_aspect_ratio > 1.0, pixels are taller than wide
         // If pixel_aspect_ratio < 1.0, pixels are wider than tall
-        float display_width = static_cast<float>(raw_width);
-        float display_height = static_cast<float>(raw_height) * pixel_aspect_ratio;
+        float display_width = static_cast<float>(source_width);
+        float display_height = static_cast<float>(source_height) * pixel_aspect_ratio;
         
         texture_rect->set_custom_minimum_size(Size2(display_width, display_height));
         #ifdef DEBUG_DICOM_LOADING
@@ -483,8 +1192,8 @@ void DicomViewer::update_texture() {
     } else {
         // Square pixels or no data - use original dimensions
         texture_rect->set_custom_minimum_size(Size2(
-            static_cast<float>(raw_width), 
-            static_cast<float>(raw_height)
+            static_cast<float>(source_width), 
+            static_cast<float>(source_height)
         ));
     }
 }
@@ -497,13 +1206,20 @@ void DicomViewer::set_window_level(float window, float level) {
 }
 
 void DicomViewer::zoom_in() {
-    zoom *= 1.25f;
-    texture_rect->set_scale(Size2(zoom, zoom));
+    set_zoom(zoom * 1.25f);
 }
 
 void DicomViewer::zoom_out() {
-    zoom /= 1.25f;
+    set_zoom(zoom / 1.25f);
+}
+
+void DicomViewer::set_zoom(float p_zoom) {
+    if (p_zoom <= 0.0f) {
+        return;
+    }
+    zoom = p_zoom;
     texture_rect->set_scale(Size2(zoom, zoom));
+    refresh_visible_window();
 }
 
 void DicomViewer::reset_view() {
@@ -511,20 +1227,308 @@ void DicomViewer::reset_view() {
     pan = Vector2(0,0);
     texture_rect->set_scale(Size2(1,1));
     texture_rect->set_position(Vector2(0,0));
+    refresh_visible_window();
+}
+
+void DicomViewer::set_pan(const Vector2 &p_pan) {
+    pan = p_pan;
+    texture_rect->set_position(pan);
+    refresh_visible_window();
+}
+
+Rect2 DicomViewer::get_image_screen_rect() const {
+    // Tiles are laid out with the physical aspect ratio in the control; the
+    // TextureRect fits the staging image's own size into its rect
+    Size2 image_size;
+    Size2 area;
+    if (tiles_active) {
+        image_size = Size2((real_t)source_width, (real_t)source_height * pixel_aspect_ratio);
+        area = get_size();
+    } else if (image_data.is_valid()) {
+        image_size = Size2((real_t)image_data->get_width(), (real_t)image_data->get_height());
+        area = texture_rect->get_size();
+    }
+    if (image_size.x <= 0 || image_size.y <= 0 || area.x <= 0 || area.y <= 0) {
+        return Rect2();
+    }
+    // Same placement as STRETCH_KEEP_ASPECT_CENTERED, then the TextureRect's
+    // scale (about its top-left) and position
+    const real_t fit = std::min(area.x / image_size.x, area.y / image_size.y);
+    const Size2 fitted = image_size * fit;
+    const Vector2 offset = (area - fitted) * 0.5f;
+    return Rect2(pan + offset * zoom, fitted * zoom);
+}
+
+void DicomViewer::set_tiled_rendering(bool enabled) {
+    if (tiled_rendering == enabled) {
+        return;
+    }
+    tiled_rendering = enabled;
+    // Re-display so the current image switches paths
+    if (slice) {
+        display_slice(slice, true);
+    }
+}
+
+void DicomViewer::_notification(int p_what) {
+    if (p_what == NOTIFICATION_RESIZED) {
+        refresh_visible_window();
+    }
+}
+
+void DicomViewer::_draw() {
+    if (!tiles_active || !tile_pyramid || tile_pyramid->is_empty()) {
+        return;
+    }
+    const Rect2 image_rect = get_image_screen_rect();
+    const Rect2 visible = image_rect.intersection(Rect2(Vector2(), get_size()));
+    if (!visible.has_area()) {
+        return;
+    }
+    draw_count++;
+
+    // Screen pixels per level-0 pixel picks the pyramid level
+    const dicom::PixelBuffer &base = tile_pyramid->get_level(0);
+    const double scale_x = image_rect.size.x / base.get_width();
+    const double scale_y = image_rect.size.y / base.get_height();
+    const int level = tile_pyramid->choose_level(std::min(scale_x, scale_y));
+    const dicom::PixelBuffer &pixels = tile_pyramid->get_level(level);
+    const real_t pixel_w = image_rect.size.x / pixels.get_width();
+    const real_t pixel_h = image_rect.size.y / pixels.get_height();
+
+    // Tiles overlapping the visible part of the image
+    const int tile_size = dicom::TilePyramid::TILE_SIZE;
+    const Vector2 from = visible.position - image_rect.position;
+    const Vector2 to = visible.get_end() - image_rect.position;
+    const int first_x = std::max(0, (int)(from.x / pixel_w) / tile_size);
+    const int first_y = std::max(0, (int)(from.y / pixel_h) / tile_size);
+    const int last_x = std::min(tile_pyramid->get_tiles_x(level) - 1, std::max(0, (int)std::ceil(to.x / pixel_w) - 1) / tile_size);
+    const int last_y = std::min(tile_pyramid->get_tiles_y(level) - 1, std::max(0, (int)std::ceil(to.y / pixel_h) - 1) / tile_size);
+
+    struct StaleTile {
+        uint64_t key;
+        int tile_x;
+        int tile_y;
+        Ref<Image> image;
+        uint8_t *dst;
+    };
+    std::vector<StaleTile> stale;
+    for (int ty = first_y; ty <= last_y; ++ty) {
+        for (int tx = first_x; tx <= last_x; ++tx) {
+            const uint64_t key = (uint64_t(level) << 48) | (uint64_t(ty) << 24) | uint64_t(tx);
+            auto found = tile_textures.find(key);
+            if (found != tile_textures.end() && found->second.version == tile_version) {
+                continue;
+            }
+            int x, y, w, h;
+            tile_pyramid->get_tile_rect(level, tx, ty, x, y, w, h);
+            StaleTile tile{ key, tx, ty, Image::create_empty(w, h, false, Image::FORMAT_L8), nullptr };
+            tile.dst = tile.image->ptrw();
+            stale.push_back(tile);
+        }
+    }
+
+    // Window stale tiles across the pool; uploads stay on this thread
+    dicom::ThreadPool::get_singleton()->parallel_for(stale.size(), 1, [this, level, &stale](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            tile_pyramid->window_tile(window_engine, level, stale[i].tile_x, stale[i].tile_y, stale[i].dst);
+        }
+    });
+    for (StaleTile &tile : stale) {
+        TileTexture &entry = tile_textures[tile.key];
+        if (entry.texture.is_valid() && entry.texture->get_width() == tile.image->get_width() &&
+                entry.texture->get_height() == tile.image->get_height()) {
+            entry.texture->update(tile.image);
+        } else {
+            entry.texture = ImageTexture::create_from_image(tile.image);
+        }
+        entry.version = tile_version;
+        render_stats.tile_uploads++;
+    }
+
+    for (int ty = first_y; ty <= last_y; ++ty) {
+        for (int tx = first_x; tx <= last_x; ++tx) {
+            const uint64_t key = (uint64_t(level) << 48) | (uint64_t(ty) << 24) | uint64_t(tx);
+            TileTexture &entry = tile_textures[key];
+            entry.last_drawn = draw_count;
+            int x, y, w, h;
+            tile_pyramid->get_tile_rect(level, tx, ty, x, y, w, h);
+            const Rect2 dest(image_rect.position + Vector2(x * pixel_w, y * pixel_h), Vector2(w * pixel_w, h * pixel_h));
+            draw_texture_rect(entry.texture, dest, false);
+        }
+    }
+
+    // Keep GPU memory in line with the viewport: besides the tiles drawn
+    // now, hold on to at most a few recently used ones
+    const size_t drawn = size_t(last_x - first_x + 1) * size_t(last_y - first_y + 1);
+    const size_t keep = drawn + 16;
+    for (auto it = tile_textures.begin(); it != tile_textures.end() && tile_textures.size() > keep;) {
+        if (it->second.last_drawn != draw_count) {
+            it = tile_textures.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+// Convert a kept element to a Variant by its VR
+static Variant tag_value_to_variant(const dicom::TagStore::Entry &entry, const std::string &text) {
+    const String value = String::utf8(text.c_str(), (int64_t)text.size());
+    const char vr[3] = { entry.vr[0], entry.vr[1], '\0' };
+    const String name(vr);
+    const bool is_integer = name == "IS" || name == "SL" || name == "SS" || name == "UL" || name == "US" ||
+            name == "SV" || name == "UV";
+    const bool is_real = name == "DS" || name == "FL" || name == "FD";
+    if (!is_integer && !is_real) {
+        return value;
+    }
+    const PackedStringArray parts = value.split("\\");
+    if (parts.size() == 1) {
+        return is_integer ? Variant(parts[0].strip_edges().to_int()) : Variant(parts[0].strip_edges().to_float());
+    }
+    Array values;
+    for (int i = 0; i < parts.size(); ++i) {
+        values.append(is_integer ? Variant(parts[i].strip_edges().to_int()) : Variant(parts[i].strip_edges().to_float()));
+    }
+    return values;
 }
 
 Dictionary DicomViewer::get_metadata() const {
     Dictionary meta;
-#ifdef USE_DCMTK
-    meta["note"] = "DCMTK built-in; metadata available during load_dicom()";
+    if (!slice) {
+        return meta;
+    }
     meta["pixel_aspect_ratio"] = pixel_aspect_ratio;
-#else
-    meta["note"] = "No DICOM library compiled; metadata unavailable";
-    meta["pixel_aspect_ratio"] = 1.0f;
-#endif
+    meta["rows"] = source_height;
+    meta["columns"] = source_width;
+    meta["transfer_syntax"] = String::utf8(slice->info.transfer_syntax.c_str());
+    if (!slice->tags) {
+        return meta;
+    }
+
+    // Only these fields are converted; get_tag() reaches the rest
+    static const struct {
+        const char *key;
+        uint16_t group;
+        uint16_t element;
+    } fields[] = {
+        { "patient_name", 0x0010, 0x0010 },
+        { "patient_id", 0x0010, 0x0020 },
+        { "patient_birth_date", 0x0010, 0x0030 },
+        { "patient_sex", 0x0010, 0x0040 },
+        { "patient_age", 0x0010, 0x1010 },
+        { "study_instance_uid", 0x0020, 0x000D },
+        { "study_date", 0x0008, 0x0020 },
+        { "study_time", 0x0008, 0x0030 },
+        { "study_description", 0x0008, 0x1030 },
+        { "accession_number", 0x0008, 0x0050 },
+        { "series_instance_uid", 0x0020, 0x000E },
+        { "series_number", 0x0020, 0x0011 },
+        { "series_description", 0x0008, 0x103E },
+        { "modality", 0x0008, 0x0060 },
+        { "body_part_examined", 0x0018, 0x0015 },
+        { "sop_instance_uid", 0x0008, 0x0018 },
+        { "instance_number", 0x0020, 0x0013 },
+        { "manufacturer", 0x0008, 0x0070 },
+        { "institution_name", 0x0008, 0x0080 },
+        { "pixel_spacing", 0x0028, 0x0030 },
+        { "slice_thickness", 0x0018, 0x0050 },
+        { "image_position_patient", 0x0020, 0x0032 },
+        { "image_orientation_patient", 0x0020, 0x0037 },
+        { "window_center", 0x0028, 0x1050 },
+        { "window_width", 0x0028, 0x1051 },
+        { "rescale_slope", 0x0028, 0x1053 },
+        { "rescale_intercept", 0x0028, 0x1052 },
+    };
+    const dicom::TagStore &tags = *slice->tags;
+    for (const auto &field : fields) {
+        const dicom::TagStore::Entry *entry = tags.find(dicom::TagStore::make_tag(field.group, field.element));
+        if (entry) {
+            meta[field.key] = tag_value_to_variant(*entry, tags.get_value(*entry));
+        }
+    }
+    meta["tag_count"] = (int64_t)tags.get_count();
     return meta;
 }
 
+Variant DicomViewer::get_tag(int group, int element) const {
+    if (!slice || !slice->tags) {
+        return Variant();
+    }
+    const dicom::TagStore::Entry *entry = slice->tags->find(dicom::TagStore::make_tag((uint16_t)group, (uint16_t)element));
+    return entry ? tag_value_to_variant(*entry, slice->tags->get_value(*entry)) : Variant();
+}
+
+bool DicomViewer::has_tag(int group, int element) const {
+    return slice && slice->tags && slice->tags->find(dicom::TagStore::make_tag((uint16_t)group, (uint16_t)element)) != nullptr;
+}
+
+Dictionary DicomViewer::get_all_tags() const {
+    Dictionary all;
+    if (!slice || !slice->tags) {
+        return all;
+    }
+    const dicom::TagStore &tags = *slice->tags;
+    for (size_t i = 0; i < tags.get_count(); ++i) {
+        const dicom::TagStore::Entry &entry = tags.get_entry(i);
+        const String key = "(" + String::num_int64(entry.tag >> 16, 16).lpad(4, "0") + "," +
+                String::num_int64(entry.tag & 0xFFFF, 16).lpad(4, "0") + ")";
+        all[key.to_upper()] = tag_value_to_variant(entry, tags.get_value(entry));
+    }
+    return all;
+}
+
+void DicomViewer::set_windowing_threads(int threads) {
+    windowing_threads = threads > 0 ? threads : 0;
+}
+
+void DicomViewer::set_parallel_windowing_threshold(int pixels_threshold) {
+    parallel_windowing_threshold = pixels_threshold > 0 ? pixels_threshold : 0;
+}
+
+String DicomViewer::get_windowing_mode() const {
+    switch (window_engine.get_mode()) {
+        case dicom::WINDOW_MODE_LUT:
+            return "lut";
+        case dicom::WINDOW_MODE_FLOAT:
+            return "float";
+        case dicom::WINDOW_MODE_SIMD:
+            return "simd";
+        default:
+            return "none";
+    }
+}
+
+String DicomViewer::get_simd_instruction_set() const {
+    return dicom::get_simd_level_name(dicom::get_simd_level());
+}
+
+Dictionary DicomViewer::get_render_stats() const {
+    // Cumulative counts since the viewer was created
+    Dictionary stats;
+    stats["image_allocations"] = (int64_t)render_stats.image_allocations;
+    stats["texture_allocations"] = (int64_t)render_stats.texture_allocations;
+    stats["texture_updates"] = (int64_t)render_stats.texture_updates;
+    stats["tile_uploads"] = (int64_t)render_stats.tile_uploads;
+    stats["windowed_pixels"] = (int64_t)render_stats.windowed_pixels;
+    stats["tiles_cached"] = (int64_t)tile_textures.size();
+    return stats;
+}
+
+Dictionary DicomViewer::get_load_timings() const {
+    // All values are in microseconds for the most recent successful load_dicom()
+    Dictionary timings;
+    timings["parse_usec"] = (int64_t)load_timings.parse_usec;
+    timings["decode_usec"] = (int64_t)load_timings.decode_usec;
+    timings["convert_usec"] = (int64_t)load_timings.convert_usec;
+    timings["window_usec"] = (int64_t)load_timings.window_usec;
+    timings["texture_usec"] = (int64_t)load_timings.texture_usec;
+    timings["total_usec"] = (int64_t)load_timings.total_usec;
+    // Pixels read in place from a memory-mapped file
+    timings["zero_copy"] = slice && slice->pixels.is_external();
+    return timings;
+}
+
 void DicomViewer::apply_soft_tissue_preset() {
     set_window_level(400.0f, 40.0f);
 }
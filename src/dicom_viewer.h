@@ -1,9 +1,20 @@
 #pragma once
 
+#include "dicom_decoder.h"
+#include "dicom_volume.h"
+#include "pixel_buffer.h"
+#include "tile_pyramid.h"
+#include "window_level.h"
+
 #include <godot_cpp/classes/control.hpp>
 #include <godot_cpp/classes/texture_rect.hpp>
 #include <godot_cpp/classes/image_texture.hpp>
 #include <godot_cpp/classes/image.hpp>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 #include <vector>
 
 namespace godot {
@@ -16,9 +27,15 @@ private:
     Ref<ImageTexture> image_texture;
     Ref<Image> image_data;
 
-    std::vector<double> raw_pixels;
+    // Image on display: native-width pixels plus the header fields we use.
+    // Shared and immutable, so it can come straight from a worker thread.
+    std::shared_ptr<const dicom::DecodedSlice> slice;
+    dicom::WindowEngine window_engine;
     int raw_width;
     int raw_height;
+    // Size of the source image; differs from raw_* while a preview is shown
+    int source_width;
+    int source_height;
 
     float window_width;
     float window_center;
@@ -32,35 +49,284 @@ private:
     float original_window_width;
     float original_window_center;
     bool has_original_voi;
+
+    // Per-stage timings of the last load_dicom() call, in microseconds
+    struct LoadTimings {
+        uint64_t parse_usec = 0;
+        uint64_t decode_usec = 0;
+        uint64_t convert_usec = 0;
+        uint64_t window_usec = 0;
+        uint64_t texture_usec = 0;
+        uint64_t total_usec = 0;
+    };
+    LoadTimings load_timings;
+
+    // Staging image / GPU texture allocation counters
+    struct RenderStats {
+        uint64_t image_allocations = 0;
+        uint64_t texture_allocations = 0;
+        uint64_t texture_updates = 0;
+        uint64_t tile_uploads = 0;
+        uint64_t windowed_pixels = 0;
+    };
+    RenderStats render_stats;
+
+    // Band count for parallel windowing (0 = pool threads + caller) and the
+    // pixel count below which windowing stays on the calling thread
+    int windowing_threads;
+    int parallel_windowing_threshold;
+
+    // Async loads of images with at least `progressive_threshold` pixels
+    // show a 1/`preview_factor` preview first
+    bool progressive_loading;
+    int progressive_threshold;
+    int preview_factor;
+
+    // With tiled rendering, images larger than one tile are drawn from a
+    // pyramid in _draw(): only tiles in view, at the level matching the
+    // zoom, are windowed and uploaded
+    bool tiled_rendering;
+    bool tiles_active;
+    // Shared so an async load can hand over a pyramid built on its worker
+    std::shared_ptr<const dicom::TilePyramid> tile_pyramid;
+    struct TileTexture {
+        Ref<ImageTexture> texture;
+        uint64_t version = 0;
+        uint64_t last_drawn = 0;
+    };
+    std::unordered_map<uint64_t, TileTexture> tile_textures;
+    // Bumped whenever the slice or window changes; older tiles are stale
+    uint64_t tile_version;
+    uint64_t draw_count;
+
+    // With viewport windowing, a window change on a large image only
+    // rewrites the blocks of the staging image that are in view; the others
+    // keep the old window until pan, zoom or a resize brings them in. This
+    // bounds the CPU windowing cost only: ImageTexture has no partial
+    // update, so the whole staging image is still uploaded. Tiled rendering
+    // uploads only the tiles in view.
+    bool viewport_windowing;
+    static constexpr int WINDOW_BLOCK_SIZE = 256;
+    int window_blocks_x;
+    int window_blocks_y;
+    // Window version each block was last written with
+    std::vector<uint64_t> window_block_versions;
+    uint64_t window_version;
     
+    // State shared with background decode jobs. It outlives the viewer if a
+    // job is still running; `generation` is bumped by every load request so
+    // superseded results are dropped.
+    struct AsyncLoadState {
+        std::mutex mutex;
+        uint64_t generation = 0;
+        int pending = 0;
+        bool has_result = false;
+        std::shared_ptr<const dicom::DecodedSlice> result;
+        // Full-resolution image windowed on the worker at the default window
+        Ref<Image> prepared_image;
+        // Built on the worker instead when the result will be drawn tiled
+        std::shared_ptr<const dicom::TilePyramid> pyramid;
+        // Frame of the image on display the result is for (set_frame()), or
+        // -1 for a file load
+        int frame = -1;
+        bool has_preview = false;
+        std::shared_ptr<const dicom::DecodedSlice> preview;
+        // Set once the preview of the current request is on screen
+        bool preview_shown = false;
+        String result_path;
+        String result_error;
+        uint64_t request_start = 0;
+    };
+    std::shared_ptr<AsyncLoadState> async_state;
+    // Bumped by every prefetch_slices() call to retire queued prefetch jobs
+    std::shared_ptr<std::atomic<uint64_t>> prefetch_generation;
+
+    // Decode a file without touching the viewer; safe on worker threads
+    static std::shared_ptr<dicom::DecodedSlice> decode_slice(const String &path, const String &absolute_path, String &error);
+    // Slice cache key of frame `index` of the file at `path`; frame 0 is
+    // cached under the file's own key, as load_dicom() stores it
+    static std::string get_frame_cache_key(const std::string &path, int index);
+    // Volume the current slice was taken from, if any. Stepping through the
+    // same volume keeps the window instead of resetting it per slice.
+    std::shared_ptr<const dicom::Volume> volume_on_display;
+
+    // Retire queued and running async loads; returns the new generation
+    uint64_t supersede_async_loads();
+    // Display `p_slice`. A `prepared` L8 image windowed at the slice's
+    // default window is used as is when that is the window to show, and a
+    // `pyramid` built from `p_slice` saves building one here.
+    void display_slice(const std::shared_ptr<const dicom::DecodedSlice> &p_slice, bool keep_window = false,
+            const Ref<Image> &prepared = Ref<Image>(), const std::shared_ptr<const dicom::TilePyramid> &pyramid = nullptr);
+    // Whether `p_slice` is drawn from a tile pyramid when tiled rendering is on
+    static bool needs_tiles(const dicom::DecodedSlice &p_slice);
+
+    // Window/level the slice's header or pixel range suggests
+    static void get_default_window(const dicom::DecodedSlice &p_slice, float &center, float &width);
+    // Downsampled copy of `full` that keeps its header and stored range.
+    // Box-filtered for thumbnails; otherwise decimated, which is several
+    // times cheaper than windowing the full image.
+    static std::shared_ptr<dicom::DecodedSlice> make_preview(const dicom::DecodedSlice &full, int factor, bool box_filter);
+    // Window `pixels` into a new L8 image; safe on worker threads
+    static Ref<Image> window_to_image(const dicom::PixelBuffer &pixels, float center, float width);
+    // Thumbnail from the on-disk cache, else decoded (through the slice cache
+    // if `use_slice_cache`) and stored there; safe on worker threads
+    static Ref<Image> make_thumbnail(const String &path, int max_size, bool use_slice_cache, String &error);
+
     void apply_window_level();
     void update_texture();
+    // Size the block grid to the staging image; `current` marks every block
+    // as windowed at the current version
+    void reset_window_blocks(bool current);
+    // Staging image pixels in view, or false before layout
+    bool get_visible_pixel_rect(int &x0, int &y0, int &x1, int &y1) const;
+    // Window the stale blocks in view; returns the pixels written
+    size_t window_visible_blocks();
+    // Catch up blocks that pan/zoom/resize brought into view
+    void refresh_visible_window();
 
 protected:
     static void _bind_methods();
+    void _notification(int p_what);
 
 public:
     DicomViewer();
-    ~DicomViewer() {}
+    ~DicomViewer();
+
+    virtual void _process(double p_delta) override;
+    virtual void _draw() override;
+
+    // Resolve res:// and user:// to an absolute filesystem path
+    static String globalize_path(const String &path);
+    // The file at `path` (frame 0 of a multi-frame file) or frame `index`
+    // of an open multi-frame file, from the slice cache, else decoded and
+    // cached. Safe on worker threads.
+    static std::shared_ptr<const dicom::DecodedSlice> get_file_slice(const String &path, String &error);
+    static std::shared_ptr<const dicom::DecodedSlice> get_frame_slice(const std::shared_ptr<const dicom::FrameSource> &frames,
+            int index, String &error);
+
+    // Image on display, and showing one decoded elsewhere (e.g. by
+    // DicomCinePlayer). Like a load, showing supersedes async loads.
+    std::shared_ptr<const dicom::DecodedSlice> get_slice() const { return slice; }
+    void show_slice(const std::shared_ptr<const dicom::DecodedSlice> &p_slice, bool keep_window);
 
     bool load_dicom(const String &path);
+    // Decode on a worker thread and display on the main thread once done.
+    // Emits load_completed(path, ok) and, on error, load_failed(path, error).
+    // A newer request cancels older ones. Returns the request id.
+    int load_dicom_async(const String &path);
+    bool is_loading() const;
+
+    // Display slice `index` of a loaded volume; no file access
+    bool show_volume_slice(const Ref<DicomVolume> &volume, int index);
+    // Display an axial, coronal or sagittal plane reformatted from a volume
+    bool show_volume_plane(const Ref<DicomVolume> &volume, DicomVolume::Axis axis, int index);
+    // Thick-slab MIP/MinIP/AvgIP centred on plane `index`. A slab thinner
+    // than two planes shows the plane itself. An unknown `mode` is an error.
+    bool show_volume_slab(const Ref<DicomVolume> &volume, DicomVolume::Axis axis, int index, float thickness_mm, DicomVolume::Projection mode);
+
+    // Frames of a multi-frame image (1 for other images, 0 when empty).
+    // Frames are decoded when first shown and kept in the slice cache.
+    int get_frame_count() const;
+    int get_frame() const { return slice ? slice->frame_index : 0; }
+    // Display frame `index` of the loaded file, keeping the window. A cached
+    // frame is shown at once; others are decoded on a worker like
+    // load_dicom_async(). Either way frame_changed is emitted once the frame
+    // is on screen, and a decode error emits load_failed; load_completed is
+    // left to file loads. Returns false only for an index out of range.
+    bool set_frame(int index);
+
+    // Progressive display for async loads of large images
+    void set_progressive_loading(bool enabled) { progressive_loading = enabled; }
+    bool is_progressive_loading() const { return progressive_loading; }
+    void set_progressive_threshold(int pixels_threshold);
+    int get_progressive_threshold() const { return progressive_threshold; }
+    void set_preview_factor(int factor);
+    int get_preview_factor() const { return preview_factor; }
+    // Box-filtered L8 image of `path` no larger than `max_size` on its longer
+    // side, windowed at the file's default window. Uses the slice cache.
+    Ref<Image> create_thumbnail(const String &path, int max_size);
+    // Thumbnails for many files at once, decoded in parallel; entries for
+    // unreadable files are null. Both thumbnail calls go through the on-disk
+    // thumbnail cache. Blocks until every file is done, so call it from a
+    // Thread for long lists; it touches no viewer or scene state.
+    static Array create_thumbnails(const Array &paths, int max_size);
+    static void clear_thumbnail_cache();
+    // Decode the compressed single-frame DICOM files among `paths` once, in
+    // parallel, into the transcode cache, which later loads of the same
+    // unchanged files map instead of decoding. Returns how many are cached.
+    // Blocks like create_thumbnails(), so call it from a Thread.
+    static int transcode_files(const Array &paths);
+    static void clear_transcode_cache();
+
+    // Decode up to `ahead` slices after and `behind` slices before `index` of
+    // `paths` in the background so scrolling hits the slice cache. Does
+    // nothing when the thread pool has no workers.
+    void prefetch_slices(const Array &paths, int index, int ahead, int behind);
+    // The decoded-slice cache is shared by all viewers
+    void set_cache_budget_mb(int megabytes);
+    int get_cache_budget_mb() const;
+    Dictionary get_cache_stats() const;
+    void clear_cache();
+
     void set_window_level(float window, float level);
     void set_window(float window) { window_width = window; apply_window_level(); update_texture(); }
     void set_level(float level) { window_center = level; apply_window_level(); update_texture(); }
     float get_window() const { return window_width; }
     float get_level() const { return window_center; }
 
+    // Zoom and pan go through these so the viewer knows what is in view;
+    // scaling or moving the child TextureRect directly bypasses viewport
+    // windowing and tiled rendering
     void zoom_in();
     void zoom_out();
     void reset_view();
+    void set_zoom(float p_zoom);
+    float get_zoom() const { return zoom; }
+    void set_pan(const Vector2 &p_pan);
+    Vector2 get_pan() const { return pan; }
+    // Where the image currently lands in the control's coordinates
+    Rect2 get_image_screen_rect() const;
+
+    void set_tiled_rendering(bool enabled);
+    bool is_tiled_rendering() const { return tiled_rendering; }
+    // Windows only the blocks in view on W/L changes; the texture upload
+    // stays full size, see update_texture()
+    void set_viewport_windowing(bool enabled);
+    bool is_viewport_windowing() const { return viewport_windowing; }
     
+    // Common patient/study/series/image fields of the image on display,
+    // converted from the tags kept at load time (absent fields are left out)
     Dictionary get_metadata() const;
+    // One element of the image on display: int or float (Array when the
+    // element holds several values) for numeric VRs, String otherwise; null
+    // if absent. Binary and sequence elements are not kept.
+    Variant get_tag(int group, int element) const;
+    bool has_tag(int group, int element) const;
+    // Every kept element, keyed "(gggg,eeee)"; converts all of them
+    Dictionary get_all_tags() const;
     float get_pixel_aspect_ratio() const { return pixel_aspect_ratio; }
     String get_modality() const { return current_modality; }
     
     // Image dimension methods
-    int get_image_width() const { return raw_width; }
-    int get_image_height() const { return raw_height; }
+    int get_image_width() const { return source_width; }
+    int get_image_height() const { return source_height; }
+
+    // Load-time breakdown (parse / decode / convert / window / texture)
+    Dictionary get_load_timings() const;
+    // Staging image and texture allocations vs. in-place texture updates
+    Dictionary get_render_stats() const;
+    // Bytes held by the decoded pixel buffer
+    int64_t get_pixel_memory_usage() const { return slice ? (int64_t)slice->pixels.get_byte_size() : 0; }
+    // "simd" for 16-bit/float data on CPUs with a vector unit, "lut" for other
+    // integer data with a small stored range, "float" otherwise
+    String get_windowing_mode() const;
+    void set_windowing_threads(int threads);
+    int get_windowing_threads() const { return windowing_threads; }
+    void set_parallel_windowing_threshold(int pixels_threshold);
+    int get_parallel_windowing_threshold() const { return parallel_windowing_threshold; }
+
+    // Vector instruction set picked at runtime ("avx2", "sse2", "neon", "scalar")
+    String get_simd_instruction_set() const;
     
     // Window/Level presets
     void apply_soft_tissue_preset();
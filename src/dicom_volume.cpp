@@ -0,0 +1,118 @@
+#include "dicom_volume.h"
+#include "dicom_viewer.h"
+
+#include <string>
+#include <vector>
+
+#include <godot_cpp/variant/utility_functions.hpp>
+#include <godot_cpp/classes/time.hpp>
+#include <godot_cpp/core/class_db.hpp>
+
+using namespace godot;
+
+static Vector3 to_vector3(const double *v) {
+    return Vector3((real_t)v[0], (real_t)v[1], (real_t)v[2]);
+}
+
+void DicomVolume::_bind_methods() {
+    ClassDB::bind_method(D_METHOD("load_series", "paths"), &DicomVolume::load_series);
+    ClassDB::bind_method(D_METHOD("clear"), &DicomVolume::clear);
+    ClassDB::bind_method(D_METHOD("is_loaded"), &DicomVolume::is_loaded);
+    ClassDB::bind_method(D_METHOD("get_width"), &DicomVolume::get_width);
+    ClassDB::bind_method(D_METHOD("get_height"), &DicomVolume::get_height);
+    ClassDB::bind_method(D_METHOD("get_depth"), &DicomVolume::get_depth);
+    ClassDB::bind_method(D_METHOD("get_dimensions"), &DicomVolume::get_dimensions);
+    ClassDB::bind_method(D_METHOD("get_spacing"), &DicomVolume::get_spacing);
+    ClassDB::bind_method(D_METHOD("get_origin"), &DicomVolume::get_origin);
+    ClassDB::bind_method(D_METHOD("get_row_direction"), &DicomVolume::get_row_direction);
+    ClassDB::bind_method(D_METHOD("get_column_direction"), &DicomVolume::get_column_direction);
+    ClassDB::bind_method(D_METHOD("get_slice_direction"), &DicomVolume::get_slice_direction);
+    ClassDB::bind_method(D_METHOD("get_plane_count", "axis"), &DicomVolume::get_plane_count);
+    ClassDB::bind_method(D_METHOD("is_sorted_by_position"), &DicomVolume::is_sorted_by_position);
+    ClassDB::bind_method(D_METHOD("get_modality"), &DicomVolume::get_modality);
+    ClassDB::bind_method(D_METHOD("get_series_instance_uid"), &DicomVolume::get_series_instance_uid);
+    ClassDB::bind_method(D_METHOD("get_slice_path", "index"), &DicomVolume::get_slice_path);
+    ClassDB::bind_method(D_METHOD("get_memory_usage"), &DicomVolume::get_memory_usage);
+    ClassDB::bind_method(D_METHOD("get_load_time_usec"), &DicomVolume::get_load_time_usec);
+
+    BIND_ENUM_CONSTANT(AXIS_AXIAL);
+    BIND_ENUM_CONSTANT(AXIS_CORONAL);
+    BIND_ENUM_CONSTANT(AXIS_SAGITTAL);
+    BIND_ENUM_CONSTANT(PROJECTION_MAX);
+    BIND_ENUM_CONSTANT(PROJECTION_MIN);
+    BIND_ENUM_CONSTANT(PROJECTION_AVERAGE);
+}
+
+DicomVolume::DicomVolume() {
+    load_usec = 0;
+}
+
+bool DicomVolume::load_series(const Array &paths) {
+    const uint64_t load_start = Time::get_singleton()->get_ticks_usec();
+
+    std::vector<std::string> absolute_paths;
+    absolute_paths.reserve(paths.size());
+    for (int i = 0; i < paths.size(); ++i) {
+        const String path = paths[i];
+        absolute_paths.push_back(DicomViewer::globalize_path(path).utf8().get_data());
+    }
+
+    std::shared_ptr<dicom::Volume> loaded = std::make_shared<dicom::Volume>();
+    std::string error;
+    if (!dicom::load_volume(absolute_paths, *loaded, error)) {
+        UtilityFunctions::push_error("Failed to load DICOM series: ", String::utf8(error.c_str()));
+        return false;
+    }
+
+    volume = loaded;
+    load_usec = Time::get_singleton()->get_ticks_usec() - load_start;
+    return true;
+}
+
+void DicomVolume::clear() {
+    volume.reset();
+    load_usec = 0;
+}
+
+Vector3i DicomVolume::get_dimensions() const {
+    return Vector3i(get_width(), get_height(), get_depth());
+}
+
+int DicomVolume::get_plane_count(Axis axis) const {
+    return volume ? dicom::get_plane_count(*volume, (dicom::VolumeAxis)axis) : 0;
+}
+
+Vector3 DicomVolume::get_spacing() const {
+    return volume ? to_vector3(volume->spacing) : Vector3(1, 1, 1);
+}
+
+Vector3 DicomVolume::get_origin() const {
+    return volume ? to_vector3(volume->origin) : Vector3();
+}
+
+Vector3 DicomVolume::get_row_direction() const {
+    return volume ? to_vector3(volume->row_direction) : Vector3(1, 0, 0);
+}
+
+Vector3 DicomVolume::get_column_direction() const {
+    return volume ? to_vector3(volume->column_direction) : Vector3(0, 1, 0);
+}
+
+Vector3 DicomVolume::get_slice_direction() const {
+    return volume ? to_vector3(volume->slice_direction) : Vector3(0, 0, 1);
+}
+
+String DicomVolume::get_modality() const {
+    return volume ? String::utf8(volume->info.modality.c_str()) : String();
+}
+
+String DicomVolume::get_series_instance_uid() const {
+    return volume ? String::utf8(volume->info.series_instance_uid.c_str()) : String();
+}
+
+String DicomVolume::get_slice_path(int index) const {
+    if (!volume || index < 0 || index >= volume->depth) {
+        return String();
+    }
+    return String::utf8(volume->slice_paths[index].c_str());
+}
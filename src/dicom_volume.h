@@ -0,0 +1,78 @@
+#pragma once
+
+#include "projection.h"
+#include "volume.h"
+
+#include <godot_cpp/classes/ref_counted.hpp>
+#include <godot_cpp/variant/array.hpp>
+#include <godot_cpp/variant/string.hpp>
+#include <godot_cpp/variant/vector3.hpp>
+#include <godot_cpp/variant/vector3i.hpp>
+
+#include <memory>
+
+namespace godot {
+
+// A whole series held in memory as one 3D block, for slice navigation
+// without going back to the files
+class DicomVolume : public RefCounted {
+    GDCLASS(DicomVolume, RefCounted);
+
+public:
+    // Matches dicom::VolumeAxis
+    enum Axis {
+        AXIS_AXIAL = dicom::VOLUME_AXIS_AXIAL,
+        AXIS_CORONAL = dicom::VOLUME_AXIS_CORONAL,
+        AXIS_SAGITTAL = dicom::VOLUME_AXIS_SAGITTAL,
+    };
+    // Matches dicom::ProjectionMode
+    enum Projection {
+        PROJECTION_MAX = dicom::PROJECTION_MAX,
+        PROJECTION_MIN = dicom::PROJECTION_MIN,
+        PROJECTION_AVERAGE = dicom::PROJECTION_AVERAGE,
+    };
+
+private:
+    std::shared_ptr<const dicom::Volume> volume;
+    uint64_t load_usec;
+
+protected:
+    static void _bind_methods();
+
+public:
+    DicomVolume();
+
+    // Decode every path (res://, user:// or absolute) in parallel and stack
+    // the slices in patient order. Replaces any previously loaded series.
+    // Fails if the files mix series or slice orientations.
+    bool load_series(const Array &paths);
+    void clear();
+
+    bool is_loaded() const { return volume != nullptr; }
+    int get_width() const { return volume ? volume->width : 0; }
+    int get_height() const { return volume ? volume->height : 0; }
+    int get_depth() const { return volume ? volume->depth : 0; }
+    Vector3i get_dimensions() const;
+    // Voxel size in mm (column, row, slice)
+    Vector3 get_spacing() const;
+    Vector3 get_origin() const;
+    Vector3 get_row_direction() const;
+    Vector3 get_column_direction() const;
+    Vector3 get_slice_direction() const;
+    // Planes available along `axis` (depth, height or width)
+    int get_plane_count(Axis axis) const;
+    bool is_sorted_by_position() const { return volume && volume->sorted_by_position; }
+
+    String get_modality() const;
+    String get_series_instance_uid() const;
+    String get_slice_path(int index) const;
+    int64_t get_memory_usage() const { return volume ? (int64_t)volume->get_byte_size() : 0; }
+    int64_t get_load_time_usec() const { return (int64_t)load_usec; }
+
+    std::shared_ptr<const dicom::Volume> get_volume() const { return volume; }
+};
+
+}
+
+VARIANT_ENUM_CAST(DicomVolume::Axis);
+VARIANT_ENUM_CAST(DicomVolume::Projection);
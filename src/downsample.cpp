@@ -0,0 +1,131 @@
+#include "downsample.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+
+namespace dicom {
+
+int get_downsample_factor(int width, int height, int max_size) {
+    const int longest = width > height ? width : height;
+    if (max_size <= 0 || longest <= max_size) {
+        return 1;
+    }
+    return (longest + max_size - 1) / max_size;
+}
+
+namespace {
+
+template <typename T>
+inline T mean_of(int64_t sum, int64_t count) {
+    // Round half away from zero
+    return static_cast<T>(sum >= 0 ? (sum + count / 2) / count : -((-sum + count / 2) / count));
+}
+
+// Column sums of a band of rows use 32-bit integers when a full block of
+// 16-bit values cannot overflow them; wider types sum in int64, floats in
+// double
+template <typename T, typename Sum>
+void downsample_rows(const T *src, int width, int height, int factor, T *dst, int out_width, size_t row_begin, size_t row_end) {
+    std::vector<Sum> sums((size_t)width);
+    for (size_t out_y = row_begin; out_y < row_end; ++out_y) {
+        const int y0 = int(out_y) * factor;
+        const int y1 = y0 + factor < height ? y0 + factor : height;
+        // Sum the band's rows column by column: a straight pass over each
+        // source row that the compiler vectorises
+        const T *first = src + size_t(y0) * size_t(width);
+        for (int x = 0; x < width; ++x) {
+            sums[size_t(x)] = static_cast<Sum>(first[x]);
+        }
+        for (int y = y0 + 1; y < y1; ++y) {
+            const T *row = src + size_t(y) * size_t(width);
+            for (int x = 0; x < width; ++x) {
+                sums[size_t(x)] += static_cast<Sum>(row[x]);
+            }
+        }
+        // Then add `factor` column sums per output pixel
+        T *out = dst + out_y * size_t(out_width);
+        const Sum *column = sums.data();
+        for (int out_x = 0; out_x < out_width; ++out_x) {
+            const int x0 = out_x * factor;
+            const int x1 = x0 + factor < width ? x0 + factor : width;
+            Sum sum = 0;
+            for (int x = x0; x < x1; ++x) {
+                sum += column[x];
+            }
+            const int64_t count = int64_t(x1 - x0) * int64_t(y1 - y0);
+            if constexpr (std::is_floating_point<T>::value) {
+                out[out_x] = static_cast<T>(double(sum) / double(count));
+            } else {
+                out[out_x] = mean_of<T>(int64_t(sum), count);
+            }
+        }
+    }
+}
+
+template <typename T>
+void sample_rows(const T *src, int width, int height, int factor, T *dst, int out_width, size_t row_begin, size_t row_end) {
+    const int offset = factor / 2;
+    for (size_t out_y = row_begin; out_y < row_end; ++out_y) {
+        const int y = std::min(int(out_y) * factor + offset, height - 1);
+        const T *row = src + size_t(y) * size_t(width);
+        T *out = dst + out_y * size_t(out_width);
+        for (int out_x = 0; out_x < out_width; ++out_x) {
+            out[out_x] = row[std::min(out_x * factor + offset, width - 1)];
+        }
+    }
+}
+
+} // namespace
+
+bool downsample_box(const PixelBuffer &src, int factor, PixelBuffer &out) {
+    if (src.is_empty() || factor < 1) {
+        return false;
+    }
+    const int width = src.get_width();
+    const int height = src.get_height();
+    const int out_width = (width + factor - 1) / factor;
+    const int out_height = (height + factor - 1) / factor;
+
+    src.visit([&](const auto *pixels) {
+        using T = typename std::remove_const<typename std::remove_pointer<decltype(pixels)>::type>::type;
+        T *dst = out.allocate<T>(out_width, out_height);
+        const bool narrow_sum = sizeof(T) <= 2 && factor <= 128;
+        ThreadPool::get_singleton()->parallel_for(size_t(out_height), 16, [&](size_t begin, size_t end) {
+            if constexpr (std::is_floating_point<T>::value) {
+                downsample_rows<T, double>(pixels, width, height, factor, dst, out_width, begin, end);
+            } else if (narrow_sum) {
+                downsample_rows<T, int32_t>(pixels, width, height, factor, dst, out_width, begin, end);
+            } else {
+                downsample_rows<T, int64_t>(pixels, width, height, factor, dst, out_width, begin, end);
+            }
+        });
+    });
+    out.set_rescale(src.get_slope(), src.get_intercept());
+    out.update_range();
+    return true;
+}
+
+bool downsample_sample(const PixelBuffer &src, int factor, PixelBuffer &out) {
+    if (src.is_empty() || factor < 1) {
+        return false;
+    }
+    const int width = src.get_width();
+    const int height = src.get_height();
+    const int out_width = (width + factor - 1) / factor;
+    const int out_height = (height + factor - 1) / factor;
+
+    src.visit([&](const auto *pixels) {
+        using T = typename std::remove_const<typename std::remove_pointer<decltype(pixels)>::type>::type;
+        T *dst = out.allocate<T>(out_width, out_height);
+        ThreadPool::get_singleton()->parallel_for(size_t(out_height), 64, [&](size_t begin, size_t end) {
+            sample_rows(pixels, width, height, factor, dst, out_width, begin, end);
+        });
+    });
+    out.set_rescale(src.get_slope(), src.get_intercept());
+    out.update_range();
+    return true;
+}
+
+} // namespace dicom
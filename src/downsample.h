@@ -0,0 +1,23 @@
+#pragma once
+
+#include "pixel_buffer.h"
+
+namespace dicom {
+
+// Smallest integer factor that brings the longer side of a
+// `width` x `height` image down to `max_size` or less (at least 1)
+int get_downsample_factor(int width, int height, int max_size);
+
+// Box-filter `src` by `factor` in both directions: each output pixel is the
+// mean of a factor x factor block of stored values, rounded for integer
+// types. Edge blocks average the pixels they cover. The output keeps the
+// source type and rescale. Rows are split across the shared thread pool.
+bool downsample_box(const PixelBuffer &src, int factor, PixelBuffer &out);
+
+// Nearest-neighbour decimation by `factor`: each output pixel is the centre
+// pixel of its block. Reads one row in `factor`, so it costs a fraction of
+// a windowing pass; used for the progressive preview, where aliasing does
+// not matter for the moment it is on screen.
+bool downsample_sample(const PixelBuffer &src, int factor, PixelBuffer &out);
+
+} // namespace dicom
@@ -0,0 +1,70 @@
+#include "header_index.h"
+#include "slice_order.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <memory>
+
+namespace dicom {
+
+void read_headers(const std::vector<std::string> &paths, std::vector<HeaderEntry> &entries, size_t &skipped) {
+    const size_t count = paths.size();
+    std::unique_ptr<HeaderEntry[]> parsed(new HeaderEntry[count]);
+    std::unique_ptr<bool[]> valid(new bool[count]());
+    // Header reads are I/O-bound and short; small chunks keep workers busy
+    ThreadPool::get_singleton()->parallel_for(count, 8, [&](size_t begin, size_t end) {
+        std::string error;
+        for (size_t i = begin; i < end; ++i) {
+            parsed[i].path = paths[i];
+            valid[i] = read_dicom_header(paths[i], parsed[i].info, error);
+        }
+    });
+
+    entries.clear();
+    entries.reserve(count);
+    skipped = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (valid[i]) {
+            entries.push_back(std::move(parsed[i]));
+        } else {
+            ++skipped;
+        }
+    }
+}
+
+void sort_headers(std::vector<HeaderEntry> &entries) {
+    // Series first, so each one is a contiguous run
+    std::stable_sort(entries.begin(), entries.end(), [](const HeaderEntry &a, const HeaderEntry &b) {
+        if (a.info.study_instance_uid != b.info.study_instance_uid) {
+            return a.info.study_instance_uid < b.info.study_instance_uid;
+        }
+        return a.info.series_instance_uid < b.info.series_instance_uid;
+    });
+
+    size_t begin = 0;
+    while (begin < entries.size()) {
+        size_t end = begin + 1;
+        while (end < entries.size() && entries[end].info.study_instance_uid == entries[begin].info.study_instance_uid &&
+                entries[end].info.series_instance_uid == entries[begin].info.series_instance_uid) {
+            ++end;
+        }
+
+        std::vector<const SliceInfo *> infos;
+        infos.reserve(end - begin);
+        for (size_t i = begin; i < end; ++i) {
+            infos.push_back(&entries[i].info);
+        }
+        bool by_position = false;
+        const std::vector<size_t> order = order_slices(infos, by_position);
+
+        std::vector<HeaderEntry> ordered;
+        ordered.reserve(order.size());
+        for (size_t index : order) {
+            ordered.push_back(std::move(entries[begin + index]));
+        }
+        std::move(ordered.begin(), ordered.end(), entries.begin() + std::ptrdiff_t(begin));
+        begin = end;
+    }
+}
+
+} // namespace dicom
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "dicom_decoder.h"
+
+#include <string>
+#include <vector>
+
+namespace dicom {
+
+// Header of one file found while indexing
+struct HeaderEntry {
+    std::string path;
+    SliceInfo info;
+};
+
+// Read the headers of `paths` on the shared thread pool. Files that are not
+// DICOM are left out and counted in `skipped`. Entries come back in path
+// order.
+void read_headers(const std::vector<std::string> &paths, std::vector<HeaderEntry> &entries, size_t &skipped);
+
+// Group by study, then series, and order each series with order_slices()
+void sort_headers(std::vector<HeaderEntry> &entries);
+
+} // namespace dicom
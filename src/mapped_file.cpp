@@ -0,0 +1,239 @@
+#include "mapped_file.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#elif defined(__EMSCRIPTEN__)
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define DV_HAVE_MMAP
+#endif
+
+namespace dicom {
+
+#if defined(_WIN32)
+
+static std::wstring to_wide(const std::string &path) {
+    const int length = MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, nullptr, 0);
+    std::wstring wide(length > 0 ? size_t(length) : 0, L'\0');
+    if (length > 0) {
+        MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, &wide[0], length);
+        wide.resize(size_t(length - 1));
+    }
+    return wide;
+}
+
+bool MappedFile::open(const std::string &path, std::string &error) {
+    close();
+    HANDLE file = CreateFileW(to_wide(path).c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        error = "Cannot open " + path;
+        return false;
+    }
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size)) {
+        CloseHandle(file);
+        error = "Cannot get the size of " + path;
+        return false;
+    }
+    opened = true;
+    size = size_t(file_size.QuadPart);
+    if (size == 0) {
+        CloseHandle(file);
+        return true;
+    }
+    HANDLE map = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    // The view keeps the file referenced, so the handle can go now
+    CloseHandle(file);
+    if (!map) {
+        close();
+        error = "Cannot map " + path;
+        return false;
+    }
+    const void *view = MapViewOfFile(map, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        CloseHandle(map);
+        close();
+        error = "Cannot map " + path;
+        return false;
+    }
+    mapping = map;
+    bytes = static_cast<const uint8_t *>(view);
+    mapped = true;
+    return true;
+}
+
+bool MappedFile::open_prefix(const std::string &path, size_t max_bytes, std::string &error) {
+    // Pages are only read when touched
+    (void)max_bytes;
+    return open(path, error);
+}
+
+void MappedFile::close() {
+    if (mapped) {
+        UnmapViewOfFile(bytes);
+        CloseHandle(static_cast<HANDLE>(mapping));
+    }
+    bytes = nullptr;
+    size = 0;
+    mapped = false;
+    opened = false;
+    partial = false;
+    mapping = nullptr;
+}
+
+bool get_file_stat(const std::string &path, uint64_t &mtime, uint64_t &size) {
+    WIN32_FILE_ATTRIBUTE_DATA info;
+    if (!GetFileAttributesExW(to_wide(path).c_str(), GetFileExInfoStandard, &info)) {
+        return false;
+    }
+    // FILETIME counts 100 ns intervals since 1601
+    const uint64_t ticks = (uint64_t(info.ftLastWriteTime.dwHighDateTime) << 32) | info.ftLastWriteTime.dwLowDateTime;
+    const uint64_t epoch_ticks = 116444736000000000ULL;
+    mtime = ticks > epoch_ticks ? (ticks - epoch_ticks) * 100 : 0;
+    size = (uint64_t(info.nFileSizeHigh) << 32) | info.nFileSizeLow;
+    return true;
+}
+
+FILE *open_file(const std::string &path, const char *mode) {
+    return _wfopen(to_wide(path).c_str(), to_wide(mode).c_str());
+}
+
+bool replace_file(const std::string &from, const std::string &to) {
+    return MoveFileExW(to_wide(from).c_str(), to_wide(to).c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+}
+
+bool remove_file(const std::string &path) {
+    return DeleteFileW(to_wide(path).c_str()) != 0;
+}
+
+#else
+
+bool MappedFile::open(const std::string &path, std::string &error) {
+    close();
+#ifdef DV_HAVE_MMAP
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = "Cannot open " + path;
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        ::close(fd);
+        error = "Cannot stat " + path;
+        return false;
+    }
+    opened = true;
+    size = size_t(info.st_size);
+    if (size == 0) {
+        ::close(fd);
+        return true;
+    }
+    void *view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping keeps the file referenced
+    ::close(fd);
+    if (view == MAP_FAILED) {
+        close();
+        error = "Cannot map " + path;
+        return false;
+    }
+    bytes = static_cast<const uint8_t *>(view);
+    mapped = true;
+    return true;
+#else
+    return open_prefix(path, SIZE_MAX, error);
+#endif
+}
+
+bool MappedFile::open_prefix(const std::string &path, size_t max_bytes, std::string &error) {
+#ifdef DV_HAVE_MMAP
+    // Pages are only read when touched
+    (void)max_bytes;
+    return open(path, error);
+#else
+    close();
+    FILE *file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        error = "Cannot open " + path;
+        return false;
+    }
+    std::fseek(file, 0, SEEK_END);
+    const long length = std::ftell(file);
+    std::fseek(file, 0, SEEK_SET);
+    opened = true;
+    const size_t file_size = length > 0 ? size_t(length) : 0;
+    size = file_size < max_bytes ? file_size : max_bytes;
+    partial = size < file_size;
+    if (size > 0) {
+        uint8_t *copy = static_cast<uint8_t *>(std::malloc(size));
+        if (!copy || std::fread(copy, 1, size, file) != size) {
+            std::free(copy);
+            std::fclose(file);
+            close();
+            error = "Cannot read " + path;
+            return false;
+        }
+        bytes = copy;
+    }
+    std::fclose(file);
+    return true;
+#endif
+}
+
+void MappedFile::close() {
+#ifdef DV_HAVE_MMAP
+    if (mapped) {
+        munmap(const_cast<uint8_t *>(bytes), size);
+    }
+#else
+    std::free(const_cast<uint8_t *>(bytes));
+#endif
+    bytes = nullptr;
+    size = 0;
+    mapped = false;
+    opened = false;
+    partial = false;
+    mapping = nullptr;
+}
+
+bool get_file_stat(const std::string &path, uint64_t &mtime, uint64_t &size) {
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) {
+        return false;
+    }
+#if defined(__APPLE__)
+    const struct timespec &modified = info.st_mtimespec;
+#else
+    const struct timespec &modified = info.st_mtim;
+#endif
+    mtime = uint64_t(modified.tv_sec) * 1000000000ULL + uint64_t(modified.tv_nsec);
+    size = uint64_t(info.st_size);
+    return true;
+}
+
+FILE *open_file(const std::string &path, const char *mode) {
+    return std::fopen(path.c_str(), mode);
+}
+
+bool replace_file(const std::string &from, const std::string &to) {
+    return std::rename(from.c_str(), to.c_str()) == 0;
+}
+
+bool remove_file(const std::string &path) {
+    return std::remove(path.c_str()) == 0;
+}
+
+#endif
+
+} // namespace dicom
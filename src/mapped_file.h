@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <utility>
+
+namespace dicom {
+
+// Read-only memory map of a whole file. Move-only; unmapped on destruction.
+// Web builds (no mmap) and empty files fall back to reading into a heap
+// block, so callers can always use data()/get_size(). Callers that only
+// need the start of a file use open_prefix(), which bounds that read.
+class MappedFile {
+public:
+    MappedFile() {}
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    MappedFile(MappedFile &&other) noexcept { swap(other); }
+    MappedFile &operator=(MappedFile &&other) noexcept {
+        if (this != &other) {
+            close();
+            swap(other);
+        }
+        return *this;
+    }
+
+    // Replaces any previous mapping. On failure returns false and fills `error`.
+    bool open(const std::string &path, std::string &error);
+    // Like open(), but builds that read instead of mapping read at most the
+    // first `max_bytes`; is_partial() then tells whether more was left
+    bool open_prefix(const std::string &path, size_t max_bytes, std::string &error);
+    void close();
+
+    bool is_open() const { return bytes != nullptr || (opened && size == 0); }
+    const uint8_t *data() const { return bytes; }
+    size_t get_size() const { return size; }
+    // False when the contents were copied instead of mapped
+    bool is_mapped() const { return mapped; }
+    // Only a prefix of the file was read
+    bool is_partial() const { return partial; }
+
+private:
+    void swap(MappedFile &other) {
+        std::swap(bytes, other.bytes);
+        std::swap(size, other.size);
+        std::swap(mapped, other.mapped);
+        std::swap(opened, other.opened);
+        std::swap(partial, other.partial);
+        std::swap(mapping, other.mapping);
+    }
+
+    const uint8_t *bytes = nullptr;
+    size_t size = 0;
+    bool mapped = false;
+    bool opened = false;
+    bool partial = false;
+    // Windows file mapping handle
+    void *mapping = nullptr;
+};
+
+// Modification time (nanoseconds since the epoch, as fine as the file
+// system records it) and size of a file. Returns false if it does not exist
+// or cannot be stat'ed.
+bool get_file_stat(const std::string &path, uint64_t &mtime, uint64_t &size);
+
+// fopen(), rename() and remove() for UTF-8 paths; the narrow CRT calls
+// would read them in the ANSI code page on Windows. replace_file() renames
+// `from` over an existing `to`.
+FILE *open_file(const std::string &path, const char *mode);
+bool replace_file(const std::string &from, const std::string &to);
+bool remove_file(const std::string &path);
+
+} // namespace dicom
@@ -0,0 +1,97 @@
+#include "mapped_pixels.h"
+#include "mapped_file.h"
+
+#include <cstdint>
+#include <memory>
+
+namespace dicom {
+
+namespace {
+
+// Whether every stored value fits in `bits_stored` bits, i.e. the unused
+// high bits carry no overlay data and signed values are sign-extended
+bool range_fits_stored_bits(const PixelBuffer &pixels, int bits_stored, bool is_signed) {
+    if (bits_stored <= 0 || bits_stored >= int(pixel_format_size(pixels.get_format()) * 8)) {
+        return true;
+    }
+    if (is_signed) {
+        const double limit = double(int64_t(1) << (bits_stored - 1));
+        return pixels.get_min_stored() >= -limit && pixels.get_max_stored() < limit;
+    }
+    return pixels.get_max_stored() < double(int64_t(1) << bits_stored);
+}
+
+template <typename T>
+bool point_at(const uint8_t *src, const SliceInfo &info, const std::shared_ptr<const void> &owner, PixelBuffer &pixels) {
+    if (reinterpret_cast<uintptr_t>(src) % alignof(T) != 0) {
+        return false;
+    }
+    pixels.set_external(reinterpret_cast<const T *>(src), info.columns, info.rows, owner, info.rescale_slope, info.rescale_intercept);
+    return true;
+}
+
+// Shape checks that do not need the file
+bool check_mappable(const SliceInfo &info, std::string &reason) {
+    if (info.rows <= 0 || info.columns <= 0) {
+        reason = "Missing image dimensions";
+        return false;
+    }
+    if (info.photometric_interpretation != "MONOCHROME1" && info.photometric_interpretation != "MONOCHROME2") {
+        reason = "Not a greyscale image";
+        return false;
+    }
+    // The mapping holds little endian samples
+    const uint16_t probe = 1;
+    if (*reinterpret_cast<const uint8_t *>(&probe) != 1) {
+        reason = "Big endian host";
+        return false;
+    }
+    const int bits = info.bits_allocated;
+    if (bits != 8 && bits != 16 && bits != 32) {
+        reason = "Unsupported Bits Allocated";
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+bool map_pixel_data(const std::shared_ptr<const MappedFile> &file, const uint8_t *value, size_t length, const SliceInfo &info,
+        PixelBuffer &pixels, std::string &reason) {
+    pixels.clear();
+    if (!check_mappable(info, reason)) {
+        return false;
+    }
+    const int bits = info.bits_allocated;
+    const size_t bytes = size_t(info.rows) * size_t(info.columns) * size_t(bits / 8);
+    if (!value || length < bytes) {
+        reason = "Pixel Data missing or shorter than one frame";
+        return false;
+    }
+
+    const bool is_signed = info.pixel_representation == 1;
+    bool mapped = false;
+    switch (bits) {
+        case 8:
+            mapped = is_signed ? point_at<int8_t>(value, info, file, pixels) : point_at<uint8_t>(value, info, file, pixels);
+            break;
+        case 16:
+            mapped = is_signed ? point_at<int16_t>(value, info, file, pixels) : point_at<uint16_t>(value, info, file, pixels);
+            break;
+        default:
+            mapped = is_signed ? point_at<int32_t>(value, info, file, pixels) : point_at<uint32_t>(value, info, file, pixels);
+            break;
+    }
+    if (!mapped) {
+        reason = "Pixel Data is not aligned for its sample size";
+        return false;
+    }
+    if (!range_fits_stored_bits(pixels, info.bits_stored, is_signed)) {
+        pixels.clear();
+        reason = "Stored values need masking to Bits Stored";
+        return false;
+    }
+    return true;
+}
+
+} // namespace dicom
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "dicom_decoder.h"
+#include "mapped_file.h"
+
+#include <memory>
+#include <string>
+
+namespace dicom {
+
+// Point `pixels` straight at the Pixel Data of an uncompressed little endian
+// frame through a memory map, without copying. `value` and `length` are the
+// Pixel Data of `file`, which the caller has already mapped and walked;
+// `info` must hold the file's header (rows, columns, bits, pixel
+// representation). The buffer keeps `file` alive. Returns false with
+// `reason` when the frame does not qualify (odd alignment, stored bits that
+// would need masking, ...), leaving `pixels` empty so the caller can copy
+// the samples instead.
+bool map_pixel_data(const std::shared_ptr<const MappedFile> &file, const uint8_t *value, size_t length, const SliceInfo &info,
+        PixelBuffer &pixels, std::string &reason);
+
+} // namespace dicom
@@ -0,0 +1,237 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace dicom {
+
+// Native storage type of a decoded image. Pixels are kept at the width the
+// source used instead of being widened, so a 16-bit CT slice costs 2 bytes
+// per pixel rather than 8.
+enum PixelFormat {
+    PIXEL_FORMAT_NONE,
+    PIXEL_FORMAT_U8,
+    PIXEL_FORMAT_S8,
+    PIXEL_FORMAT_U16,
+    PIXEL_FORMAT_S16,
+    PIXEL_FORMAT_U32,
+    PIXEL_FORMAT_S32,
+    PIXEL_FORMAT_F32,
+};
+
+template <typename T>
+struct PixelFormatOf;
+
+template <> struct PixelFormatOf<uint8_t> { static constexpr PixelFormat value = PIXEL_FORMAT_U8; };
+template <> struct PixelFormatOf<int8_t> { static constexpr PixelFormat value = PIXEL_FORMAT_S8; };
+template <> struct PixelFormatOf<uint16_t> { static constexpr PixelFormat value = PIXEL_FORMAT_U16; };
+template <> struct PixelFormatOf<int16_t> { static constexpr PixelFormat value = PIXEL_FORMAT_S16; };
+template <> struct PixelFormatOf<uint32_t> { static constexpr PixelFormat value = PIXEL_FORMAT_U32; };
+template <> struct PixelFormatOf<int32_t> { static constexpr PixelFormat value = PIXEL_FORMAT_S32; };
+template <> struct PixelFormatOf<float> { static constexpr PixelFormat value = PIXEL_FORMAT_F32; };
+
+inline size_t pixel_format_size(PixelFormat format) {
+    switch (format) {
+        case PIXEL_FORMAT_U8:
+        case PIXEL_FORMAT_S8:
+            return 1;
+        case PIXEL_FORMAT_U16:
+        case PIXEL_FORMAT_S16:
+            return 2;
+        case PIXEL_FORMAT_U32:
+        case PIXEL_FORMAT_S32:
+        case PIXEL_FORMAT_F32:
+            return 4;
+        default:
+            return 0;
+    }
+}
+
+// Invoke `fn` with `data` cast to the `const T *` matching `format`.
+// Nothing is called for PIXEL_FORMAT_NONE.
+template <typename Fn>
+void visit_pixels(PixelFormat format, const void *data, Fn &&fn) {
+    switch (format) {
+        case PIXEL_FORMAT_U8:
+            fn(static_cast<const uint8_t *>(data));
+            break;
+        case PIXEL_FORMAT_S8:
+            fn(static_cast<const int8_t *>(data));
+            break;
+        case PIXEL_FORMAT_U16:
+            fn(static_cast<const uint16_t *>(data));
+            break;
+        case PIXEL_FORMAT_S16:
+            fn(static_cast<const int16_t *>(data));
+            break;
+        case PIXEL_FORMAT_U32:
+            fn(static_cast<const uint32_t *>(data));
+            break;
+        case PIXEL_FORMAT_S32:
+            fn(static_cast<const int32_t *>(data));
+            break;
+        case PIXEL_FORMAT_F32:
+            fn(static_cast<const float *>(data));
+            break;
+        default:
+            break;
+    }
+}
+
+// A single-channel image stored in its native representation. Stored values
+// map to modality values (e.g. Hounsfield units) through
+// value * slope + intercept, which consumers fold into their own transforms
+// instead of materialising a rescaled copy.
+class PixelBuffer {
+public:
+    PixelBuffer() {}
+
+    // Copy `width * height` pixels from `src` and record their stored range
+    template <typename T>
+    void assign(const T *src, int p_width, int p_height, double p_slope = 1.0, double p_intercept = 0.0) {
+        T *dst = allocate<T>(p_width, p_height);
+        const size_t count = get_pixel_count();
+        if (count == 0) {
+            return;
+        }
+        std::memcpy(dst, src, count * sizeof(T));
+        set_rescale(p_slope, p_intercept);
+        update_range();
+    }
+
+    // Size the buffer for `width * height` pixels of type T and return the
+    // storage for the caller to fill. Call update_range() once filled.
+    template <typename T>
+    T *allocate(int p_width, int p_height) {
+        format = PixelFormatOf<T>::value;
+        width = p_width > 0 ? p_width : 0;
+        height = p_height > 0 ? p_height : 0;
+        slope = 1.0;
+        intercept = 0.0;
+        min_value = max_value = 0.0;
+        release_external();
+        storage.resize(get_pixel_count() * sizeof(T));
+        return reinterpret_cast<T *>(storage.data());
+    }
+
+    // Use pixels that live elsewhere (e.g. in a memory-mapped file) without
+    // copying them. `owner` keeps that memory alive for as long as this
+    // buffer, or any copy of it, refers to it. `src` must be aligned for T.
+    template <typename T>
+    void set_external(const T *src, int p_width, int p_height, std::shared_ptr<const void> owner,
+            double p_slope = 1.0, double p_intercept = 0.0) {
+        std::vector<uint8_t>().swap(storage);
+        format = PixelFormatOf<T>::value;
+        width = p_width > 0 ? p_width : 0;
+        height = p_height > 0 ? p_height : 0;
+        external = reinterpret_cast<const uint8_t *>(src);
+        external_owner = std::move(owner);
+        set_rescale(p_slope, p_intercept);
+        update_range();
+    }
+    bool is_external() const { return external != nullptr; }
+
+    void clear() {
+        format = PIXEL_FORMAT_NONE;
+        width = height = 0;
+        slope = 1.0;
+        intercept = 0.0;
+        min_value = max_value = 0.0;
+        release_external();
+        std::vector<uint8_t>().swap(storage);
+    }
+
+    // Recompute the stored min/max after the pixels were written in place
+    void update_range() {
+        visit([this](const auto *pixels) { compute_range(pixels); });
+    }
+
+    // Override the recorded stored range, e.g. so a downsampled preview
+    // gets the same default window as its source
+    void set_stored_range(double p_min, double p_max) {
+        min_value = p_min;
+        max_value = p_max;
+    }
+
+    void set_rescale(double p_slope, double p_intercept) {
+        slope = p_slope != 0.0 ? p_slope : 1.0;
+        intercept = p_intercept;
+    }
+
+    bool is_empty() const { return format == PIXEL_FORMAT_NONE || get_pixel_count() == 0; }
+    PixelFormat get_format() const { return format; }
+    int get_width() const { return width; }
+    int get_height() const { return height; }
+    size_t get_pixel_count() const { return size_t(width) * size_t(height); }
+    size_t get_byte_size() const { return external ? get_pixel_count() * pixel_format_size(format) : storage.size(); }
+
+    double get_slope() const { return slope; }
+    double get_intercept() const { return intercept; }
+
+    // Range of the stored (not rescaled) values
+    double get_min_stored() const { return min_value; }
+    double get_max_stored() const { return max_value; }
+
+    // Range of the modality values, i.e. after slope/intercept
+    double get_min_value() const {
+        return slope >= 0.0 ? min_value * slope + intercept : max_value * slope + intercept;
+    }
+    double get_max_value() const {
+        return slope >= 0.0 ? max_value * slope + intercept : min_value * slope + intercept;
+    }
+
+    const void *get_data() const { return external ? external : storage.data(); }
+
+    template <typename T>
+    const T *get_data_as() const {
+        return format == PixelFormatOf<T>::value ? reinterpret_cast<const T *>(get_data()) : nullptr;
+    }
+
+    // Invoke `fn` with a typed `const T *` to the pixels. Nothing is called
+    // for an empty buffer.
+    template <typename Fn>
+    void visit(Fn &&fn) const {
+        visit_pixels(format, get_data(), fn);
+    }
+
+private:
+    void release_external() {
+        external = nullptr;
+        external_owner.reset();
+    }
+
+    template <typename T>
+    void compute_range(const T *pixels) {
+        const size_t count = get_pixel_count();
+        if (count == 0) {
+            min_value = max_value = 0.0;
+            return;
+        }
+        T lo = pixels[0];
+        T hi = pixels[0];
+        for (size_t i = 1; i < count; ++i) {
+            const T v = pixels[i];
+            lo = v < lo ? v : lo;
+            hi = v > hi ? v : hi;
+        }
+        min_value = static_cast<double>(lo);
+        max_value = static_cast<double>(hi);
+    }
+
+    PixelFormat format = PIXEL_FORMAT_NONE;
+    int width = 0;
+    int height = 0;
+    double slope = 1.0;
+    double intercept = 0.0;
+    double min_value = 0.0;
+    double max_value = 0.0;
+    std::vector<uint8_t> storage;
+    // Set instead of `storage` for pixels borrowed from `external_owner`
+    const uint8_t *external = nullptr;
+    std::shared_ptr<const void> external_owner;
+};
+
+} // namespace dicom
@@ -0,0 +1,349 @@
+#include "projection.h"
+#include "thread_pool.h"
+#include "window_simd.h"
+
+#include <cstring>
+#include <type_traits>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define DV_SIMD_X86
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define DV_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+namespace dicom {
+
+// The vector kernels select exactly like the scalar templates:
+// dst = src > dst ? src : dst (and < for min). For floats that means a NaN
+// in either operand keeps dst, which is what _mm_max_ps(src, dst) does and
+// why NEON uses compare + select instead of vmaxq_f32.
+
+#ifdef DV_SIMD_X86
+
+template <bool Max>
+static void reduce_s16_sse2(int16_t *dst, const int16_t *src, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dst + i));
+        __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        d = Max ? _mm_max_epi16(d, s) : _mm_min_epi16(d, s);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), d);
+    }
+    if (Max) {
+        max_span<int16_t>(dst + i, src + i, count - i);
+    } else {
+        min_span<int16_t>(dst + i, src + i, count - i);
+    }
+}
+
+// SSE2 has no unsigned 16-bit max/min; flipping the sign bit maps unsigned
+// order onto signed order
+template <bool Max>
+static void reduce_u16_sse2(uint16_t *dst, const uint16_t *src, size_t count) {
+    const __m128i bias = _mm_set1_epi16(int16_t(0x8000));
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i d = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(dst + i)), bias);
+        __m128i s = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i)), bias);
+        d = Max ? _mm_max_epi16(d, s) : _mm_min_epi16(d, s);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_xor_si128(d, bias));
+    }
+    if (Max) {
+        max_span<uint16_t>(dst + i, src + i, count - i);
+    } else {
+        min_span<uint16_t>(dst + i, src + i, count - i);
+    }
+}
+
+template <bool Max>
+static void reduce_f32_sse2(float *dst, const float *src, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 d = _mm_loadu_ps(dst + i);
+        __m128 s = _mm_loadu_ps(src + i);
+        d = Max ? _mm_max_ps(s, d) : _mm_min_ps(s, d);
+        _mm_storeu_ps(dst + i, d);
+    }
+    if (Max) {
+        max_span<float>(dst + i, src + i, count - i);
+    } else {
+        min_span<float>(dst + i, src + i, count - i);
+    }
+}
+
+#define DV_REDUCE_S16 reduce_s16_sse2
+#define DV_REDUCE_U16 reduce_u16_sse2
+#define DV_REDUCE_F32 reduce_f32_sse2
+
+#endif // DV_SIMD_X86
+
+#ifdef DV_SIMD_NEON
+
+template <bool Max>
+static void reduce_s16_neon(int16_t *dst, const int16_t *src, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        int16x8_t d = vld1q_s16(dst + i);
+        int16x8_t s = vld1q_s16(src + i);
+        vst1q_s16(dst + i, Max ? vmaxq_s16(d, s) : vminq_s16(d, s));
+    }
+    if (Max) {
+        max_span<int16_t>(dst + i, src + i, count - i);
+    } else {
+        min_span<int16_t>(dst + i, src + i, count - i);
+    }
+}
+
+template <bool Max>
+static void reduce_u16_neon(uint16_t *dst, const uint16_t *src, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        uint16x8_t d = vld1q_u16(dst + i);
+        uint16x8_t s = vld1q_u16(src + i);
+        vst1q_u16(dst + i, Max ? vmaxq_u16(d, s) : vminq_u16(d, s));
+    }
+    if (Max) {
+        max_span<uint16_t>(dst + i, src + i, count - i);
+    } else {
+        min_span<uint16_t>(dst + i, src + i, count - i);
+    }
+}
+
+template <bool Max>
+static void reduce_f32_neon(float *dst, const float *src, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        float32x4_t d = vld1q_f32(dst + i);
+        float32x4_t s = vld1q_f32(src + i);
+        uint32x4_t take = Max ? vcgtq_f32(s, d) : vcltq_f32(s, d);
+        vst1q_f32(dst + i, vbslq_f32(take, s, d));
+    }
+    if (Max) {
+        max_span<float>(dst + i, src + i, count - i);
+    } else {
+        min_span<float>(dst + i, src + i, count - i);
+    }
+}
+
+#define DV_REDUCE_S16 reduce_s16_neon
+#define DV_REDUCE_U16 reduce_u16_neon
+#define DV_REDUCE_F32 reduce_f32_neon
+
+#endif // DV_SIMD_NEON
+
+#ifdef DV_REDUCE_S16
+
+void max_span(int16_t *dst, const int16_t *src, size_t count) {
+    if (get_simd_level() != SIMD_NONE) {
+        DV_REDUCE_S16<true>(dst, src, count);
+    } else {
+        max_span<int16_t>(dst, src, count);
+    }
+}
+
+void max_span(uint16_t *dst, const uint16_t *src, size_t count) {
+    if (get_simd_level() != SIMD_NONE) {
+        DV_REDUCE_U16<true>(dst, src, count);
+    } else {
+        max_span<uint16_t>(dst, src, count);
+    }
+}
+
+void max_span(float *dst, const float *src, size_t count) {
+    if (get_simd_level() != SIMD_NONE) {
+        DV_REDUCE_F32<true>(dst, src, count);
+    } else {
+        max_span<float>(dst, src, count);
+    }
+}
+
+void min_span(int16_t *dst, const int16_t *src, size_t count) {
+    if (get_simd_level() != SIMD_NONE) {
+        DV_REDUCE_S16<false>(dst, src, count);
+    } else {
+        min_span<int16_t>(dst, src, count);
+    }
+}
+
+void min_span(uint16_t *dst, const uint16_t *src, size_t count) {
+    if (get_simd_level() != SIMD_NONE) {
+        DV_REDUCE_U16<false>(dst, src, count);
+    } else {
+        min_span<uint16_t>(dst, src, count);
+    }
+}
+
+void min_span(float *dst, const float *src, size_t count) {
+    if (get_simd_level() != SIMD_NONE) {
+        DV_REDUCE_F32<false>(dst, src, count);
+    } else {
+        min_span<float>(dst, src, count);
+    }
+}
+
+#else
+
+void max_span(int16_t *dst, const int16_t *src, size_t count) { max_span<int16_t>(dst, src, count); }
+void max_span(uint16_t *dst, const uint16_t *src, size_t count) { max_span<uint16_t>(dst, src, count); }
+void max_span(float *dst, const float *src, size_t count) { max_span<float>(dst, src, count); }
+void min_span(int16_t *dst, const int16_t *src, size_t count) { min_span<int16_t>(dst, src, count); }
+void min_span(uint16_t *dst, const uint16_t *src, size_t count) { min_span<uint16_t>(dst, src, count); }
+void min_span(float *dst, const float *src, size_t count) { min_span<float>(dst, src, count); }
+
+#endif // DV_REDUCE_S16
+
+void get_slab_range(const Volume &volume, VolumeAxis axis, int index, int thickness, int &first, int &last) {
+    const int count = get_plane_count(volume, axis);
+    if (thickness < 1) {
+        thickness = 1;
+    }
+    first = index - (thickness - 1) / 2;
+    last = first + thickness - 1;
+    first = first < 0 ? 0 : first;
+    last = last >= count ? count - 1 : last;
+}
+
+namespace {
+
+// Slab geometry shared by the row workers. For axial and coronal slabs each
+// plane contributes one contiguous row per output row, so rows are reduced
+// with the span kernels; a sagittal slab reduces a short run of columns
+// within each row instead.
+struct Slab {
+    const Volume *volume = nullptr;
+    VolumeAxis axis = VOLUME_AXIS_AXIAL;
+    int first = 0;
+    int last = 0;
+    bool head_up = false;
+    size_t out_width = 0;
+
+    template <typename T>
+    const T *row(size_t out_row, int plane) const {
+        const size_t width = size_t(volume->width);
+        if (axis == VOLUME_AXIS_AXIAL) {
+            return static_cast<const T *>(volume->get_slice_data(plane)) + out_row * width;
+        }
+        const size_t z = head_up ? size_t(volume->depth) - 1 - out_row : out_row;
+        return static_cast<const T *>(volume->get_slice_data(int(z))) + size_t(plane) * width;
+    }
+
+    template <typename T>
+    const T *sagittal_slice(size_t out_row) const {
+        const size_t z = head_up ? size_t(volume->depth) - 1 - out_row : out_row;
+        return static_cast<const T *>(volume->get_slice_data(int(z)));
+    }
+};
+
+template <typename T>
+void project_extreme_rows(const Slab &slab, bool max, T *dst, size_t row_begin, size_t row_end) {
+    const size_t width = size_t(slab.volume->width);
+    const size_t height = size_t(slab.volume->height);
+    for (size_t row = row_begin; row < row_end; ++row) {
+        T *out = dst + row * slab.out_width;
+        if (slab.axis == VOLUME_AXIS_SAGITTAL) {
+            const T *slice = slab.sagittal_slice<T>(row);
+            for (size_t y = 0; y < height; ++y) {
+                const T *run = slice + y * width;
+                T value = run[slab.first];
+                for (int x = slab.first + 1; x <= slab.last; ++x) {
+                    if (max) {
+                        value = run[x] > value ? run[x] : value;
+                    } else {
+                        value = run[x] < value ? run[x] : value;
+                    }
+                }
+                out[y] = value;
+            }
+            continue;
+        }
+        // The output row stays in L1 while the slab's rows stream past it
+        std::memcpy(out, slab.row<T>(row, slab.first), width * sizeof(T));
+        for (int plane = slab.first + 1; plane <= slab.last; ++plane) {
+            if (max) {
+                max_span(out, slab.row<T>(row, plane), width);
+            } else {
+                min_span(out, slab.row<T>(row, plane), width);
+            }
+        }
+    }
+}
+
+template <typename T>
+void project_average_rows(const Slab &slab, float *dst, size_t row_begin, size_t row_end) {
+    const size_t width = size_t(slab.volume->width);
+    const size_t height = size_t(slab.volume->height);
+    const float inverse_count = 1.0f / float(slab.last - slab.first + 1);
+    for (size_t row = row_begin; row < row_end; ++row) {
+        float *out = dst + row * slab.out_width;
+        if (slab.axis == VOLUME_AXIS_SAGITTAL) {
+            const T *slice = slab.sagittal_slice<T>(row);
+            for (size_t y = 0; y < height; ++y) {
+                const T *run = slice + y * width;
+                float sum = 0.0f;
+                for (int x = slab.first; x <= slab.last; ++x) {
+                    sum += static_cast<float>(run[x]);
+                }
+                out[y] = sum * inverse_count;
+            }
+            continue;
+        }
+        const T *src = slab.row<T>(row, slab.first);
+        for (size_t i = 0; i < width; ++i) {
+            out[i] = static_cast<float>(src[i]);
+        }
+        for (int plane = slab.first + 1; plane <= slab.last; ++plane) {
+            src = slab.row<T>(row, plane);
+            for (size_t i = 0; i < width; ++i) {
+                out[i] += static_cast<float>(src[i]);
+            }
+        }
+        for (size_t i = 0; i < width; ++i) {
+            out[i] *= inverse_count;
+        }
+    }
+}
+
+} // namespace
+
+bool project_slab(const Volume &volume, VolumeAxis axis, int index, int thickness, ProjectionMode mode, DecodedSlice &out) {
+    if (volume.format == PIXEL_FORMAT_NONE || index < 0 || index >= get_plane_count(volume, axis)) {
+        return false;
+    }
+    if (mode != PROJECTION_MAX && mode != PROJECTION_MIN && mode != PROJECTION_AVERAGE) {
+        return false;
+    }
+    Slab slab;
+    slab.volume = &volume;
+    slab.axis = axis;
+    slab.head_up = volume.is_superior_last();
+    get_slab_range(volume, axis, index, thickness, slab.first, slab.last);
+
+    make_plane_info(volume, axis, out.info);
+    out.path = axis == VOLUME_AXIS_AXIAL && slab.first == slab.last ? volume.slice_paths[slab.first] : std::string();
+    slab.out_width = size_t(out.info.columns);
+    const int out_height = out.info.rows;
+
+    ThreadPool *pool = ThreadPool::get_singleton();
+    volume.visit([&](const auto *voxels) {
+        using T = typename std::remove_const<typename std::remove_pointer<decltype(voxels)>::type>::type;
+        if (mode == PROJECTION_AVERAGE) {
+            float *dst = out.pixels.allocate<float>(out.info.columns, out_height);
+            pool->parallel_for(size_t(out_height), 16, [&](size_t begin, size_t end) {
+                project_average_rows<T>(slab, dst, begin, end);
+            });
+        } else {
+            T *dst = out.pixels.allocate<T>(out.info.columns, out_height);
+            const bool max = mode == PROJECTION_MAX;
+            pool->parallel_for(size_t(out_height), 16, [&](size_t begin, size_t end) {
+                project_extreme_rows<T>(slab, max, dst, begin, end);
+            });
+        }
+    });
+    out.pixels.set_rescale(volume.slope, volume.intercept);
+    out.pixels.update_range();
+    return true;
+}
+
+} // namespace dicom
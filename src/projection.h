@@ -0,0 +1,51 @@
+#pragma once
+
+#include "volume.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace dicom {
+
+enum ProjectionMode {
+    PROJECTION_MAX, // MIP
+    PROJECTION_MIN, // MinIP
+    PROJECTION_AVERAGE, // AvgIP
+};
+
+// Elementwise dst[i] = max(dst[i], src[i]) and min(...). The 16-bit and
+// float overloads use SSE2/NEON when a vector level is active; results
+// match the scalar template bit for bit, NaN included.
+void max_span(int16_t *dst, const int16_t *src, size_t count);
+void max_span(uint16_t *dst, const uint16_t *src, size_t count);
+void max_span(float *dst, const float *src, size_t count);
+void min_span(int16_t *dst, const int16_t *src, size_t count);
+void min_span(uint16_t *dst, const uint16_t *src, size_t count);
+void min_span(float *dst, const float *src, size_t count);
+
+template <typename T>
+inline void max_span(T *dst, const T *src, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        dst[i] = src[i] > dst[i] ? src[i] : dst[i];
+    }
+}
+
+template <typename T>
+inline void min_span(T *dst, const T *src, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        dst[i] = src[i] < dst[i] ? src[i] : dst[i];
+    }
+}
+
+// Planes [first, last] along `axis` for a slab of `thickness` planes centred
+// on `index`, clipped to the volume
+void get_slab_range(const Volume &volume, VolumeAxis axis, int index, int thickness, int &first, int &last);
+
+// Project a slab of `thickness` planes centred on plane `index` along
+// `axis` into `out`, laid out like extract_plane(). MIP/MinIP keep the
+// volume's native type; AvgIP produces float stored values with the
+// volume's slope/intercept. Returns false for an unknown `mode` or an
+// out-of-range plane.
+bool project_slab(const Volume &volume, VolumeAxis axis, int index, int thickness, ProjectionMode mode, DecodedSlice &out);
+
+} // namespace dicom
@@ -1,6 +1,13 @@
 #include "register_types.h"
+#include "case_library_index.h"
+#include "case_package.h"
+#include "dicom_cine_player.h"
+#include "dicom_indexer.h"
 #include "dicom_viewer.h"
+#include "dicom_volume.h"
 #include "radiology_case.h"  // ADD THIS LINE
+#include "slice_cache.h"
+#include "thread_pool.h"
 
 #include <gdextension_interface.h>
 #include <godot_cpp/core/defs.hpp>
@@ -15,6 +22,11 @@ void initialize_gdextension_types(ModuleInitializationLevel p_level)
         return;
     }
     GDREGISTER_CLASS(DicomViewer);
+    GDREGISTER_CLASS(DicomCinePlayer);
+    GDREGISTER_CLASS(DicomVolume);
+    GDREGISTER_CLASS(DicomIndexer);
+    GDREGISTER_CLASS(CaseLibraryIndex);
+    GDREGISTER_CLASS(CasePackage);
     GDREGISTER_CLASS(RadiologyCase);  // ADD THIS LINE
 }
 
@@ -22,6 +34,10 @@ void uninitialize_gdextension_types(ModuleInitializationLevel p_level) {
     if (p_level != MODULE_INITIALIZATION_LEVEL_SCENE) {
         return;
     }
+    // Join worker threads before the library is unloaded; queued jobs may
+    // still use the slice cache, so it goes last
+    dicom::ThreadPool::release_singleton();
+    dicom::SliceCache::release_singleton();
 }
 
 extern "C" {
@@ -0,0 +1,167 @@
+#include "slice_cache.h"
+#include "mapped_file.h"
+
+#include <iterator>
+
+namespace dicom {
+
+static std::mutex singleton_mutex;
+static SliceCache *singleton = nullptr;
+
+SliceCache *SliceCache::get_singleton() {
+    std::lock_guard<std::mutex> lock(singleton_mutex);
+    if (!singleton) {
+        singleton = new SliceCache();
+    }
+    return singleton;
+}
+
+void SliceCache::release_singleton() {
+    std::lock_guard<std::mutex> lock(singleton_mutex);
+    delete singleton;
+    singleton = nullptr;
+}
+
+std::string SliceCache::make_key(const std::string &path) {
+    uint64_t mtime = 0, size = 0;
+    if (!get_file_stat(path, mtime, size)) {
+        return path;
+    }
+    return path + "|" + std::to_string(size) + "|" + std::to_string(mtime);
+}
+
+size_t SliceCache::get_slice_cost(const DecodedSlice &slice) {
+    return sizeof(DecodedSlice) + slice.pixels.get_byte_size();
+}
+
+void SliceCache::set_budget(size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    budget = bytes;
+    evict_to(budget);
+}
+
+size_t SliceCache::get_budget() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return budget;
+}
+
+std::shared_ptr<const DecodedSlice> SliceCache::get(const std::string &key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = index.find(key);
+    if (found == index.end()) {
+        stats.misses++;
+        return nullptr;
+    }
+    stats.hits++;
+    entries.splice(entries.begin(), entries, found->second);
+    return found->second->slice;
+}
+
+bool SliceCache::contains(const std::string &key) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return index.find(key) != index.end();
+}
+
+void SliceCache::put(const std::string &key, const std::shared_ptr<const DecodedSlice> &slice) {
+    if (!slice) {
+        return;
+    }
+    const size_t cost = get_slice_cost(*slice);
+    const std::string version = slice->path.empty() ? std::string() : make_key(slice->path);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!version.empty()) {
+        auto known = versions.find(slice->path);
+        if (known != versions.end() && known->second.key != version) {
+            erase_path(slice->path);
+        }
+    }
+    auto found = index.find(key);
+    if (found != index.end()) {
+        remove_entry(found->second);
+    }
+    // A slice larger than the whole budget is not worth evicting everything for
+    if (cost > budget) {
+        stats.entries = entries.size();
+        return;
+    }
+    evict_to(budget - cost);
+
+    entries.push_front(Entry{ key, slice, cost });
+    index[key] = entries.begin();
+    if (!version.empty()) {
+        Version &known = versions[slice->path];
+        known.key = version;
+        known.slices++;
+    }
+    stats.bytes += cost;
+    stats.entries = entries.size();
+}
+
+void SliceCache::erase(const std::string &key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = index.find(key);
+    if (found == index.end()) {
+        return;
+    }
+    remove_entry(found->second);
+    stats.entries = entries.size();
+}
+
+void SliceCache::erase_path(const std::string &path) {
+    for (auto it = entries.begin(); it != entries.end();) {
+        if (it->slice->path == path) {
+            it = remove_entry(it);
+        } else {
+            ++it;
+        }
+    }
+    stats.entries = entries.size();
+}
+
+void SliceCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+    index.clear();
+    versions.clear();
+    stats.bytes = 0;
+    stats.entries = 0;
+}
+
+bool SliceCache::begin_decode(const std::string &key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (index.find(key) != index.end()) {
+        return false;
+    }
+    return decoding.insert(key).second;
+}
+
+void SliceCache::end_decode(const std::string &key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    decoding.erase(key);
+}
+
+SliceCache::Stats SliceCache::get_stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
+
+void SliceCache::evict_to(size_t bytes) {
+    while (stats.bytes > bytes && !entries.empty()) {
+        remove_entry(std::prev(entries.end()));
+        stats.evictions++;
+    }
+    stats.entries = entries.size();
+}
+
+std::list<SliceCache::Entry>::iterator SliceCache::remove_entry(std::list<Entry>::iterator it) {
+    auto known = it->slice->path.empty() ? versions.end() : versions.find(it->slice->path);
+    if (known != versions.end() && --known->second.slices == 0) {
+        versions.erase(known);
+    }
+    stats.bytes -= it->cost;
+    index.erase(it->key);
+    return entries.erase(it);
+}
+
+} // namespace dicom
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "dicom_decoder.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace dicom {
+
+// Process-wide LRU of decoded slices keyed by make_key(), bounded by the
+// bytes of pixel data it holds. Thread-safe. Entries are shared
+// pointers, so evicting a slice that is still on screen does not free it.
+class SliceCache {
+public:
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+        size_t bytes = 0;
+        size_t entries = 0;
+    };
+
+    static SliceCache *get_singleton();
+    static void release_singleton();
+
+    // Key for the file at absolute path `path`: the path plus its size and
+    // modification time, so a file rewritten in place misses. This is the
+    // identity check on a hit: uncompressed slices point into a map of the
+    // file, and one that was truncated since would fault when read.
+    static std::string make_key(const std::string &path);
+
+    void set_budget(size_t bytes);
+    size_t get_budget() const;
+
+    // Returns nullptr on a miss
+    std::shared_ptr<const DecodedSlice> get(const std::string &key);
+    // Like get() but without counting a hit/miss or touching the LRU order
+    bool contains(const std::string &key) const;
+    // Also drops every entry decoded from an earlier version of the
+    // slice's file, so their mappings are released
+    void put(const std::string &key, const std::shared_ptr<const DecodedSlice> &slice);
+    void erase(const std::string &key);
+    void clear();
+
+    // Claim a key for decoding so concurrent prefetch jobs do not decode the
+    // same file twice. Returns false if another job already holds it.
+    bool begin_decode(const std::string &key);
+    void end_decode(const std::string &key);
+
+    Stats get_stats() const;
+
+    static size_t get_slice_cost(const DecodedSlice &slice);
+
+private:
+    struct Entry {
+        std::string key;
+        std::shared_ptr<const DecodedSlice> slice;
+        size_t cost = 0;
+    };
+
+    struct Version {
+        std::string key;
+        // Cached slices of this version; the record goes with the last one
+        size_t slices = 0;
+    };
+
+    void evict_to(size_t bytes);
+    void erase_path(const std::string &path);
+    // Drop one entry and its share of `versions`; returns the next entry
+    std::list<Entry>::iterator remove_entry(std::list<Entry>::iterator it);
+
+    mutable std::mutex mutex;
+    // Front is most recently used
+    std::list<Entry> entries;
+    std::unordered_map<std::string, std::list<Entry>::iterator> index;
+    // make_key() of each file with cached slices, by path
+    std::unordered_map<std::string, Version> versions;
+    std::unordered_set<std::string> decoding;
+    size_t budget = size_t(512) * 1024 * 1024;
+    Stats stats;
+};
+
+} // namespace dicom
@@ -0,0 +1,72 @@
+#include "slice_order.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace dicom {
+
+bool get_slice_normal(const SliceInfo &info, double normal[3]) {
+    if (!info.has_image_orientation) {
+        return false;
+    }
+    const double *row = info.image_orientation;
+    const double *col = info.image_orientation + 3;
+    const double cross[3] = {
+        row[1] * col[2] - row[2] * col[1],
+        row[2] * col[0] - row[0] * col[2],
+        row[0] * col[1] - row[1] * col[0],
+    };
+    const double length = std::sqrt(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]);
+    if (length <= 1e-6) {
+        return false;
+    }
+    for (int i = 0; i < 3; ++i) {
+        normal[i] = cross[i] / length;
+    }
+    return true;
+}
+
+namespace {
+
+struct SliceOrder {
+    double position = 0.0;
+    int instance_number = 0;
+    size_t index = 0;
+};
+
+} // namespace
+
+std::vector<size_t> order_slices(const std::vector<const SliceInfo *> &infos, bool &by_position) {
+    by_position = !infos.empty();
+    for (const SliceInfo *info : infos) {
+        by_position = by_position && info->has_image_position;
+    }
+    // Slices of one series share an orientation; the default normal keeps
+    // positioned slices without one in z order
+    double normal[3] = { 0.0, 0.0, 1.0 };
+    if (!infos.empty()) {
+        get_slice_normal(*infos[0], normal);
+    }
+
+    std::vector<SliceOrder> order(infos.size());
+    for (size_t i = 0; i < infos.size(); ++i) {
+        const double *p = infos[i]->image_position;
+        order[i].position = by_position ? p[0] * normal[0] + p[1] * normal[1] + p[2] * normal[2] : 0.0;
+        order[i].instance_number = infos[i]->instance_number;
+        order[i].index = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [](const SliceOrder &a, const SliceOrder &b) {
+        if (a.position != b.position) {
+            return a.position < b.position;
+        }
+        return a.instance_number < b.instance_number;
+    });
+
+    std::vector<size_t> indices(order.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        indices[i] = order[i].index;
+    }
+    return indices;
+}
+
+} // namespace dicom
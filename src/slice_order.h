@@ -0,0 +1,22 @@
+#pragma once
+
+#include "dicom_decoder.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace dicom {
+
+// Unit normal of the slice plane (row x column direction cosines). Leaves
+// `normal` untouched and returns false without a usable Image Orientation
+// (Patient).
+bool get_slice_normal(const SliceInfo &info, double normal[3]);
+
+// Stacking order of the slices of one series, as indices into `infos`.
+// Slices are ordered by position along the first slice's normal when every
+// slice has Image Position (Patient), else by Instance Number, which also
+// breaks ties. `by_position` reports which order was used. Both the indexer
+// and volume building use this, so a series lists and stacks alike.
+std::vector<size_t> order_slices(const std::vector<const SliceInfo *> &infos, bool &by_position);
+
+} // namespace dicom
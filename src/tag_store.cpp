@@ -0,0 +1,129 @@
+#include "tag_store.h"
+
+#include <algorithm>
+
+namespace dicom {
+
+namespace {
+
+const uint32_t SPECIFIC_CHARACTER_SET = 0x00080005;
+
+// VRs whose values are in the Specific Character Set; the others are ASCII
+bool uses_character_set(const char *vr) {
+    static const char *VRS[] = { "SH", "LO", "ST", "LT", "UT", "PN", "UC" };
+    for (const char *candidate : VRS) {
+        if (vr && vr[0] == candidate[0] && vr[1] == candidate[1]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool is_ascii(const char *text, size_t length) {
+    for (size_t i = 0; i < length; ++i) {
+        if (uint8_t(text[i]) >= 0x80) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool is_valid_utf8(const char *text, size_t length) {
+    size_t i = 0;
+    while (i < length) {
+        const uint8_t lead = uint8_t(text[i]);
+        size_t extra = 0;
+        if (lead < 0x80) {
+            extra = 0;
+        } else if (lead >= 0xC2 && lead <= 0xDF) {
+            extra = 1;
+        } else if (lead >= 0xE0 && lead <= 0xEF) {
+            extra = 2;
+        } else if (lead >= 0xF0 && lead <= 0xF4) {
+            extra = 3;
+        } else {
+            return false;
+        }
+        if (i + extra >= length) {
+            return false;
+        }
+        for (size_t k = 1; k <= extra; ++k) {
+            if ((uint8_t(text[i + k]) & 0xC0) != 0x80) {
+                return false;
+            }
+        }
+        i += extra + 1;
+    }
+    return true;
+}
+
+// Latin-1 bytes are the first 256 code points
+void append_latin1(const char *text, size_t length, std::string &out) {
+    for (size_t i = 0; i < length; ++i) {
+        const uint8_t byte = uint8_t(text[i]);
+        if (byte < 0x80) {
+            out += char(byte);
+        } else {
+            out += char(0xC0 | (byte >> 6));
+            out += char(0x80 | (byte & 0x3F));
+        }
+    }
+}
+
+} // namespace
+
+void TagStore::add(uint16_t group, uint16_t element, const char *vr, const std::string &value) {
+    // Text values are padded to even length with spaces (or NUL for UIDs)
+    size_t length = value.size();
+    while (length > 0 && (value[length - 1] == ' ' || value[length - 1] == '\0')) {
+        --length;
+    }
+    Entry entry;
+    entry.tag = make_tag(group, element);
+    entry.vr[0] = vr && vr[0] ? vr[0] : '?';
+    entry.vr[1] = vr && vr[0] && vr[1] ? vr[1] : '?';
+    entry.offset = uint32_t(values.size());
+
+    if (entry.tag == SPECIFIC_CHARACTER_SET) {
+        // Only the first value names the set used without code extensions
+        std::string name = value.substr(0, std::min(length, value.find('\\')));
+        while (!name.empty() && name.back() == ' ') {
+            name.pop_back();
+        }
+        if (name == "ISO_IR 100" || name == "ISO 2022 IR 100") {
+            character_set = CHARSET_LATIN1;
+        } else if (name == "ISO_IR 192") {
+            character_set = CHARSET_UTF8;
+        } else {
+            character_set = CHARSET_DEFAULT;
+        }
+    }
+
+    const char *text = value.data();
+    if (uses_character_set(entry.vr) && character_set != CHARSET_UTF8 && !is_ascii(text, length) &&
+            (character_set == CHARSET_LATIN1 || !is_valid_utf8(text, length))) {
+        append_latin1(text, length, values);
+    } else {
+        values.append(value, 0, length);
+    }
+    entry.length = uint32_t(values.size() - entry.offset);
+    entries.push_back(entry);
+}
+
+void TagStore::finish() {
+    std::stable_sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) { return a.tag < b.tag; });
+    values.shrink_to_fit();
+    entries.shrink_to_fit();
+}
+
+const TagStore::Entry *TagStore::find(uint32_t tag) const {
+    auto found = std::lower_bound(entries.begin(), entries.end(), tag, [](const Entry &entry, uint32_t key) { return entry.tag < key; });
+    return found != entries.end() && found->tag == tag ? &*found : nullptr;
+}
+
+std::string TagStore::get_string(uint32_t tag) const {
+    const Entry *entry = find(tag);
+    return entry ? get_value(*entry) : std::string();
+}
+
+} // namespace dicom
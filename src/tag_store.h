@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace dicom {
+
+// The header elements of a file as read during decode: one small record per
+// element plus a single buffer holding every value as DICOM text
+// (backslash-separated for multiple values). Values are converted only when
+// asked for. Binary (OB/OW/...) and sequence elements are not kept.
+//
+// Text is stored as UTF-8. Specific Character Set (0008,0005) precedes the
+// elements it governs, so add() converts SH, LO, ST, LT, UT, PN and UC
+// values as they arrive: ISO_IR 100 (Latin-1) is converted, ISO_IR 192 is
+// already UTF-8. Bytes in any other set that are not valid UTF-8 are read
+// as Latin-1 so they still form a valid string.
+class TagStore {
+public:
+    struct Entry {
+        uint32_t tag;
+        char vr[2];
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    static uint32_t make_tag(uint16_t group, uint16_t element) { return (uint32_t(group) << 16) | element; }
+
+    void add(uint16_t group, uint16_t element, const char *vr, const std::string &value);
+    // Sort by tag once all elements are added; find() needs it
+    void finish();
+
+    size_t get_count() const { return entries.size(); }
+    const Entry &get_entry(size_t index) const { return entries[index]; }
+    // nullptr if the element was not in the file
+    const Entry *find(uint32_t tag) const;
+    std::string get_value(const Entry &entry) const { return values.substr(entry.offset, entry.length); }
+    // Empty if absent
+    std::string get_string(uint32_t tag) const;
+    size_t get_byte_size() const { return values.size() + entries.size() * sizeof(Entry); }
+
+private:
+    enum CharacterSet {
+        CHARSET_DEFAULT,
+        CHARSET_LATIN1,
+        CHARSET_UTF8,
+    };
+
+    std::vector<Entry> entries;
+    std::string values;
+    CharacterSet character_set = CHARSET_DEFAULT;
+};
+
+} // namespace dicom
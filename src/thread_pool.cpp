@@ -0,0 +1,149 @@
+#include "thread_pool.h"
+
+#include <atomic>
+#include <memory>
+
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+#define DV_NO_THREADS
+#endif
+
+namespace dicom {
+
+static std::mutex singleton_mutex;
+static ThreadPool *singleton = nullptr;
+
+ThreadPool::ThreadPool(int thread_count) {
+#ifdef DV_NO_THREADS
+    thread_count = 0;
+#else
+    if (thread_count < 0) {
+        const int hardware = int(std::thread::hardware_concurrency());
+        thread_count = hardware > 1 ? hardware - 1 : 0;
+    }
+#endif
+    workers.reserve(size_t(thread_count));
+    for (int i = 0; i < thread_count; ++i) {
+        workers.emplace_back(&ThreadPool::worker_main, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    condition.notify_all();
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+}
+
+ThreadPool *ThreadPool::get_singleton() {
+    std::lock_guard<std::mutex> lock(singleton_mutex);
+    if (!singleton) {
+        singleton = new ThreadPool();
+    }
+    return singleton;
+}
+
+void ThreadPool::release_singleton() {
+    std::lock_guard<std::mutex> lock(singleton_mutex);
+    delete singleton;
+    singleton = nullptr;
+}
+
+void ThreadPool::worker_main() {
+    for (;;) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [this] { return stopping || !jobs.empty(); });
+            // Drain queued jobs before exiting so waiters are never stranded
+            if (jobs.empty()) {
+                return;
+            }
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+        job();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> job) {
+    if (workers.empty()) {
+        job();
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back(std::move(job));
+    }
+    condition.notify_one();
+}
+
+namespace {
+
+// Shared between the caller and helper jobs of one parallel_for(). Helpers
+// that start after all chunks were claimed find nothing to do, so the state
+// only needs to outlive them, not the call.
+struct ParallelState {
+    const std::function<void(size_t, size_t)> *fn = nullptr;
+    size_t count = 0;
+    size_t chunk_size = 0;
+    size_t chunk_count = 0;
+    std::atomic<size_t> next_chunk{ 0 };
+    std::atomic<size_t> finished_chunks{ 0 };
+    std::mutex mutex;
+    std::condition_variable condition;
+
+    void run_chunks() {
+        size_t finished = 0;
+        for (;;) {
+            const size_t chunk = next_chunk.fetch_add(1);
+            if (chunk >= chunk_count) {
+                break;
+            }
+            const size_t begin = chunk * chunk_size;
+            const size_t end = begin + chunk_size < count ? begin + chunk_size : count;
+            (*fn)(begin, end);
+            ++finished;
+        }
+        if (finished > 0 && finished_chunks.fetch_add(finished) + finished == chunk_count) {
+            std::lock_guard<std::mutex> lock(mutex);
+            condition.notify_all();
+        }
+    }
+};
+
+} // namespace
+
+void ThreadPool::parallel_for(size_t count, size_t chunk_size, const std::function<void(size_t, size_t)> &fn) {
+    if (count == 0) {
+        return;
+    }
+    if (chunk_size == 0) {
+        chunk_size = 1;
+    }
+    const size_t chunk_count = (count + chunk_size - 1) / chunk_size;
+    if (chunk_count == 1 || workers.empty()) {
+        fn(0, count);
+        return;
+    }
+
+    std::shared_ptr<ParallelState> state = std::make_shared<ParallelState>();
+    state->fn = &fn;
+    state->count = count;
+    state->chunk_size = chunk_size;
+    state->chunk_count = chunk_count;
+
+    const size_t helpers = chunk_count - 1 < workers.size() ? chunk_count - 1 : workers.size();
+    for (size_t i = 0; i < helpers; ++i) {
+        submit([state] { state->run_chunks(); });
+    }
+    state->run_chunks();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->condition.wait(lock, [&state] { return state->finished_chunks.load() == state->chunk_count; });
+}
+
+} // namespace dicom
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dicom {
+
+// Fixed set of worker threads shared by the extension. Builds without thread
+// support (web "nothreads") get zero workers and run everything inline.
+class ThreadPool {
+public:
+    // `thread_count` < 0 sizes the pool to hardware_concurrency() - 1, leaving
+    // a core for the thread that calls parallel_for()
+    explicit ThreadPool(int thread_count = -1);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // Process-wide pool, created on first use
+    static ThreadPool *get_singleton();
+    // Join the workers of the process-wide pool (called on extension unload)
+    static void release_singleton();
+
+    int get_thread_count() const { return int(workers.size()); }
+
+    // Queue `job` to run on a worker. Runs inline when the pool has no threads.
+    void submit(std::function<void()> job);
+
+    // Run fn(begin, end) over [0, count) in chunks of `chunk_size`. The
+    // calling thread works through chunks as well, so this is safe to call
+    // from inside a pool job, and returns once every chunk has finished.
+    void parallel_for(size_t count, size_t chunk_size, const std::function<void(size_t, size_t)> &fn);
+
+private:
+    void worker_main();
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> jobs;
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool stopping = false;
+};
+
+} // namespace dicom
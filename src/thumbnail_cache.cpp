@@ -0,0 +1,98 @@
+#include "thumbnail_cache.h"
+#include "mapped_file.h"
+
+#include <godot_cpp/classes/dir_access.hpp>
+#include <godot_cpp/classes/file_access.hpp>
+#include <godot_cpp/variant/packed_byte_array.hpp>
+#include <godot_cpp/variant/packed_string_array.hpp>
+
+#include <atomic>
+
+using namespace godot;
+
+static const char *THUMBNAIL_DIR = "user://thumbnails";
+// "DTHB"
+static const uint32_t THUMBNAIL_MAGIC = 0x42485444;
+static const uint32_t THUMBNAIL_VERSION = 1;
+// Distinguishes the temporary files of concurrent stores
+static std::atomic<uint64_t> temp_counter{ 0 };
+
+void ThumbnailCache::ensure_directory() {
+    DirAccess::make_dir_recursive_absolute(THUMBNAIL_DIR);
+}
+
+bool ThumbnailCache::get_entry(const String &absolute_path, int max_size, String &key, String &cache_path) {
+    // Nanosecond stamps, as for the slice cache: a source rewritten within
+    // the same second at the same size still gets a new key
+    uint64_t modified = 0, length = 0;
+    if (!dicom::get_file_stat(absolute_path.utf8().get_data(), modified, length)) {
+        return false;
+    }
+    key = absolute_path + "|" + String::num_uint64(modified) + "|" + String::num_uint64(length) + "|" + String::num_int64(max_size);
+    cache_path = String(THUMBNAIL_DIR).path_join(key.md5_text() + ".thumb");
+    return true;
+}
+
+Ref<Image> ThumbnailCache::load(const String &absolute_path, int max_size) {
+    String key, cache_path;
+    if (!get_entry(absolute_path, max_size, key, cache_path) || !FileAccess::file_exists(cache_path)) {
+        return Ref<Image>();
+    }
+    Ref<FileAccess> file = FileAccess::open(cache_path, FileAccess::READ);
+    if (file.is_null() || file->get_32() != THUMBNAIL_MAGIC || file->get_32() != THUMBNAIL_VERSION) {
+        return Ref<Image>();
+    }
+    // The full key guards against hash collisions
+    if (file->get_pascal_string() != key) {
+        return Ref<Image>();
+    }
+    const int width = (int)file->get_32();
+    const int height = (int)file->get_32();
+    const uint64_t bytes = uint64_t(width) * uint64_t(height);
+    if (width <= 0 || height <= 0 || file->get_length() - file->get_position() != bytes) {
+        return Ref<Image>();
+    }
+    PackedByteArray data = file->get_buffer((int64_t)bytes);
+    if ((uint64_t)data.size() != bytes) {
+        return Ref<Image>();
+    }
+    return Image::create_from_data(width, height, false, Image::FORMAT_L8, data);
+}
+
+void ThumbnailCache::store(const String &absolute_path, int max_size, const Ref<Image> &image) {
+    if (image.is_null() || image->get_format() != Image::FORMAT_L8) {
+        return;
+    }
+    String key, cache_path;
+    if (!get_entry(absolute_path, max_size, key, cache_path)) {
+        return;
+    }
+    // Written under a unique temporary name and renamed into place, so a
+    // reader never sees a partial file and concurrent stores of the same
+    // thumbnail do not interleave
+    const String temp_path = cache_path + "." + String::num_uint64(temp_counter.fetch_add(1)) + ".tmp";
+    Ref<FileAccess> file = FileAccess::open(temp_path, FileAccess::WRITE);
+    if (file.is_null()) {
+        return;
+    }
+    file->store_32(THUMBNAIL_MAGIC);
+    file->store_32(THUMBNAIL_VERSION);
+    file->store_pascal_string(key);
+    file->store_32((uint32_t)image->get_width());
+    file->store_32((uint32_t)image->get_height());
+    file->store_buffer(image->get_data());
+    const bool written = file->get_error() == OK;
+    file->close();
+    if (!written || DirAccess::rename_absolute(temp_path, cache_path) != OK) {
+        DirAccess::remove_absolute(temp_path);
+    }
+}
+
+void ThumbnailCache::clear() {
+    PackedStringArray files = DirAccess::get_files_at(THUMBNAIL_DIR);
+    for (int i = 0; i < files.size(); ++i) {
+        if (files[i].ends_with(".thumb") || files[i].ends_with(".tmp")) {
+            DirAccess::remove_absolute(String(THUMBNAIL_DIR).path_join(files[i]));
+        }
+    }
+}
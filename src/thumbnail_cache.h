@@ -0,0 +1,27 @@
+#pragma once
+
+#include <godot_cpp/classes/image.hpp>
+#include <godot_cpp/variant/string.hpp>
+
+namespace godot {
+
+// Windowed L8 thumbnails kept on disk under user://thumbnails, one file per
+// source file and size. Entries are keyed by the absolute path, modification
+// time and size of the source, so an edited or replaced file misses. Safe to
+// use from worker threads.
+class ThumbnailCache {
+public:
+    // Create the cache directory; call once before using it from workers
+    static void ensure_directory();
+
+    // Returns a null Ref on a miss
+    static Ref<Image> load(const String &absolute_path, int max_size);
+    static void store(const String &absolute_path, int max_size, const Ref<Image> &image);
+    static void clear();
+
+private:
+    // Key and cache file for a source file; false if it cannot be stat'ed
+    static bool get_entry(const String &absolute_path, int max_size, String &key, String &cache_path);
+};
+
+}
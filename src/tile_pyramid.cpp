@@ -0,0 +1,80 @@
+#include "tile_pyramid.h"
+#include "downsample.h"
+
+#include <utility>
+
+namespace dicom {
+
+void TilePyramid::build(const std::shared_ptr<const DecodedSlice> &p_source) {
+    clear();
+    if (!p_source || p_source->pixels.is_empty()) {
+        return;
+    }
+    source = p_source;
+    const PixelBuffer &base = source->pixels;
+    for (;;) {
+        const PixelBuffer &previous = levels.empty() ? base : levels.back();
+        if (previous.get_width() <= TILE_SIZE && previous.get_height() <= TILE_SIZE) {
+            break;
+        }
+        PixelBuffer level;
+        downsample_box(previous, 2, level);
+        level.set_stored_range(base.get_min_stored(), base.get_max_stored());
+        levels.push_back(std::move(level));
+    }
+}
+
+void TilePyramid::clear() {
+    source.reset();
+    levels.clear();
+}
+
+const PixelBuffer &TilePyramid::get_level(int level) const {
+    return level <= 0 ? source->pixels : levels[size_t(level - 1)];
+}
+
+int TilePyramid::get_tiles_x(int level) const {
+    return (get_level(level).get_width() + TILE_SIZE - 1) / TILE_SIZE;
+}
+
+int TilePyramid::get_tiles_y(int level) const {
+    return (get_level(level).get_height() + TILE_SIZE - 1) / TILE_SIZE;
+}
+
+int TilePyramid::choose_level(double screen_scale) const {
+    int level = 0;
+    const int last = get_level_count() - 1;
+    // Level n pixels cover 2^n level-0 pixels
+    while (level < last && screen_scale * double(2 << level) <= 1.0) {
+        ++level;
+    }
+    return level;
+}
+
+void TilePyramid::get_tile_rect(int level, int tile_x, int tile_y, int &x, int &y, int &width, int &height) const {
+    const PixelBuffer &pixels = get_level(level);
+    x = tile_x * TILE_SIZE;
+    y = tile_y * TILE_SIZE;
+    width = x + TILE_SIZE < pixels.get_width() ? TILE_SIZE : pixels.get_width() - x;
+    height = y + TILE_SIZE < pixels.get_height() ? TILE_SIZE : pixels.get_height() - y;
+}
+
+void TilePyramid::window_tile(const WindowEngine &engine, int level, int tile_x, int tile_y, uint8_t *dst) const {
+    const PixelBuffer &pixels = get_level(level);
+    int x, y, width, height;
+    get_tile_rect(level, tile_x, tile_y, x, y, width, height);
+    const size_t stride = size_t(pixels.get_width());
+    for (int row = 0; row < height; ++row) {
+        engine.apply(pixels, size_t(y + row) * stride + size_t(x), size_t(width), dst + size_t(row) * size_t(width));
+    }
+}
+
+size_t TilePyramid::get_byte_size() const {
+    size_t bytes = 0;
+    for (const PixelBuffer &level : levels) {
+        bytes += level.get_byte_size();
+    }
+    return bytes;
+}
+
+} // namespace dicom
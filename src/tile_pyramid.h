@@ -0,0 +1,51 @@
+#pragma once
+
+#include "dicom_decoder.h"
+#include "pixel_buffer.h"
+#include "window_level.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace dicom {
+
+// Multi-resolution copy of a slice for drawing huge images tile by tile.
+// Level 0 is the slice itself (not copied); each further level halves both
+// sides with a box filter, down to the first level that fits in one tile.
+// Every level records the source's stored range, so a WindowEngine
+// configured on level 0 can window tiles of any level.
+class TilePyramid {
+public:
+    static constexpr int TILE_SIZE = 512;
+
+    void build(const std::shared_ptr<const DecodedSlice> &p_source);
+    void clear();
+
+    bool is_empty() const { return !source; }
+    const std::shared_ptr<const DecodedSlice> &get_source() const { return source; }
+    int get_level_count() const { return source ? int(levels.size()) + 1 : 0; }
+    const PixelBuffer &get_level(int level) const;
+    int get_tiles_x(int level) const;
+    int get_tiles_y(int level) const;
+
+    // Coarsest level whose pixels still cover at most one screen pixel when
+    // level-0 pixels are drawn `screen_scale` screen pixels wide
+    int choose_level(double screen_scale) const;
+
+    // Pixel rectangle of a tile within its level
+    void get_tile_rect(int level, int tile_x, int tile_y, int &x, int &y, int &width, int &height) const;
+
+    // Window one tile into `dst` (tile width x tile height, tightly packed)
+    void window_tile(const WindowEngine &engine, int level, int tile_x, int tile_y, uint8_t *dst) const;
+
+    // Bytes held by levels 1 and up
+    size_t get_byte_size() const;
+
+private:
+    std::shared_ptr<const DecodedSlice> source;
+    // Levels 1..n
+    std::vector<PixelBuffer> levels;
+};
+
+} // namespace dicom
@@ -0,0 +1,84 @@
+#include "transcode_cache.h"
+#include "decoded_file.h"
+#include "dicom_viewer.h"
+#include "mapped_file.h"
+
+#include <godot_cpp/classes/dir_access.hpp>
+#include <godot_cpp/classes/file_access.hpp>
+#include <godot_cpp/variant/packed_string_array.hpp>
+
+using namespace godot;
+
+static const char *TRANSCODE_DIR = "user://decoded_slices";
+
+void TranscodeCache::ensure_directory() {
+    DirAccess::make_dir_recursive_absolute(DicomViewer::globalize_path(TRANSCODE_DIR));
+}
+
+bool TranscodeCache::is_cacheable(const dicom::SliceInfo &info) {
+    // Implicit and explicit VR little endian pixels are mapped from the
+    // source itself
+    const std::string &syntax = info.transfer_syntax;
+    return info.frame_count <= 1 && !syntax.empty() && syntax != "1.2.840.10008.1.2" && syntax != "1.2.840.10008.1.2.1";
+}
+
+bool TranscodeCache::has(const String &absolute_path) {
+    dicom::DecodedFileSource source, recorded;
+    std::string error;
+    return get_source(absolute_path, source) &&
+            dicom::read_decoded_source(get_cache_path(absolute_path).utf8().get_data(), recorded, error) && recorded == source;
+}
+
+String TranscodeCache::get_cache_path(const String &absolute_path) {
+    // The copy records the full path, which guards against hash collisions
+    return DicomViewer::globalize_path(TRANSCODE_DIR).path_join(absolute_path.md5_text() + ".slice");
+}
+
+bool TranscodeCache::get_source(const String &absolute_path, dicom::DecodedFileSource &source) {
+    source.path = absolute_path.utf8().get_data();
+    return dicom::get_file_stat(source.path, source.mtime, source.size);
+}
+
+std::shared_ptr<dicom::DecodedSlice> TranscodeCache::load(const String &absolute_path) {
+    const String cache_path = get_cache_path(absolute_path);
+    dicom::DecodedFileSource source;
+    if (!FileAccess::file_exists(cache_path) || !get_source(absolute_path, source)) {
+        return nullptr;
+    }
+    std::shared_ptr<dicom::DecodedSlice> slice = std::make_shared<dicom::DecodedSlice>();
+    std::string error;
+    if (!dicom::map_decoded_file(cache_path.utf8().get_data(), source, *slice, error)) {
+        return nullptr;
+    }
+    slice->path = source.path;
+    return slice;
+}
+
+bool TranscodeCache::store(const dicom::DecodedSlice &slice, String &error) {
+    if (!is_cacheable(slice.info)) {
+        error = "Not a single-frame compressed DICOM file";
+        return false;
+    }
+    const String absolute_path = String::utf8(slice.path.c_str());
+    dicom::DecodedFileSource source;
+    if (!get_source(absolute_path, source)) {
+        error = "Cannot stat " + absolute_path;
+        return false;
+    }
+    std::string write_error;
+    if (!dicom::write_decoded_file(get_cache_path(absolute_path).utf8().get_data(), slice, source, write_error)) {
+        error = String::utf8(write_error.c_str());
+        return false;
+    }
+    return true;
+}
+
+void TranscodeCache::clear() {
+    const String directory = DicomViewer::globalize_path(TRANSCODE_DIR);
+    PackedStringArray files = DirAccess::get_files_at(directory);
+    for (int i = 0; i < files.size(); ++i) {
+        if (files[i].ends_with(".slice")) {
+            DirAccess::remove_absolute(directory.path_join(files[i]));
+        }
+    }
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "dicom_decoder.h"
+
+#include <godot_cpp/variant/string.hpp>
+
+#include <memory>
+
+namespace godot {
+
+// Decoded copies of compressed DICOM files under user://decoded_slices, one
+// file per source path, written once (e.g. on import) so later loads map the
+// pixels instead of decoding again. Each copy records the size and
+// modification time of its source and is ignored once the source changes, so
+// a lookup costs a stat and no header parse. Only single-frame files with a
+// compressed transfer syntax are kept; uncompressed ones are already mapped
+// in place. Safe to use from worker threads.
+class TranscodeCache {
+public:
+    // Create the cache directory; call once before storing from workers
+    static void ensure_directory();
+
+    // Whether a file with this header is worth keeping decoded
+    static bool is_cacheable(const dicom::SliceInfo &info);
+    // Whether the file at `absolute_path` has an up to date decoded copy
+    static bool has(const String &absolute_path);
+
+    // The decoded copy of the file at `absolute_path`, or null on a miss
+    static std::shared_ptr<dicom::DecodedSlice> load(const String &absolute_path);
+    // Keep `slice`, decoded from the file at `slice.path`
+    static bool store(const dicom::DecodedSlice &slice, String &error);
+    static void clear();
+
+private:
+    static String get_cache_path(const String &absolute_path);
+    // False if the source cannot be stat'ed
+    static bool get_source(const String &absolute_path, dicom::DecodedFileSource &source);
+};
+
+}
@@ -0,0 +1,291 @@
+#include "volume.h"
+#include "slice_cache.h"
+#include "slice_order.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <type_traits>
+
+namespace dicom {
+
+bool Volume::copy_slice(int z, PixelBuffer &out) const {
+    if (z < 0 || z >= depth || format == PIXEL_FORMAT_NONE) {
+        return false;
+    }
+    visit_pixels(format, get_slice_data(z), [&](const auto *src) {
+        out.assign(src, width, height, slope, intercept);
+    });
+    return true;
+}
+
+namespace {
+
+double dot(const double *a, const double *b) {
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+// Image Orientation (Patient) is written with limited precision, so the
+// direction cosines are compared with a tolerance
+bool same_orientation(const SliceInfo &a, const SliceInfo &b) {
+    if (a.has_image_orientation != b.has_image_orientation) {
+        return false;
+    }
+    for (int i = 0; a.has_image_orientation && i < 6; ++i) {
+        if (std::fabs(a.image_orientation[i] - b.image_orientation[i]) > 1e-3) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Copy one slice into the volume, converting to float modality values when
+// the volume could not keep the series' native representation
+void stack_slice(const PixelBuffer &pixels, bool to_modality_float, void *dst) {
+    const size_t count = pixels.get_pixel_count();
+    if (!to_modality_float) {
+        std::memcpy(dst, pixels.get_data(), pixels.get_byte_size());
+        return;
+    }
+    const double slope = pixels.get_slope();
+    const double intercept = pixels.get_intercept();
+    float *out = static_cast<float *>(dst);
+    pixels.visit([&](const auto *src) {
+        for (size_t i = 0; i < count; ++i) {
+            out[i] = static_cast<float>(static_cast<double>(src[i]) * slope + intercept);
+        }
+    });
+}
+
+// Output rows of a reformatted plane are slices, so each row is read from a
+// single slice: one contiguous run for a coronal plane, one strided column
+// for a sagittal plane. Neither touches more than one slice per row.
+template <typename T>
+void reformat_rows(const Volume &volume, VolumeAxis axis, int index, bool head_up, T *dst, size_t row_begin, size_t row_end) {
+    const size_t width = size_t(volume.width);
+    const size_t height = size_t(volume.height);
+    const size_t out_width = axis == VOLUME_AXIS_CORONAL ? width : height;
+    for (size_t row = row_begin; row < row_end; ++row) {
+        const size_t z = head_up ? size_t(volume.depth) - 1 - row : row;
+        const T *slice = static_cast<const T *>(volume.get_slice_data(int(z)));
+        T *out = dst + row * out_width;
+        if (axis == VOLUME_AXIS_CORONAL) {
+            std::memcpy(out, slice + size_t(index) * width, width * sizeof(T));
+        } else {
+            const T *src = slice + index;
+            for (size_t y = 0; y < height; ++y) {
+                out[y] = src[y * width];
+            }
+        }
+    }
+}
+
+} // namespace
+
+int get_plane_count(const Volume &volume, VolumeAxis axis) {
+    switch (axis) {
+        case VOLUME_AXIS_AXIAL:
+            return volume.depth;
+        case VOLUME_AXIS_CORONAL:
+            return volume.height;
+        case VOLUME_AXIS_SAGITTAL:
+            return volume.width;
+        default:
+            return 0;
+    }
+}
+
+void make_plane_info(const Volume &volume, VolumeAxis axis, SliceInfo &info) {
+    info = volume.info;
+    info.rescale_slope = volume.slope;
+    info.rescale_intercept = volume.intercept;
+    info.has_pixel_spacing = true;
+    if (axis == VOLUME_AXIS_AXIAL) {
+        info.columns = volume.width;
+        info.rows = volume.height;
+        info.pixel_spacing_col = volume.spacing[0];
+        info.pixel_spacing_row = volume.spacing[1];
+    } else {
+        info.columns = axis == VOLUME_AXIS_CORONAL ? volume.width : volume.height;
+        info.rows = volume.depth;
+        info.pixel_spacing_col = axis == VOLUME_AXIS_CORONAL ? volume.spacing[0] : volume.spacing[1];
+        info.pixel_spacing_row = volume.spacing[2];
+        info.has_image_position = false;
+        info.has_image_orientation = false;
+    }
+    info.pixel_aspect_ratio = info.pixel_spacing_col > 0.0
+            ? static_cast<float>(info.pixel_spacing_row / info.pixel_spacing_col)
+            : 1.0f;
+}
+
+bool extract_plane(const Volume &volume, VolumeAxis axis, int index, DecodedSlice &out) {
+    if (volume.format == PIXEL_FORMAT_NONE || index < 0 || index >= get_plane_count(volume, axis)) {
+        return false;
+    }
+    make_plane_info(volume, axis, out.info);
+
+    if (axis == VOLUME_AXIS_AXIAL) {
+        out.path = volume.slice_paths[index];
+        volume.copy_slice(index, out.pixels);
+        return true;
+    }
+
+    out.path.clear();
+    const bool head_up = volume.is_superior_last();
+    volume.visit([&](const auto *voxels) {
+        using T = typename std::remove_const<typename std::remove_pointer<decltype(voxels)>::type>::type;
+        T *dst = out.pixels.allocate<T>(out.info.columns, out.info.rows);
+        // Bands of rows on the pool; the caller takes bands too, so a
+        // queue busy with decode jobs does not stall the plane
+        ThreadPool::get_singleton()->parallel_for(size_t(out.info.rows), 32, [&](size_t begin, size_t end) {
+            reformat_rows(volume, axis, index, head_up, dst, begin, end);
+        });
+    });
+    out.pixels.set_rescale(volume.slope, volume.intercept);
+    out.pixels.update_range();
+    return true;
+}
+
+bool build_volume(std::vector<std::shared_ptr<const DecodedSlice>> &slices, Volume &volume, std::string &error) {
+    volume = Volume();
+    if (slices.empty()) {
+        error = "No slices to stack";
+        return false;
+    }
+
+    const PixelBuffer &first_pixels = slices[0]->pixels;
+    const SliceInfo &first_info = slices[0]->info;
+    const int width = first_pixels.get_width();
+    const int height = first_pixels.get_height();
+    bool uniform = true;
+    for (const std::shared_ptr<const DecodedSlice> &slice : slices) {
+        const PixelBuffer &pixels = slice->pixels;
+        if (pixels.is_empty() || pixels.get_width() != width || pixels.get_height() != height) {
+            error = "Slice size differs from the rest of the series: " + slice->path;
+            return false;
+        }
+        // Stacking a second series or a differently oriented stack would
+        // interleave unrelated planes
+        if (slice->info.series_instance_uid != first_info.series_instance_uid) {
+            error = "Slice belongs to another series (" + slice->info.series_instance_uid + "): " + slice->path;
+            return false;
+        }
+        if (!same_orientation(slice->info, first_info)) {
+            error = "Slice orientation differs from the rest of the series: " + slice->path;
+            return false;
+        }
+        uniform = uniform && pixels.get_format() == first_pixels.get_format() &&
+                pixels.get_slope() == first_pixels.get_slope() &&
+                pixels.get_intercept() == first_pixels.get_intercept();
+    }
+
+    // Directions from the shared orientation
+    if (get_slice_normal(first_info, volume.slice_direction)) {
+        for (int i = 0; i < 3; ++i) {
+            volume.row_direction[i] = first_info.image_orientation[i];
+            volume.column_direction[i] = first_info.image_orientation[3 + i];
+        }
+    }
+
+    std::vector<const SliceInfo *> infos;
+    infos.reserve(slices.size());
+    for (const std::shared_ptr<const DecodedSlice> &slice : slices) {
+        infos.push_back(&slice->info);
+    }
+    bool by_position = false;
+    const std::vector<size_t> order = order_slices(infos, by_position);
+    std::vector<std::shared_ptr<const DecodedSlice>> sorted(slices.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        sorted[i] = std::move(slices[order[i]]);
+    }
+    slices.swap(sorted);
+
+    const SliceInfo &base = slices[0]->info;
+    volume.info = base;
+    volume.sorted_by_position = by_position;
+    volume.width = width;
+    volume.height = height;
+    volume.depth = (int)slices.size();
+    volume.spacing[0] = base.pixel_spacing_col;
+    volume.spacing[1] = base.pixel_spacing_row;
+    for (int i = 0; i < 3; ++i) {
+        volume.origin[i] = base.image_position[i];
+    }
+
+    // Mean distance between slice centres; header values only when the
+    // positions are missing or coincide
+    double slice_spacing = 0.0;
+    if (by_position && slices.size() > 1) {
+        const double first = dot(slices.front()->info.image_position, volume.slice_direction);
+        const double last = dot(slices.back()->info.image_position, volume.slice_direction);
+        slice_spacing = (last - first) / double(slices.size() - 1);
+    }
+    if (!(slice_spacing > 1e-6)) {
+        slice_spacing = base.spacing_between_slices > 0.0 ? base.spacing_between_slices : base.slice_thickness;
+    }
+    volume.spacing[2] = slice_spacing > 0.0 ? slice_spacing : 1.0;
+
+    volume.format = uniform ? first_pixels.get_format() : PIXEL_FORMAT_F32;
+    volume.slope = uniform ? first_pixels.get_slope() : 1.0;
+    volume.intercept = uniform ? first_pixels.get_intercept() : 0.0;
+    for (size_t z = 0; z < slices.size(); ++z) {
+        const PixelBuffer &pixels = slices[z]->pixels;
+        const double lo = uniform ? pixels.get_min_stored() : pixels.get_min_value();
+        const double hi = uniform ? pixels.get_max_stored() : pixels.get_max_value();
+        volume.min_stored = z == 0 || lo < volume.min_stored ? lo : volume.min_stored;
+        volume.max_stored = z == 0 || hi > volume.max_stored ? hi : volume.max_stored;
+    }
+
+    const size_t slice_bytes = volume.get_slice_byte_size();
+    if (!volume.storage.allocate(slice_bytes * slices.size())) {
+        error = "Out of memory allocating a " + std::to_string(slice_bytes * slices.size()) + " byte volume";
+        volume = Volume();
+        return false;
+    }
+
+    volume.slice_paths.resize(slices.size());
+    uint8_t *base_ptr = volume.storage.data();
+    const bool to_modality_float = !uniform;
+    ThreadPool::get_singleton()->parallel_for(slices.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t z = begin; z < end; ++z) {
+            stack_slice(slices[z]->pixels, to_modality_float, base_ptr + z * slice_bytes);
+            volume.slice_paths[z] = slices[z]->path;
+            // Keep peak memory near one copy of the series
+            slices[z].reset();
+        }
+    });
+    return true;
+}
+
+bool load_volume(const std::vector<std::string> &paths, Volume &volume, std::string &error) {
+    std::vector<std::shared_ptr<const DecodedSlice>> slices(paths.size());
+    std::vector<std::string> errors(paths.size());
+    SliceCache *cache = SliceCache::get_singleton();
+
+    ThreadPool::get_singleton()->parallel_for(paths.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            std::shared_ptr<const DecodedSlice> cached = cache->get(SliceCache::make_key(paths[i]));
+            if (cached) {
+                slices[i] = cached;
+                continue;
+            }
+            // Not put into the cache: a whole series would only evict the
+            // slices the viewer is scrolling through
+            std::shared_ptr<DecodedSlice> decoded = std::make_shared<DecodedSlice>();
+            if (decode_dicom_file(paths[i], *decoded, errors[i])) {
+                slices[i] = decoded;
+            }
+        }
+    });
+
+    for (size_t i = 0; i < paths.size(); ++i) {
+        if (!slices[i]) {
+            error = paths[i] + ": " + errors[i];
+            return false;
+        }
+    }
+    return build_volume(slices, volume, error);
+}
+
+} // namespace dicom
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "aligned_buffer.h"
+#include "dicom_decoder.h"
+#include "pixel_buffer.h"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace dicom {
+
+// A series stacked into one contiguous, cache-line aligned block of
+// `width * height * depth` pixels, slice after slice in patient order.
+// Immutable once built, so viewers and worker jobs can share it.
+struct Volume {
+    PixelFormat format = PIXEL_FORMAT_NONE;
+    int width = 0;
+    int height = 0;
+    int depth = 0;
+
+    // Maps stored values to modality values for the whole volume. Series
+    // whose slices disagree are stored as float modality values instead.
+    double slope = 1.0;
+    double intercept = 0.0;
+    double min_stored = 0.0;
+    double max_stored = 0.0;
+
+    // Voxel size in mm along columns (x), rows (y) and slices (z)
+    double spacing[3] = { 1.0, 1.0, 1.0 };
+    // Image Position (Patient) of the first slice
+    double origin[3] = { 0.0, 0.0, 0.0 };
+    // Patient-space directions of increasing column, row and slice index
+    double row_direction[3] = { 1.0, 0.0, 0.0 };
+    double column_direction[3] = { 0.0, 1.0, 0.0 };
+    double slice_direction[3] = { 0.0, 0.0, 1.0 };
+    // Whether slices were ordered by position rather than Instance Number
+    bool sorted_by_position = false;
+
+    // Header of the first slice (modality, VOI, UIDs)
+    SliceInfo info;
+    // Source files in stacking order
+    std::vector<std::string> slice_paths;
+
+    AlignedBuffer storage;
+
+    size_t get_slice_pixel_count() const { return size_t(width) * size_t(height); }
+    size_t get_slice_byte_size() const { return get_slice_pixel_count() * pixel_format_size(format); }
+    size_t get_byte_size() const { return storage.get_size(); }
+
+    const void *get_slice_data(int z) const {
+        return storage.data() + size_t(z) * get_slice_byte_size();
+    }
+
+    double get_min_value() const {
+        return slope >= 0.0 ? min_stored * slope + intercept : max_stored * slope + intercept;
+    }
+    double get_max_value() const {
+        return slope >= 0.0 ? max_stored * slope + intercept : min_stored * slope + intercept;
+    }
+
+    // Invoke `fn` with a typed `const T *` to the first voxel
+    template <typename Fn>
+    void visit(Fn &&fn) const {
+        visit_pixels(format, storage.data(), fn);
+    }
+
+    // Patient +Z is superior; reformatted planes put the head at the top,
+    // so their first row is the last slice when slices run upwards
+    bool is_superior_last() const { return slice_direction[2] > 0.0; }
+
+    // Copy slice `z` into `out` at the volume's native width
+    bool copy_slice(int z, PixelBuffer &out) const;
+};
+
+// Orthogonal planes through a volume. Named for the usual axial
+// acquisition: AXIAL is the acquired plane (fixed slice), CORONAL fixes a
+// row and SAGITTAL fixes a column.
+enum VolumeAxis {
+    VOLUME_AXIS_AXIAL,
+    VOLUME_AXIS_CORONAL,
+    VOLUME_AXIS_SAGITTAL,
+};
+
+// Number of planes along `axis`
+int get_plane_count(const Volume &volume, VolumeAxis axis);
+
+// Header for a plane along `axis`: the volume's info with the plane's size
+// and pixel spacing
+void make_plane_info(const Volume &volume, VolumeAxis axis, SliceInfo &info);
+
+// Reformat plane `index` along `axis` into `out`: pixels at the volume's
+// native width plus an info block with the plane's pixel spacing. Reformatted
+// planes run through the slices along their vertical axis, with the
+// patient's head at the top.
+bool extract_plane(const Volume &volume, VolumeAxis axis, int index, DecodedSlice &out);
+
+// Sort decoded slices into patient order and stack them into `volume`.
+// Slices are released from `slices` as soon as they have been copied.
+// Fails if they differ in size, Series Instance UID or orientation.
+bool build_volume(std::vector<std::shared_ptr<const DecodedSlice>> &slices, Volume &volume, std::string &error);
+
+// Decode `paths` (absolute filesystem paths) on the shared thread pool and
+// build a volume from them. Slices already in the slice cache are reused.
+bool load_volume(const std::vector<std::string> &paths, Volume &volume, std::string &error);
+
+} // namespace dicom
@@ -0,0 +1,98 @@
+#include "window_level.h"
+
+#include "window_simd.h"
+
+namespace dicom {
+
+WindowTransform make_window_transform(double center, double width, double slope, double intercept) {
+    double low = center - width * 0.5;
+    double high = center + width * 0.5;
+    double denom = high - low;
+    if (denom <= 0.0) denom = 1.0;
+    if (slope == 0.0) slope = 1.0;
+
+    // (stored * slope + intercept - low) * 255 / denom
+    //   == (stored - (low - intercept) / slope) * (255 * slope / denom)
+    WindowTransform transform;
+    transform.low = static_cast<float>((low - intercept) / slope);
+    transform.scale = static_cast<float>(255.0 * slope / denom);
+    return transform;
+}
+
+template <typename T>
+static void window_lut(const T *src, size_t count, const uint8_t *table, int64_t table_min, uint8_t *dst) {
+    // Indexing relative to table_min keeps signed types in range
+    for (size_t i = 0; i < count; ++i) {
+        dst[i] = table[static_cast<int64_t>(src[i]) - table_min];
+    }
+}
+
+void WindowEngine::reset() {
+    mode = WINDOW_MODE_NONE;
+    lut_valid = false;
+    std::vector<uint8_t>().swap(lut);
+}
+
+void WindowEngine::configure(const PixelBuffer &pixels, double center, double width) {
+    if (pixels.is_empty()) {
+        reset();
+        return;
+    }
+
+    transform = make_window_transform(center, width, pixels.get_slope(), pixels.get_intercept());
+
+    // 16-bit and float input converts, scales and packs faster in vector
+    // registers than a table gather when the CPU has a vector unit
+    const PixelFormat format = pixels.get_format();
+    if (get_simd_level() != SIMD_NONE &&
+            (format == PIXEL_FORMAT_S16 || format == PIXEL_FORMAT_U16 || format == PIXEL_FORMAT_F32)) {
+        mode = WINDOW_MODE_SIMD;
+        return;
+    }
+
+    // Integer data whose stored range fits the table goes through a LUT; the
+    // table is sized to the actual range, so 12-bit data needs 4096 entries.
+    const int64_t stored_min = static_cast<int64_t>(pixels.get_min_stored());
+    const int64_t stored_max = static_cast<int64_t>(pixels.get_max_stored());
+    const int64_t entries = stored_max - stored_min + 1;
+    if (format == PIXEL_FORMAT_F32 || entries <= 0 || entries > WINDOW_LUT_MAX_ENTRIES) {
+        mode = WINDOW_MODE_FLOAT;
+        return;
+    }
+
+    mode = WINDOW_MODE_LUT;
+    if (lut_valid && lut_min == stored_min && int64_t(lut.size()) == entries &&
+            lut_transform.low == transform.low && lut_transform.scale == transform.scale) {
+        return;
+    }
+
+    lut.resize(size_t(entries));
+    for (int64_t i = 0; i < entries; ++i) {
+        lut[size_t(i)] = window_value(static_cast<float>(stored_min + i), transform);
+    }
+    lut_min = stored_min;
+    lut_transform = transform;
+    lut_valid = true;
+}
+
+void WindowEngine::apply(const PixelBuffer &pixels, size_t first, size_t count, uint8_t *dst) const {
+    if (mode == WINDOW_MODE_NONE || first >= pixels.get_pixel_count()) {
+        return;
+    }
+    if (count > pixels.get_pixel_count() - first) {
+        count = pixels.get_pixel_count() - first;
+    }
+
+    pixels.visit([&](const auto *src) {
+        if (mode == WINDOW_MODE_SIMD && window_span_simd(src + first, count, transform, dst)) {
+            return;
+        }
+        if (mode == WINDOW_MODE_LUT) {
+            window_lut(src + first, count, lut.data(), lut_min, dst);
+        } else {
+            window_span_scalar(src + first, count, transform, dst);
+        }
+    });
+}
+
+} // namespace dicom
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "pixel_buffer.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace dicom {
+
+// Linear window/level expressed directly on stored values:
+// out = clamp((stored - low) * scale, 0, 255), truncated to 8 bits.
+// Rescale slope/intercept are folded in, so no rescaled copy is needed.
+struct WindowTransform {
+    float low = 0.0f;
+    float scale = 1.0f;
+};
+
+WindowTransform make_window_transform(double center, double width, double slope, double intercept);
+
+// Reference mapping of one value. Every windowing path (LUT, float loop)
+// goes through this, so they agree bit for bit.
+inline uint8_t window_value(float value, const WindowTransform &transform) {
+    float mapped = (value - transform.low) * transform.scale;
+    // Written so NaN maps to 0
+    if (!(mapped > 0.0f)) mapped = 0.0f;
+    if (mapped > 255.0f) mapped = 255.0f;
+    return static_cast<uint8_t>(mapped);
+}
+
+enum WindowMode {
+    WINDOW_MODE_NONE,
+    WINDOW_MODE_LUT, // table gather over the stored range
+    WINDOW_MODE_FLOAT, // per-pixel arithmetic
+    WINDOW_MODE_SIMD, // vectorised arithmetic (16-bit and float input)
+};
+
+// Largest stored range (max - min + 1) that is mapped through a lookup table
+static const int64_t WINDOW_LUT_MAX_ENTRIES = 65536;
+
+// Maps a PixelBuffer to 8-bit grey levels for a given window/level. configure()
+// picks the strategy and rebuilds the table when the window changes; apply()
+// is const and may be called concurrently on disjoint ranges.
+class WindowEngine {
+public:
+    void configure(const PixelBuffer &pixels, double center, double width);
+    void reset();
+
+    WindowMode get_mode() const { return mode; }
+    const WindowTransform &get_transform() const { return transform; }
+
+    // Window `count` pixels starting at linear index `first` into `dst`
+    void apply(const PixelBuffer &pixels, size_t first, size_t count, uint8_t *dst) const;
+
+private:
+    WindowMode mode = WINDOW_MODE_NONE;
+    WindowTransform transform;
+
+    // The table covers stored values [lut_min, lut_min + lut.size())
+    std::vector<uint8_t> lut;
+    int64_t lut_min = 0;
+    bool lut_valid = false;
+    WindowTransform lut_transform;
+};
+
+} // namespace dicom
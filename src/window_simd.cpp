@@ -0,0 +1,411 @@
+#include "window_simd.h"
+
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define DV_SIMD_X86
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define DV_TARGET_AVX2
+#else
+#define DV_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define DV_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+namespace dicom {
+
+// All kernels compute clamp((x - low) * scale, 0, 255) as a separate
+// subtract and multiply (no FMA) and truncate, exactly like window_value().
+// max(x, 0) is evaluated with the NaN-suppressing form on every ISA so NaN
+// lands on 0 as it does in the scalar path.
+
+#ifdef DV_SIMD_X86
+
+static inline __m128i window_ps_sse2(__m128 f, __m128 low, __m128 scale, __m128 zero, __m128 top) {
+    f = _mm_mul_ps(_mm_sub_ps(f, low), scale);
+    f = _mm_max_ps(f, zero); // returns `zero` when f is NaN
+    f = _mm_min_ps(f, top);
+    return _mm_cvttps_epi32(f);
+}
+
+template <bool Signed>
+static void window_16_sse2(const uint16_t *src, size_t count, const WindowTransform &transform, uint8_t *dst) {
+    const __m128 low = _mm_set1_ps(transform.low);
+    const __m128 scale = _mm_set1_ps(transform.scale);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 top = _mm_set1_ps(255.0f);
+    const __m128i zero_i = _mm_setzero_si128();
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i + 8));
+        __m128i a_lo, a_hi, b_lo, b_hi;
+        if (Signed) {
+            a_lo = _mm_srai_epi32(_mm_unpacklo_epi16(a, a), 16);
+            a_hi = _mm_srai_epi32(_mm_unpackhi_epi16(a, a), 16);
+            b_lo = _mm_srai_epi32(_mm_unpacklo_epi16(b, b), 16);
+            b_hi = _mm_srai_epi32(_mm_unpackhi_epi16(b, b), 16);
+        } else {
+            a_lo = _mm_unpacklo_epi16(a, zero_i);
+            a_hi = _mm_unpackhi_epi16(a, zero_i);
+            b_lo = _mm_unpacklo_epi16(b, zero_i);
+            b_hi = _mm_unpackhi_epi16(b, zero_i);
+        }
+        __m128i r0 = window_ps_sse2(_mm_cvtepi32_ps(a_lo), low, scale, zero, top);
+        __m128i r1 = window_ps_sse2(_mm_cvtepi32_ps(a_hi), low, scale, zero, top);
+        __m128i r2 = window_ps_sse2(_mm_cvtepi32_ps(b_lo), low, scale, zero, top);
+        __m128i r3 = window_ps_sse2(_mm_cvtepi32_ps(b_hi), low, scale, zero, top);
+        __m128i packed = _mm_packus_epi16(_mm_packs_epi32(r0, r1), _mm_packs_epi32(r2, r3));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), packed);
+    }
+    if (Signed) {
+        window_span_scalar(reinterpret_cast<const int16_t *>(src) + i, count - i, transform, dst + i);
+    } else {
+        window_span_scalar(src + i, count - i, transform, dst + i);
+    }
+}
+
+static void window_f32_sse2(const float *src, size_t count, const WindowTransform &transform, uint8_t *dst) {
+    const __m128 low = _mm_set1_ps(transform.low);
+    const __m128 scale = _mm_set1_ps(transform.scale);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 top = _mm_set1_ps(255.0f);
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m128i r0 = window_ps_sse2(_mm_loadu_ps(src + i), low, scale, zero, top);
+        __m128i r1 = window_ps_sse2(_mm_loadu_ps(src + i + 4), low, scale, zero, top);
+        __m128i r2 = window_ps_sse2(_mm_loadu_ps(src + i + 8), low, scale, zero, top);
+        __m128i r3 = window_ps_sse2(_mm_loadu_ps(src + i + 12), low, scale, zero, top);
+        __m128i packed = _mm_packus_epi16(_mm_packs_epi32(r0, r1), _mm_packs_epi32(r2, r3));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), packed);
+    }
+    window_span_scalar(src + i, count - i, transform, dst + i);
+}
+
+DV_TARGET_AVX2 static inline __m256i window_ps_avx2(__m256 f, __m256 low, __m256 scale, __m256 zero, __m256 top) {
+    f = _mm256_mul_ps(_mm256_sub_ps(f, low), scale);
+    f = _mm256_max_ps(f, zero); // returns `zero` when f is NaN
+    f = _mm256_min_ps(f, top);
+    return _mm256_cvttps_epi32(f);
+}
+
+// Packs 16 epi32 lanes (0..255) from two registers into 16 bytes in order
+DV_TARGET_AVX2 static inline __m128i pack_u8_avx2(__m256i a, __m256i b) {
+    // packs_epi32 interleaves the 128-bit lanes; restore element order
+    __m256i words = _mm256_permute4x64_epi64(_mm256_packs_epi32(a, b), 0xD8);
+    return _mm_packus_epi16(_mm256_castsi256_si128(words), _mm256_extracti128_si256(words, 1));
+}
+
+template <bool Signed>
+DV_TARGET_AVX2 static void window_16_avx2(const uint16_t *src, size_t count, const WindowTransform &transform, uint8_t *dst) {
+    const __m256 low = _mm256_set1_ps(transform.low);
+    const __m256 scale = _mm256_set1_ps(transform.scale);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 top = _mm256_set1_ps(255.0f);
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i + 8));
+        __m256i wa = Signed ? _mm256_cvtepi16_epi32(a) : _mm256_cvtepu16_epi32(a);
+        __m256i wb = Signed ? _mm256_cvtepi16_epi32(b) : _mm256_cvtepu16_epi32(b);
+        __m256i ra = window_ps_avx2(_mm256_cvtepi32_ps(wa), low, scale, zero, top);
+        __m256i rb = window_ps_avx2(_mm256_cvtepi32_ps(wb), low, scale, zero, top);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), pack_u8_avx2(ra, rb));
+    }
+    if (Signed) {
+        window_span_scalar(reinterpret_cast<const int16_t *>(src) + i, count - i, transform, dst + i);
+    } else {
+        window_span_scalar(src + i, count - i, transform, dst + i);
+    }
+}
+
+DV_TARGET_AVX2 static void window_f32_avx2(const float *src, size_t count, const WindowTransform &transform, uint8_t *dst) {
+    const __m256 low = _mm256_set1_ps(transform.low);
+    const __m256 scale = _mm256_set1_ps(transform.scale);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 top = _mm256_set1_ps(255.0f);
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256i ra = window_ps_avx2(_mm256_loadu_ps(src + i), low, scale, zero, top);
+        __m256i rb = window_ps_avx2(_mm256_loadu_ps(src + i + 8), low, scale, zero, top);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), pack_u8_avx2(ra, rb));
+    }
+    window_span_scalar(src + i, count - i, transform, dst + i);
+}
+
+static bool cpu_has_avx2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx) {
+        return false;
+    }
+    // The OS must save YMM state across context switches
+    if ((_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif // DV_SIMD_X86
+
+#ifdef DV_SIMD_NEON
+
+static inline uint32x4_t window_ps_neon(float32x4_t f, float32x4_t low, float32x4_t scale, float32x4_t zero, float32x4_t top) {
+    f = vmulq_f32(vsubq_f32(f, low), scale);
+    f = vmaxnmq_f32(f, zero); // maxNum: returns `zero` when f is NaN
+    f = vminq_f32(f, top);
+    return vcvtq_u32_f32(f);
+}
+
+static inline uint8x16_t pack_u8_neon(uint32x4_t r0, uint32x4_t r1, uint32x4_t r2, uint32x4_t r3) {
+    uint16x8_t lo = vcombine_u16(vmovn_u32(r0), vmovn_u32(r1));
+    uint16x8_t hi = vcombine_u16(vmovn_u32(r2), vmovn_u32(r3));
+    return vcombine_u8(vmovn_u16(lo), vmovn_u16(hi));
+}
+
+static void window_s16_neon(const int16_t *src, size_t count, const WindowTransform &transform, uint8_t *dst) {
+    const float32x4_t low = vdupq_n_f32(transform.low);
+    const float32x4_t scale = vdupq_n_f32(transform.scale);
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    const float32x4_t top = vdupq_n_f32(255.0f);
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        int16x8_t a = vld1q_s16(src + i);
+        int16x8_t b = vld1q_s16(src + i + 8);
+        uint32x4_t r0 = window_ps_neon(vcvtq_f32_s32(vmovl_s16(vget_low_s16(a))), low, scale, zero, top);
+        uint32x4_t r1 = window_ps_neon(vcvtq_f32_s32(vmovl_s16(vget_high_s16(a))), low, scale, zero, top);
+        uint32x4_t r2 = window_ps_neon(vcvtq_f32_s32(vmovl_s16(vget_low_s16(b))), low, scale, zero, top);
+        uint32x4_t r3 = window_ps_neon(vcvtq_f32_s32(vmovl_s16(vget_high_s16(b))), low, scale, zero, top);
+        vst1q_u8(dst + i, pack_u8_neon(r0, r1, r2, r3));
+    }
+    window_span_scalar(src + i, count - i, transform, dst + i);
+}
+
+static void window_u16_neon(const uint16_t *src, size_t count, const WindowTransform &transform, uint8_t *dst) {
+    const float32x4_t low = vdupq_n_f32(transform.low);
+    const float32x4_t scale = vdupq_n_f32(transform.scale);
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    const float32x4_t top = vdupq_n_f32(255.0f);
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        uint16x8_t a = vld1q_u16(src + i);
+        uint16x8_t b = vld1q_u16(src + i + 8);
+        uint32x4_t r0 = window_ps_neon(vcvtq_f32_u32(vmovl_u16(vget_low_u16(a))), low, scale, zero, top);
+        uint32x4_t r1 = window_ps_neon(vcvtq_f32_u32(vmovl_u16(vget_high_u16(a))), low, scale, zero, top);
+        uint32x4_t r2 = window_ps_neon(vcvtq_f32_u32(vmovl_u16(vget_low_u16(b))), low, scale, zero, top);
+        uint32x4_t r3 = window_ps_neon(vcvtq_f32_u32(vmovl_u16(vget_high_u16(b))), low, scale, zero, top);
+        vst1q_u8(dst + i, pack_u8_neon(r0, r1, r2, r3));
+    }
+    window_span_scalar(src + i, count - i, transform, dst + i);
+}
+
+static void window_f32_neon(const float *src, size_t count, const WindowTransform &transform, uint8_t *dst) {
+    const float32x4_t low = vdupq_n_f32(transform.low);
+    const float32x4_t scale = vdupq_n_f32(transform.scale);
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    const float32x4_t top = vdupq_n_f32(255.0f);
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        uint32x4_t r0 = window_ps_neon(vld1q_f32(src + i), low, scale, zero, top);
+        uint32x4_t r1 = window_ps_neon(vld1q_f32(src + i + 4), low, scale, zero, top);
+        uint32x4_t r2 = window_ps_neon(vld1q_f32(src + i + 8), low, scale, zero, top);
+        uint32x4_t r3 = window_ps_neon(vld1q_f32(src + i + 12), low, scale, zero, top);
+        vst1q_u8(dst + i, pack_u8_neon(r0, r1, r2, r3));
+    }
+    window_span_scalar(src + i, count - i, transform, dst + i);
+}
+
+#endif // DV_SIMD_NEON
+
+SimdLevel detect_simd_level() {
+#if defined(DV_SIMD_X86)
+    static const SimdLevel detected = cpu_has_avx2() ? SIMD_AVX2 : SIMD_SSE2;
+    return detected;
+#elif defined(DV_SIMD_NEON)
+    return SIMD_NEON;
+#else
+    return SIMD_NONE;
+#endif
+}
+
+static std::atomic<int> active_simd_level(-1);
+
+SimdLevel get_simd_level() {
+    int level = active_simd_level.load(std::memory_order_relaxed);
+    if (level < 0) {
+        level = detect_simd_level();
+        active_simd_level.store(level, std::memory_order_relaxed);
+    }
+    return static_cast<SimdLevel>(level);
+}
+
+void set_simd_level(SimdLevel level) {
+    const SimdLevel detected = detect_simd_level();
+    // Only allow stepping down within the family the CPU supports
+    if (level != SIMD_NONE && level != detected && !(detected == SIMD_AVX2 && level == SIMD_SSE2)) {
+        level = detected;
+    }
+    active_simd_level.store(level, std::memory_order_relaxed);
+}
+
+const char *get_simd_level_name(SimdLevel level) {
+    switch (level) {
+        case SIMD_SSE2:
+            return "sse2";
+        case SIMD_AVX2:
+            return "avx2";
+        case SIMD_NEON:
+            return "neon";
+        default:
+            return "scalar";
+    }
+}
+
+bool window_span_simd(const int16_t *src, size_t count, const WindowTransform &transform, uint8_t *dst) {
+    switch (get_simd_level()) {
+#ifdef DV_SIMD_X86
+        case SIMD_AVX2:
+            window_16_avx2<true>(reinterpret_cast<const uint16_t *>(src), count, transform, dst);
+            return true;
+        case SIMD_SSE2:
+            window_16_sse2<true>(reinterpret_cast<const uint16_t *>(src), count, transform, dst);
+            return true;
+#endif
+#ifdef DV_SIMD_NEON
+        case SIMD_NEON:
+            window_s16_neon(src, count, transform, dst);
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+bool window_span_simd(const uint16_t *src, size_t count, const WindowTransform &transform, uint8_t *dst) {
+    switch (get_simd_level()) {
+#ifdef DV_SIMD_X86
+        case SIMD_AVX2:
+            window_16_avx2<false>(src, count, transform, dst);
+            return true;
+        case SIMD_SSE2:
+            window_16_sse2<false>(src, count, transform, dst);
+            return true;
+#endif
+#ifdef DV_SIMD_NEON
+        case SIMD_NEON:
+            window_u16_neon(src, count, transform, dst);
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+bool window_span_simd(const float *src, size_t count, const WindowTransform &transform, uint8_t *dst) {
+    switch (get_simd_level()) {
+#ifdef DV_SIMD_X86
+        case SIMD_AVX2:
+            window_f32_avx2(src, count, transform, dst);
+            return true;
+        case SIMD_SSE2:
+            window_f32_sse2(src, count, transform, dst);
+            return true;
+#endif
+#ifdef DV_SIMD_NEON
+        case SIMD_NEON:
+            window_f32_neon(src, count, transform, dst);
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+template <typename T>
+static bool kernel_matches_reference(const std::vector<T> &input, const WindowTransform &transform) {
+    std::vector<uint8_t> expected(input.size() + 1);
+    std::vector<uint8_t> actual(input.size() + 1);
+    // Odd offsets exercise unaligned loads and the scalar tail
+    for (size_t offset = 0; offset < 3 && offset < input.size(); ++offset) {
+        const size_t count = input.size() - offset;
+        window_span_scalar(input.data() + offset, count, transform, expected.data());
+        if (!window_span_simd(input.data() + offset, count, transform, actual.data())) {
+            return true; // no vector path for this type, nothing to compare
+        }
+        if (std::memcmp(expected.data(), actual.data(), count) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool verify_window_kernels() {
+    const WindowTransform transforms[] = {
+        make_window_transform(40.0, 400.0, 1.0, -1024.0), // CT soft tissue
+        make_window_transform(-600.0, 1500.0, 1.0, -1024.0), // CT lung
+        make_window_transform(2000.0, 4000.0, 1.0, 0.0), // MG full range
+        make_window_transform(100.0, 1.0, 1.0, 0.0), // degenerate one-unit window
+        make_window_transform(0.0, 0.0, 1.0, 0.0), // zero width
+        make_window_transform(500.0, 1000.0, -2.5, 300.0), // inverted slope
+        make_window_transform(0.5, 1e-6, 1e-3, 0.0), // huge gain
+    };
+
+    std::vector<int16_t> s16(65536);
+    std::vector<uint16_t> u16(65536);
+    for (int i = 0; i < 65536; ++i) {
+        s16[size_t(i)] = static_cast<int16_t>(i - 32768);
+        u16[size_t(i)] = static_cast<uint16_t>(i);
+    }
+
+    std::vector<float> f32;
+    const float specials[] = {
+        0.0f, -0.0f, 1.0f, -1.0f, 0.5f, 254.999f, 255.0f, 255.5f, 1e-30f, -1e-30f,
+        std::numeric_limits<float>::denorm_min(), -std::numeric_limits<float>::denorm_min(),
+        std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest(),
+        std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity(),
+        std::numeric_limits<float>::quiet_NaN(),
+    };
+    for (float v : specials) {
+        f32.push_back(v);
+    }
+    for (int i = -40000; i <= 40000; i += 7) {
+        f32.push_back(static_cast<float>(i) * 0.37f);
+    }
+
+    for (const WindowTransform &transform : transforms) {
+        if (!kernel_matches_reference(s16, transform) ||
+                !kernel_matches_reference(u16, transform) ||
+                !kernel_matches_reference(f32, transform)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace dicom
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "window_level.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace dicom {
+
+// Instruction sets the windowing kernels can use, best last
+enum SimdLevel {
+    SIMD_NONE,
+    SIMD_SSE2,
+    SIMD_AVX2,
+    SIMD_NEON,
+};
+
+// Best level supported by this CPU, detected once
+SimdLevel detect_simd_level();
+
+// Level currently used by the kernels. Defaults to detect_simd_level();
+// set_simd_level() can lower it (e.g. SIMD_NONE to force the scalar path)
+// but never raise it above what the CPU supports.
+SimdLevel get_simd_level();
+void set_simd_level(SimdLevel level);
+const char *get_simd_level_name(SimdLevel level);
+
+// Vectorised equivalents of window_value() over `count` pixels. They return
+// false without touching `dst` when no vector path is active for the type.
+bool window_span_simd(const int16_t *src, size_t count, const WindowTransform &transform, uint8_t *dst);
+bool window_span_simd(const uint16_t *src, size_t count, const WindowTransform &transform, uint8_t *dst);
+bool window_span_simd(const float *src, size_t count, const WindowTransform &transform, uint8_t *dst);
+
+template <typename T>
+inline bool window_span_simd(const T *, size_t, const WindowTransform &, uint8_t *) {
+    return false;
+}
+
+// Scalar reference the vector kernels must match
+template <typename T>
+inline void window_span_scalar(const T *src, size_t count, const WindowTransform &transform, uint8_t *dst) {
+    for (size_t i = 0; i < count; ++i) {
+        dst[i] = window_value(static_cast<float>(src[i]), transform);
+    }
+}
+
+// Run every vector kernel available at the current level against the
+// scalar reference over all 16-bit inputs and float edge cases (NaN, inf,
+// denormals) and unaligned heads/tails. Returns false on the first byte
+// that differs.
+bool verify_window_kernels();
+
+} // namespace dicom